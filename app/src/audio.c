@@ -1,7 +1,11 @@
 #include <zephyr/kernel.h>
 #include <zephyr/audio/codec.h>
 #include <zephyr/drivers/i2s.h>
+#include <app/drivers/timebase.h>
+#include <app/lib/audio_health.h>
+#include <app/lib/audio_pipe.h>
 #include "max9867.h"
+#include "audio.h"
 
 #include <zephyr/logging/log.h>
 
@@ -12,12 +16,22 @@ LOG_MODULE_REGISTER(audio, LOG_LEVEL_INF);
 
 #define I2S_DEV_NODE_RX DT_NODELABEL(sai1)
 
+#define BRD_REV_62_2 /* Replace with board config from ENG-37*/
+
 
-/* TODO: Think about this when considering system architecture  */
-#define NUM_BLOCKS 20
-#define SAMPLE_NO 64
+/* 16 bit stereo, slab blocks sized for the longest block the profile allows */
+#define FRAME_BYTES 4
+#define BLOCK_FRAMES(ms) (SAMPLE_RATE * (ms) / MSEC_PER_SEC)
+#define BLOCK_SIZE (BLOCK_FRAMES(CONFIG_AUDIO_BLOCK_MS) * FRAME_BYTES)
+#define SLAB_BLOCKS DIV_ROUND_UP(CONFIG_AUDIO_BUFFER_MS, CONFIG_AUDIO_BLOCK_MS)
 
-#define BLOCK_SIZE (2 * SAMPLE_NO)
+BUILD_ASSERT(SLAB_BLOCKS > CONFIG_DMA_TCD_QUEUE_SIZE + 1,
+             "Buffer too short for the DMA chain and one block for the consumers");
+#ifdef CONFIG_AUDIO_VAD
+BUILD_ASSERT(BLOCK_SIZE <= CONFIG_AUDIO_VAD_BLOCK_BYTES,
+             "Blocks longer than the activity detector's pre-roll slots, raise "
+             "CONFIG_AUDIO_VAD_BLOCK_BYTES");
+#endif
 
 #ifdef CONFIG_NOCACHE_MEMORY
 	#define MEM_SLAB_CACHE_ATTR __nocache
@@ -25,100 +39,249 @@ LOG_MODULE_REGISTER(audio, LOG_LEVEL_INF);
 	#define MEM_SLAB_CACHE_ATTR
 #endif
 
+#ifdef CONFIG_AUDIO_SLAB_IN_SECTION
+	#define MEM_SLAB_SECTION_ATTR Z_GENERIC_SECTION(CONFIG_AUDIO_SLAB_SECTION)
+#else
+	#define MEM_SLAB_SECTION_ATTR
+#endif
 
-char MEM_SLAB_CACHE_ATTR __aligned(WB_UP(32))
-	_k_mem_slab_buf_rx_0_mem_slab[(NUM_BLOCKS + 2) * WB_UP(BLOCK_SIZE)];
+char MEM_SLAB_CACHE_ATTR MEM_SLAB_SECTION_ATTR __aligned(WB_UP(32))
+	_k_mem_slab_buf_rx_0_mem_slab[SLAB_BLOCKS * WB_UP(BLOCK_SIZE)];
 STRUCT_SECTION_ITERABLE(k_mem_slab, rx_0_mem_slab) =
 	Z_MEM_SLAB_INITIALIZER(rx_0_mem_slab, _k_mem_slab_buf_rx_0_mem_slab,
-				WB_UP(BLOCK_SIZE), NUM_BLOCKS + 2);
+				WB_UP(BLOCK_SIZE), SLAB_BLOCKS);
 
+/* Consumers never hold the blocks the DMA chain needs, a slow consumer loses its oldest
+ * queued blocks instead of stalling capture */
+AUDIO_PIPE_DEFINE(capture_pipe, rx_0_mem_slab, SLAB_BLOCKS - CONFIG_DMA_TCD_QUEUE_SIZE);
 
 
 #define RX_THREAD_STACK_SIZE 1024
 #define RX_THREAD_PRIORITY 4
+/* Between attempts to restart a stream that will not start */
+#define RESTART_BACKOFF_MS 100
+/* Between warnings about blocks the consumers had no room for, capture_pipe.dropped counts
+ * every one */
+#define DROP_LOG_INTERVAL_MS 1000
 
 static struct k_thread rx_thread_data;
 K_THREAD_STACK_DEFINE(rx_thread_stack, RX_THREAD_STACK_SIZE);
 
+static struct audio_health health;
+static struct i2s_config i2s_cfg_rx;
+/* Block length in use, written only by the RX thread once capture runs */
+static uint32_t block_ms = CONFIG_AUDIO_BLOCK_MS;
+/* Block length audio_set_block_ms() asked for, 0 once applied */
+static atomic_t requested_block_ms;
+/* Set by the shell, the RX thread clears the stats between blocks */
+static atomic_t requested_reset;
+
+#ifdef BRD_REV_62_2
+static void check_tx_underrun(void);
+#endif
+
+struct audio_pipe *audio_capture_pipe(void)
+{
+    return &capture_pipe;
+}
+
+const struct audio_health *audio_stats(void)
+{
+    return &health;
+}
+
+int audio_stats_record(uint8_t *buf, size_t size)
+{
+    return audio_health_encode(&health, buf, size);
+}
+
+static uint64_t now_us(void)
+{
+    return timebase_ticks_to_ns(timebase_now()) / NSEC_PER_USEC;
+}
+
+int audio_set_block_ms(uint32_t ms)
+{
+    if (ms == 0 || ms > CONFIG_AUDIO_BLOCK_MS) {
+        return -EINVAL;
+    }
+
+    atomic_set(&requested_block_ms, ms);
+    return 0;
+}
+
+/* From an overrun or any other error back to capturing. DROP leaves the error state
+ * on most drivers, PREPARE is the documented way out of it. */
+static int restart_rx(const struct device *dev_i2s)
+{
+    int ret = i2s_trigger(dev_i2s, I2S_DIR_RX, I2S_TRIGGER_DROP);
+
+    if (ret < 0) {
+        ret = i2s_trigger(dev_i2s, I2S_DIR_RX, I2S_TRIGGER_PREPARE);
+        if (ret < 0) {
+            return ret;
+        }
+    }
+
+    audio_health_start(&health, now_us());
+    return i2s_trigger(dev_i2s, I2S_DIR_RX, I2S_TRIGGER_START);
+}
+
+/* Shorter blocks still come from the same slab, each uses the start of a slab block. If the
+ * new length does not take, capture goes back to the old one */
+static int set_rx_block_ms(const struct device *dev_i2s, uint32_t ms)
+{
+    int ret = i2s_trigger(dev_i2s, I2S_DIR_RX, I2S_TRIGGER_DROP);
+
+    if (ret < 0) {
+        return ret;
+    }
+
+    i2s_cfg_rx.block_size = BLOCK_FRAMES(ms) * FRAME_BYTES;
+    ret = i2s_configure(dev_i2s, I2S_DIR_RX, &i2s_cfg_rx);
+    if (ret == 0) {
+        health.block_us = ms * USEC_PER_MSEC;
+        audio_health_start(&health, now_us());
+        ret = i2s_trigger(dev_i2s, I2S_DIR_RX, I2S_TRIGGER_START);
+    }
+
+    if (ret == 0) {
+        block_ms = ms;
+        return 0;
+    }
+
+    /* A failed restore leaves RX stopped, the next read fails and the thread's restart
+     * loop takes over */
+    health.block_us = block_ms * USEC_PER_MSEC;
+    i2s_cfg_rx.block_size = BLOCK_FRAMES(block_ms) * FRAME_BYTES;
+    if (i2s_configure(dev_i2s, I2S_DIR_RX, &i2s_cfg_rx) == 0) {
+        restart_rx(dev_i2s);
+    }
+    return ret;
+}
+
+/* Hands each block to the consumers as the DMA filled it, the last consumer to release it
+ * returns it to rx_0_mem_slab */
 void rx_thread_func(void *p1, void *p2, void *p3)
 {
     const struct device *dev_i2s = (const struct device *)p1;
     void *rx_block;
     size_t rx_size;
+    uint32_t drop_logged_ms = k_uptime_get_32() - DROP_LOG_INTERVAL_MS;
     int ret;
     
     LOG_INF("SAI RX thread started");
     
     while(1)
     {
+        uint32_t ms = atomic_clear(&requested_block_ms);
+
+        if (ms != 0 && ms != block_ms)
+        {
+            ret = set_rx_block_ms(dev_i2s, ms);
+            if (ret < 0)
+            {
+                LOG_ERR("Failed to switch to %u ms audio blocks (%d), staying at %u ms", ms,
+                        ret, block_ms);
+            }
+            else
+            {
+                LOG_INF("%u ms audio blocks", ms);
+            }
+        }
+
+        if (atomic_clear(&requested_reset))
+        {
+            audio_health_init(&health, block_ms * USEC_PER_MSEC);
+            audio_health_start(&health, now_us());
+        }
+
         ret = i2s_read(dev_i2s, &rx_block, &rx_size);
         if (ret < 0)
         {
-            LOG_ERR("Failed to read I2S RX stream (%d)", ret);
-            return;
+            audio_health_error(&health, ret);
+            LOG_WRN("Failed to read I2S RX stream (%d), restarting", ret);
+
+            while ((ret = restart_rx(dev_i2s)) < 0)
+            {
+                LOG_ERR("Failed to restart I2S RX stream (%d)", ret);
+                k_msleep(RESTART_BACKOFF_MS);
+            }
+            health.restarts++;
+            continue;
         }
 
-        k_mem_slab_free(&rx_0_mem_slab, rx_block);
+        /* Whatever the consumers do not hold, and not this block, is the driver's, in the DMA
+         * chain or waiting to be read */
+        uint16_t slab_used = k_mem_slab_num_used_get(&rx_0_mem_slab);
+        uint16_t held = k_mem_slab_num_used_get(capture_pipe.descs);
+
+        audio_health_block(&health, now_us(), slab_used, slab_used - held - 1);
+#ifdef BRD_REV_62_2
+        check_tx_underrun();
+#endif
+
+        ret = audio_pipe_publish(&capture_pipe, rx_block, rx_size, timebase_now());
+        if (ret == -ENOMEM && k_uptime_get_32() - drop_logged_ms >= DROP_LOG_INTERVAL_MS)
+        {
+            drop_logged_ms = k_uptime_get_32();
+            LOG_WRN("Audio blocks dropped, consumers hold every block (%d so far)",
+                    (int)atomic_get(&capture_pipe.dropped));
+        }
     }
 }
 
-#define BRD_REV_62_2 /* Replace with board config from ENG-37*/
 #ifdef BRD_REV_62_2
 
-#define TX_THREAD_STACK_SIZE 1024
-#define TX_THREAD_PRIORITY 5
-
-/* TX memory slab for outgoing audio data */
-char MEM_SLAB_CACHE_ATTR __aligned(WB_UP(32))
-        _k_mem_slab_buf_tx_0_mem_slab[NUM_BLOCKS * WB_UP(BLOCK_SIZE)];
-STRUCT_SECTION_ITERABLE(k_mem_slab, tx_0_mem_slab) =
-        Z_MEM_SLAB_INITIALIZER(tx_0_mem_slab, _k_mem_slab_buf_tx_0_mem_slab,
-                               WB_UP(BLOCK_SIZE), NUM_BLOCKS);
+#include <zephyr/drivers/dma.h>
+#include <fsl_edma.h>
+#include <fsl_sai.h>
 
+BUILD_ASSERT(DT_DMAS_HAS_NAME(I2S_DEV_NODE_RX, tx), "SAI TX needs a DMA request");
 
-static struct k_thread tx_thread_data;
-K_THREAD_STACK_DEFINE(tx_thread_stack, TX_THREAD_STACK_SIZE);
+#define SAI_TX_DMA_NODE DT_DMAS_CTLR_BY_NAME(I2S_DEV_NODE_RX, tx)
+#define SAI_TX_DMA_CHANNEL DT_DMAS_CELL_BY_NAME(I2S_DEV_NODE_RX, tx, mux)
+#define SAI_TX_DMA_SOURCE DT_DMAS_CELL_BY_NAME(I2S_DEV_NODE_RX, tx, source)
 
 /* We are currently using the SAI TX clocks because that is how the hardware is wired.
- * Even when operating synchronously(slave to RX), It seems that the TX section will
- * only generate frame sync when the FIFO is non-empty hence we have this thread filling
- * The TX FIFO continuously.
- * See DS: 67.6.1.8 - TCR4:ONDEM description
+ * Even when operating synchronously(slave to RX), the TX section only generates frame
+ * sync while its FIFO is non-empty, see DS: 67.6.1.8 - TCR4:ONDEM description.
+ * Rather than a thread writing zero blocks through the I2S driver, the TX DMA request
+ * channel replays this one word into TDR0 for ever: source and destination offsets are
+ * zero, the major loop reloads itself from BITER and auto stop is off so the request
+ * stays enabled. No interrupts, no slab, no CPU once started.
  * This will be dropped with the next board rev. */
-void tx_thread_func(void *p1, void *p2, void *p3)
+static uint32_t tx_silence;
+static I2S_Type *const sai = (I2S_Type *)DT_REG_ADDR(I2S_DEV_NODE_RX);
+
+/* i2s_configure() wants a slab for TX although the stream is never triggered. It gets a
+ * one block slab of its own, so nothing through the driver can take capture blocks. */
+K_MEM_SLAB_DEFINE_STATIC(tx_0_mem_slab, WB_UP(BLOCK_SIZE), 1, 32);
+
+/* The looping DMA should never let the FIFO run dry, if it does frame sync stops */
+static void check_tx_underrun(void)
 {
-    const struct device *dev_i2s = (const struct device *)p1;
-    void *tx_block;
-    int ret;
-    
-    LOG_INF("TX thread started");
-    
-    while(1)
-    {
-        ret = k_mem_slab_alloc(&tx_0_mem_slab, &tx_block, K_MSEC(100));
-        if (ret == 0)
-        {
-            ret = i2s_write(dev_i2s, tx_block, BLOCK_SIZE);
-            if (ret < 0)
-            {
-                LOG_ERR("Failed to write TX buffer (%d)", ret);
-                k_mem_slab_free(&tx_0_mem_slab, tx_block);
-            }
-        }
-        else
-        {
-            LOG_ERR("Failed to allocate TX buffer (%d)", ret);
-            k_sleep(K_MSEC(100));
-        }
+    if (SAI_TxGetStatusFlag(sai) & kSAI_FIFOErrorFlag) {
+        SAI_TxClearStatusFlags(sai, kSAI_FIFOErrorFlag);
+        health.tx_underruns++;
     }
 }
 
 static int configure_and_start_tx(const struct device *dev_i2s)
 {
+    const struct device *dma_dev = DEVICE_DT_GET(SAI_TX_DMA_NODE);
+    DMA_Type *const edma = (DMA_Type *)DT_REG_ADDR(SAI_TX_DMA_NODE);
+    int channel = SAI_TX_DMA_CHANNEL;
     struct i2s_config i2s_cfg_tx;
-    void *tx_block;
+    edma_transfer_config_t transfer;
     int ret;
 
+    if (!device_is_ready(dma_dev)) {
+        LOG_ERR("SAI TX DMA not ready");
+        return -ENODEV;
+    }
+
+    /* Only sets up the TX clocking and format, TX is never triggered through the driver */
     i2s_cfg_tx.word_size = 16U;
     i2s_cfg_tx.channels = 2U;
     i2s_cfg_tx.format = I2S_FMT_DATA_FORMAT_I2S;
@@ -134,33 +297,26 @@ static int configure_and_start_tx(const struct device *dev_i2s)
         return ret;
     }
 
-    ret = k_mem_slab_alloc(&tx_0_mem_slab, &tx_block, K_NO_WAIT);
-    if (ret != 0) {
-        LOG_ERR("Failed to allocate TX buffer (%d)", ret);
-        return ret;
-    }
-
-    ret = i2s_write(dev_i2s, tx_block, BLOCK_SIZE);
-    if (ret < 0) {
-        LOG_ERR("Failed to write initial TX buffer (%d)", ret);
-        k_mem_slab_free(&tx_0_mem_slab, tx_block);
-        return ret;
+    /* Keep the DMA driver from handing the channel to anyone else */
+    ret = dma_request_channel(dma_dev, &channel);
+    if (ret != SAI_TX_DMA_CHANNEL) {
+        LOG_ERR("SAI TX DMA channel %d in use (%d)", SAI_TX_DMA_CHANNEL, ret);
+        return -EBUSY;
     }
 
-    ret = i2s_trigger(dev_i2s, I2S_DIR_TX, I2S_TRIGGER_START);
-    if (ret < 0) {
-        LOG_ERR("Failed to start I2S TX stream (%d)", ret);
-        return ret;
-    }
+    EDMA_ResetChannel(edma, SAI_TX_DMA_CHANNEL);
+    EDMA_SetChannelMux(edma, SAI_TX_DMA_CHANNEL, SAI_TX_DMA_SOURCE);
+    EDMA_PrepareTransferConfig(&transfer, &tx_silence, sizeof(tx_silence), 0,
+                               (void *)SAI_TxGetDataRegisterAddress(sai, 0), sizeof(tx_silence), 0,
+                               sizeof(tx_silence), sizeof(tx_silence));
+    EDMA_SetTransferConfig(edma, SAI_TX_DMA_CHANNEL, &transfer, NULL);
+    EDMA_EnableAutoStopRequest(edma, SAI_TX_DMA_CHANNEL, false);
+    EDMA_EnableChannelRequest(edma, SAI_TX_DMA_CHANNEL);
 
-    LOG_INF("TX stream started");
-
-    k_thread_create(&tx_thread_data, tx_thread_stack,
-                    K_THREAD_STACK_SIZEOF(tx_thread_stack),
-                    tx_thread_func,
-                    (void *)dev_i2s, NULL, NULL,
-                    TX_THREAD_PRIORITY, 0, K_NO_WAIT);
+    SAI_TxEnableDMA(sai, kSAI_FIFORequestDMAEnable, true);
+    SAI_TxEnable(sai, true);
 
+    LOG_INF("TX silence running on DMA channel %d", SAI_TX_DMA_CHANNEL);
     return 0;
 }
 #endif
@@ -168,7 +324,6 @@ static int configure_and_start_tx(const struct device *dev_i2s)
 int init_i2s(void)
 {
     static const struct device *dev_i2s = DEVICE_DT_GET_OR_NULL(I2S_DEV_NODE_RX);
-    struct i2s_config i2s_cfg_rx;
     int ret;
     
     if (!device_is_ready(dev_i2s)) {
@@ -209,6 +364,9 @@ int init_i2s(void)
 #endif
 
 
+    audio_health_init(&health, block_ms * USEC_PER_MSEC);
+    audio_health_start(&health, now_us());
+
     ret = i2s_trigger(dev_i2s, I2S_DIR_RX, I2S_TRIGGER_START);
     if (ret < 0) {
         LOG_ERR("Failed to start I2S RX stream (%d)", ret);
@@ -222,7 +380,7 @@ int init_i2s(void)
                     (void *)dev_i2s, NULL, NULL,
                     RX_THREAD_PRIORITY, 0, K_NO_WAIT);
 
-    LOG_INF("Audio system initialized - RX and TX threads running");
+    LOG_INF("Audio system initialized - RX thread running");
     return 0;
 
 }
@@ -287,3 +445,51 @@ int init_audio(void) {
     return 0;
 }
 
+
+#ifdef CONFIG_SHELL
+#include <zephyr/shell/shell.h>
+
+static int cmd_audio_stats(const struct shell *sh, size_t argc, char **argv)
+{
+    const struct audio_pipe_consumer *consumer;
+
+    shell_print(sh, "blocks %u, restarts %u", health.blocks, health.restarts);
+    shell_print(sh, "rx overruns %u, rx errors %u, tx underruns %u", health.rx_overruns,
+                health.rx_errors, health.tx_underruns);
+    shell_print(sh, "slab %u of %u at most, pipe dropped %d", health.slab_used_max,
+                SLAB_BLOCKS, (int)atomic_get(&capture_pipe.dropped));
+
+    shell_print(sh, "latency, max %u us", health.latency_max_us);
+    for (int i = 0; i < AUDIO_HEALTH_LATENCY_BINS; i++) {
+        uint32_t edge = (i == 0) ? 0 : AUDIO_HEALTH_LATENCY_BIN0_US << (i - 1);
+
+        shell_print(sh, "  >= %5u us: %u", edge, health.latency[i]);
+    }
+
+    shell_print(sh, "driver blocks at read");
+    for (int i = 0; i < AUDIO_HEALTH_QUEUE_BINS; i++) {
+        shell_print(sh, "  %d%s: %u", i, (i == AUDIO_HEALTH_QUEUE_BINS - 1) ? "+" : "",
+                    health.dma_queued[i]);
+    }
+
+    SYS_SLIST_FOR_EACH_CONTAINER(&capture_pipe.consumers, consumer, node) {
+        shell_print(sh, "consumer %p: dropped %d, lagged %d blocks", consumer,
+                    (int)atomic_get(&consumer->dropped), (int)atomic_get(&consumer->max_queued));
+    }
+    return 0;
+}
+
+static int cmd_audio_reset(const struct shell *sh, size_t argc, char **argv)
+{
+    /* Applied by the RX thread, which is the one updating health */
+    atomic_set(&requested_reset, 1);
+    atomic_clear(&capture_pipe.dropped);
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(audio_cmds,
+    SHELL_CMD(stats, NULL, "Capture stream health", cmd_audio_stats),
+    SHELL_CMD(reset, NULL, "Clear the stats", cmd_audio_reset),
+    SHELL_SUBCMD_SET_END);
+SHELL_CMD_REGISTER(audio, &audio_cmds, "Audio capture", NULL);
+#endif
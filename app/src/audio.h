@@ -1,3 +1,20 @@
 #pragma once
 
+#include <app/lib/audio_health.h>
+#include <app/lib/audio_pipe.h>
+
 int init_audio(void);
+
+/* Captured blocks, 16 bit stereo at 8 kHz, CONFIG_AUDIO_BLOCK_MS long unless shortened.
+ * Register consumers before init_audio() */
+struct audio_pipe *audio_capture_pipe(void);
+
+/* Capture stream health, also under the "audio stats" shell command */
+const struct audio_health *audio_stats(void);
+
+/* The stats as a binary record, see audio_health_encode() */
+int audio_stats_record(uint8_t *buf, size_t size);
+
+/* Shorter blocks than CONFIG_AUDIO_BLOCK_MS, e.g. while streaming live. Takes effect with the
+ * next block, -EINVAL beyond the slab's block length */
+int audio_set_block_ms(uint32_t ms);
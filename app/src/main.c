@@ -14,6 +14,7 @@
 #include "fuel_gauge.h"
 #include "als.h"
 #include "audio.h"
+#include "sound_events.h"
 
 LOG_MODULE_REGISTER(main, CONFIG_APP_LOG_LEVEL);
 
@@ -32,6 +33,9 @@ int main(void) {
     init_fuel_gauge();
     init_modem();
     init_als();
+#ifdef CONFIG_AUDIO_CLS
+    init_sound_events();
+#endif
     init_audio();
 
     LOG_INF("Init complete");
@@ -0,0 +1,120 @@
+#include <zephyr/kernel.h>
+#include <app/drivers/timebase.h>
+#include <app/lib/audio_cls.h>
+#include <app/lib/audio_feat.h>
+#include "audio.h"
+#include "sound_events.h"
+
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(sound_events, LOG_LEVEL_INF);
+
+#define SAMPLE_RATE 8000
+#define CHANNELS    2
+#define FRAME_BYTES 4
+
+/* Segments per inference run. The thread still wakes for every block to compute features,
+ * the classifier runs every 320 ms. */
+#define BATCH 4
+
+/* Blocks the thread may fall behind before it loses the oldest, it runs last of all */
+#define QUEUE_DEPTH 8
+
+#define EVENTS_THREAD_STACK_SIZE 2048
+#define EVENTS_THREAD_PRIORITY K_LOWEST_APPLICATION_THREAD_PRIO
+
+AUDIO_PIPE_CONSUMER_DEFINE_OVERRUN(events_consumer, QUEUE_DEPTH, AUDIO_PIPE_DROP_OLDEST);
+
+static struct k_thread events_thread_data;
+K_THREAD_STACK_DEFINE(events_thread_stack, EVENTS_THREAD_STACK_SIZE);
+
+static struct audio_feat feat;
+static struct audio_cls cls;
+
+static void event_sink(enum audio_cls_class c, uint64_t timestamp, int32_t score,
+                       void *user_data)
+{
+    LOG_INF("%s at %llu ms, score %d", (c == AUDIO_CLS_COUGH) ? "Cough" : "Snore",
+            timebase_ticks_to_ns(timestamp) / NSEC_PER_MSEC, score);
+}
+
+/* Batches of segments are run as soon as they are ready, in this thread */
+static void feat_sink(const int16_t *f, uint8_t n_feat, uint64_t timestamp, void *user_data)
+{
+    if (audio_cls_push(&cls, f, n_feat, timestamp)) {
+        audio_cls_run(&cls);
+    }
+}
+
+static void events_thread_func(void *p1, void *p2, void *p3)
+{
+    const uint32_t ticks_per_frame = timebase_freq_hz() / SAMPLE_RATE;
+    uint32_t next_seq = 0;
+
+    while (1)
+    {
+        struct audio_block *block = audio_pipe_get(&events_consumer, K_FOREVER);
+        size_t n_frames = block->size / FRAME_BYTES;
+
+        /* Windows and segments never span a gap */
+        if (block->seq != next_seq)
+        {
+            audio_feat_reset(&feat);
+            audio_cls_reset(&cls);
+        }
+        next_seq = block->seq + 1;
+
+        /* Blocks are stamped when read, the features want the first frame's time */
+        audio_feat_process(&feat, block->data, n_frames,
+                           block->timestamp - (uint64_t)n_frames * ticks_per_frame);
+        audio_pipe_release(block);
+    }
+}
+
+int init_sound_events(void)
+{
+    static const struct audio_feat_config feat_cfg = AUDIO_FEAT_CONFIG_DEFAULT;
+    int ret;
+
+    ret = audio_feat_init(&feat, SAMPLE_RATE, timebase_freq_hz(), CHANNELS, &feat_cfg,
+                          feat_sink, NULL);
+    if (ret < 0) {
+        LOG_ERR("Failed to set up features (%d)", ret);
+        return ret;
+    }
+
+    ret = audio_cls_init(&cls, &audio_cls_default_model, BATCH, event_sink, NULL);
+    if (ret < 0) {
+        LOG_ERR("Failed to set up classifier (%d)", ret);
+        return ret;
+    }
+
+    audio_pipe_register(audio_capture_pipe(), &events_consumer);
+
+    k_thread_create(&events_thread_data, events_thread_stack,
+                    K_THREAD_STACK_SIZEOF(events_thread_stack),
+                    events_thread_func, NULL, NULL, NULL,
+                    EVENTS_THREAD_PRIORITY, 0, K_NO_WAIT);
+
+    LOG_INF("Sound event detection running");
+    return 0;
+}
+
+
+#ifdef CONFIG_SHELL
+#include <zephyr/shell/shell.h>
+
+static int cmd_sound_stats(const struct shell *sh, size_t argc, char **argv)
+{
+    shell_print(sh, "coughs %u, snores %u", cls.events[AUDIO_CLS_COUGH],
+                cls.events[AUDIO_CLS_SNORE]);
+    shell_print(sh, "inferences %u, segments skipped %u, blocks dropped %d", cls.inferences,
+                cls.skipped, (int)atomic_get(&events_consumer.dropped));
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sound_cmds,
+    SHELL_CMD(stats, NULL, "Events detected", cmd_sound_stats),
+    SHELL_SUBCMD_SET_END);
+SHELL_CMD_REGISTER(sound, &sound_cmds, "Sound event detection", NULL);
+#endif
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Cough and snore detection on the capture stream. Registers with the capture pipe, so call
+ * before init_audio() */
+int init_sound_events(void);
@@ -7,7 +7,9 @@
 #include <zephyr/sys/byteorder.h>
 #include <zephyr/sys/util.h>
 
+#include <app/drivers/ads1298.h>
 #include "ads1298.h"
+#include "ads1298_utils.h"
 
 #include <zephyr/logging/log.h>
 //LOG_MODULE_REGISTER(ADS1298, CONFIG_SENSOR_LOG_LEVEL);
@@ -26,95 +28,33 @@ LOG_MODULE_REGISTER(ADS1298, LOG_LEVEL_DBG);
 /* THis is ~50kHz with boot settings */
 /* SPI clock max = 20MHz (tsclk>50ns) */
 /* For multibyte commands, a 4 tCLK period must separate the end of one byte (or opcode) and the next. */
+/* 9.5.2.9 Rather than a per word delay on the whole bus, commands are sent at an SCLK where one byte
+ * already takes longer than tSDECODE (8 / 4MHz = 2us > 1.96us) and RDATAC frames, which have no
+ * opcode, are read at the full DT spi-max-frequency. */
+#define ADS1298_CMD_SCLK_HZ 4000000
 
-#define EXG_CLKSEL DT_ALIAS(exg_clksel)
-static const struct gpio_dt_spec exg_clksel = GPIO_DT_SPEC_GET(EXG_CLKSEL, gpios);
-#define EXG_NRST DT_ALIAS(exg_nrst)
-static const struct gpio_dt_spec exg_nrst = GPIO_DT_SPEC_GET(EXG_NRST, gpios);
-#define EXG_NPWDN DT_ALIAS(exg_npwdn)
-static const struct gpio_dt_spec exg_npwdn = GPIO_DT_SPEC_GET(EXG_NPWDN, gpios);
-#define EXG_START_CONV DT_ALIAS(exg_start_conv)
-static const struct gpio_dt_spec exg_start_conv = GPIO_DT_SPEC_GET(EXG_START_CONV, gpios);
-
-
-#define SPI_BUF_SIZE 18
-static __aligned(32) char spi_buffer_tx[SPI_BUF_SIZE] __used;
-static __aligned(32) char spi_buffer_rx[SPI_BUF_SIZE] __used;
-
-#define ADS1298_CMD_WAKEUP 0x02
-#define ADS1298_CMD_STANDBY 0x04
-#define ADS1298_CMD_RESET 0x06
-#define ADS1298_CMD_START 0x08
-#define ADS1298_CMD_STOP 0x0A
-#define ADS1298_CMD_RDATAC 0x10
-#define ADS1298_CMD_SDATAC 0x11
-#define ADS1298_CMD_RDATA 0x12
-#define ADS1298_CMD_RREG 0x20
-#define ADS1298_CMD_WREG 0x40
-
-#define ADS1298_REG_ID 0x00
-#define ADS1298_REG_CONFIG1 0x01
-#define ADS1298_REG_CONFIG2 0x02
-#define ADS1298_REG_CONFIG3 0x03
-#define ADS1298_REG_LOFF 0x04
-#define ADS1298_REG_CH1SET 0x05
-#define ADS1298_REG_CH2SET 0x06
-#define ADS1298_REG_CH3SET 0x07
-#define ADS1298_REG_CH4SET 0x08
-#define ADS1298_REG_CH5SET 0x09
-#define ADS1298_REG_CH6SET 0x0A
-#define ADS1298_REG_CH7SET 0x0B
-#define ADS1298_REG_CH8SET 0x0C
-#define ADS1298_REG_RLD_SENSP 0x0D
-#define ADS1298_REG_RLD_SENSN 0x0E
-#define ADS1298_REG_LOFF_SENSP 0x0F
-#define ADS1298_REG_LOFF_SENSN 0x10
-#define ADS1298_REG_LOFF_FLIP 0x11
-#define ADS1298_REG_LOFF_STATP 0x12
-#define ADS1298_REG_LOFF_STATN 0x13
-#define ADS1298_REG_GPIO 0x14
-#define ADS1298_REG_PACE 0x15
-#define ADS1298_REG_RESP 0x16
-#define ADS1298_REG_CONFIG4 0x17
-#define ADS1298_REG_WCT1 0x18
-#define ADS1298_REG_WCT2 0x19
-
-
-
-#define MAX_REG_RW_BYTES 256
-#define REG_WRITE_OPCODE_LEN 2 /* 1 byte for command and reg  + 1 byte for length */
-#define EXG_MAX_SPI_LEN (MAX_REG_RW_BYTES+REG_WRITE_OPCODE_LEN)
-uint8_t actual_tx_buffer[EXG_MAX_SPI_LEN];
-uint8_t actual_rx_buffer[EXG_MAX_SPI_LEN];
-struct spi_buf tx_bufs[] = {
-        {
-                .buf = actual_tx_buffer,
-                .len = sizeof(actual_tx_buffer),
-        },
-};
-struct spi_buf rx_bufs[] = {
-        {
-                .buf = actual_rx_buffer,
-                .len = sizeof(actual_rx_buffer),
-        },
-};
-const struct spi_buf_set tx = {
-        .buffers = tx_bufs,
-        .count = ARRAY_SIZE(tx_bufs)
-};
-const struct spi_buf_set rx = {
-        .buffers = rx_bufs,
-        .count = ARRAY_SIZE(rx_bufs)
-};
 
+/* The device ignores RREG and WREG in RDATAC mode and the bus belongs to the stream, register
+ * access has to come between ads1298_stream_pause and ads1298_stream_resume */
+static bool ads1298_regs_busy(const struct device *dev)
+{
+#ifdef CONFIG_ADS1298_STREAM
+    struct ads1298_data *drv_data = dev->data;
 
+    return drv_data->streaming && !drv_data->paused;
+#else
+    return false;
+#endif
+}
 
-/* Bufs can be null */
-static int ads1298_transact(const struct device *dev, const struct spi_buf_set *txbs, const struct spi_buf_set *rxbs)
+/* Receive is only clocked in when read is set. Caller holds drv_data->lock */
+static int ads1298_transact(const struct device *dev, bool read)
 {
     const struct ads1298_dev_config *cfg = dev->config;
+    struct ads1298_data *drv_data = dev->data;
 
-    int ret  = spi_transceive(cfg->bus.bus, &cfg->bus.config , txbs, rxbs);
+    int ret  = spi_transceive(cfg->bus.bus, &drv_data->cmd_cfg, &drv_data->tx_set,
+                              read ? &drv_data->rx_set : NULL);
 
     if (ret !=0) {
         LOG_ERR("Failed to transact with SPI device (%d)", ret);
@@ -122,13 +62,24 @@ static int ads1298_transact(const struct device *dev, const struct spi_buf_set *
     return ret;
 }
 
+/* Single byte opcodes, no inter-byte delay applies */
+int ads1298_command(const struct device *dev, uint8_t cmd)
+{
+    struct ads1298_data *drv_data = dev->data;
+
+    k_mutex_lock(&drv_data->lock, K_FOREVER);
+    drv_data->tx_buf[0] = cmd;
+    drv_data->tx_spi_buf.len = 1;
+
+    int ret = ads1298_transact(dev, false);
+    k_mutex_unlock(&drv_data->lock);
+    return ret;
+}
+
 __maybe_unused
 static int ads1298_wakeup(const struct device *dev)
 {
-    actual_tx_buffer[0] = ADS1298_CMD_WAKEUP;
-    tx_bufs[0].len =1;
-
-    int ret = ads1298_transact(dev, &tx, NULL);
+    int ret = ads1298_command(dev, ADS1298_CMD_WAKEUP);
 
     k_busy_wait(1000);
 
@@ -136,49 +87,89 @@ static int ads1298_wakeup(const struct device *dev)
 
 }
 
+/* In daisy-chain mode this reads the device nearest the MCU */
 __maybe_unused
 static int ads1298_read_reg(const struct device *dev, uint8_t reg, uint16_t len, uint8_t *val)
 {
+    struct ads1298_data *drv_data = dev->data;
 
     if (reg > 0x1F) {
         LOG_ERR("Invalid register %d", reg);
         return -EINVAL;
     }
-    if (len > MAX_REG_RW_BYTES || len < 1) {
+    if (len > ADS1298_MAX_REG_RW_BYTES || len < 1) {
         LOG_ERR("Invalid length %d", len);
         return -EINVAL;
     }
 
-    actual_tx_buffer[0] = ADS1298_CMD_RREG | (reg & 0x1F); // Read command
-    actual_tx_buffer[1] = len - 1; // Length of registers to read (0-31)
-    tx_bufs[0].len = len + REG_WRITE_OPCODE_LEN; // 1 byte for command + len bytes for data
-    rx_bufs[0].len = tx_bufs[0].len;
+    k_mutex_lock(&drv_data->lock, K_FOREVER);
+    if (ads1298_regs_busy(dev)) {
+        k_mutex_unlock(&drv_data->lock);
+        return -EBUSY;
+    }
+    drv_data->tx_buf[0] = ADS1298_CMD_RREG | (reg & 0x1F); // Read command
+    drv_data->tx_buf[1] = len - 1; // Length of registers to read (0-31)
+    drv_data->tx_spi_buf.len = len + ADS1298_REG_OPCODE_LEN; // 1 byte for command + len bytes for data
+    drv_data->rx_spi_buf.len = drv_data->tx_spi_buf.len;
 
-    int ret = ads1298_transact(dev, &tx, &rx);
+    int ret = ads1298_transact(dev, true);
 
-    memcpy(val, &rx_bufs[0].buf[2], len);
+    memcpy(val, &drv_data->rx_buf[ADS1298_REG_OPCODE_LEN], len);
+    k_mutex_unlock(&drv_data->lock);
 	return ret;
 }
 
+/* Track the registers the decoder needs to turn counts into volts */
+static void ads1298_update_scaling(const struct device *dev, uint8_t reg, uint16_t len, const uint8_t *val)
+{
+    const struct ads1298_dev_config *cfg = dev->config;
+    struct ads1298_data *drv_data = dev->data;
+
+    for (uint16_t i = 0; i < len; i++, reg++) {
+        if (reg == ADS1298_REG_CONFIG1) {
+            drv_data->data_rate_hz = ads1298_data_rate_hz(val[i]);
+        } else if (reg == ADS1298_REG_CONFIG3) {
+            drv_data->vref_uv = ads1298_vref_uv(val[i]);
+        } else if (reg >= ADS1298_REG_CH1SET && reg <= ADS1298_REG_CH8SET) {
+            /* DIN is shared so every device in a chain gets the same write */
+            for (uint8_t d = 0; d < cfg->n_devices; d++) {
+                drv_data->gain[d * ADS1298_NUM_CHANNELS + reg - ADS1298_REG_CH1SET] =
+                    ads1298_pga_gain(val[i]);
+            }
+        }
+    }
+}
+
 __maybe_unused
 static int ads1298_write_reg(const struct device *dev, uint8_t reg, uint16_t len, uint8_t *val)
 {
+    struct ads1298_data *drv_data = dev->data;
 
     if (reg > 0x1F) {
         LOG_ERR("Invalid register %d", reg);
         return -EINVAL;
     }
-    if (len > MAX_REG_RW_BYTES || len < 1) {
+    if (len > ADS1298_MAX_REG_RW_BYTES || len < 1) {
         LOG_ERR("Invalid length %d", len);
         return -EINVAL;
     }
 
-    actual_tx_buffer[0] = ADS1298_CMD_WREG | (reg & 0x1F);
-    actual_tx_buffer[1] = len - 1; /* -1 from datasheet*/
-    memcpy(&actual_tx_buffer[2], val, len);
-    tx_bufs[0].len = len + REG_WRITE_OPCODE_LEN;
-
-    return ads1298_transact(dev, &tx, NULL);
+    k_mutex_lock(&drv_data->lock, K_FOREVER);
+    if (ads1298_regs_busy(dev)) {
+        k_mutex_unlock(&drv_data->lock);
+        return -EBUSY;
+    }
+    drv_data->tx_buf[0] = ADS1298_CMD_WREG | (reg & 0x1F);
+    drv_data->tx_buf[1] = len - 1; /* -1 from datasheet*/
+    memcpy(&drv_data->tx_buf[ADS1298_REG_OPCODE_LEN], val, len);
+    drv_data->tx_spi_buf.len = len + ADS1298_REG_OPCODE_LEN;
+
+    int ret = ads1298_transact(dev, false);
+    if (ret == 0) {
+        ads1298_update_scaling(dev, reg, len, val);
+    }
+    k_mutex_unlock(&drv_data->lock);
+    return ret;
 }
 
 
@@ -186,72 +177,453 @@ __maybe_unused
 static int ads1298_set_sdatac_mode(const struct device *dev)
 {
 
-    actual_tx_buffer[0] = ADS1298_CMD_SDATAC;
-    tx_bufs[0].len = 1;
-
-    int ret = ads1298_transact(dev, &tx, NULL);
+    int ret = ads1298_command(dev, ADS1298_CMD_SDATAC);
     LOG_DBG("Set SDATAC mode ret: %d", ret);
 
     return ret;
 }
 
 
+/* Register shadow. Changes go to drv_data->regs and are marked dirty, ads1298_reg_sync() then
+ * writes only the dirty registers, merging neighbours into as few WREG bursts as possible since
+ * every transaction pays the opcode bytes and the CS setup/hold delays. */
 
-static int ads1298_sample_fetch(const struct device *dev, enum sensor_channel chan)
+/* Never written and not compared by the integrity check */
+#define ADS1298_RO_REGS (BIT(ADS1298_REG_ID) | BIT(ADS1298_REG_LOFF_STATP) | BIT(ADS1298_REG_LOFF_STATN))
+/* A burst may rewrite this many clean registers to avoid starting another WREG */
+#define ADS1298_SYNC_MAX_GAP 2
+
+/* Bits that change on their own and are ignored by the integrity check */
+static uint8_t ads1298_volatile_bits(uint8_t reg)
 {
-//	struct ads1298_data *drv_data = dev->data;
-//	int ret;
+    switch (reg) {
+    case ADS1298_REG_LOFF_STATP:
+    case ADS1298_REG_LOFF_STATN:
+        return 0xFF;
+    case ADS1298_REG_GPIO:
+        return 0xF0; /* GPIOD reflects the pins when configured as inputs */
+    default:
+        return 0;
+    }
+}
 
-	if (chan != SENSOR_CHAN_ALL && chan != SENSOR_CHAN_PRESS) {
-		return -ENOTSUP;
-	}
+void ads1298_reg_update(const struct device *dev, uint8_t reg, uint8_t mask, uint8_t val)
+{
+    struct ads1298_data *drv_data = dev->data;
+
+    __ASSERT_NO_MSG(reg < ADS1298_NUM_REGS);
+    k_mutex_lock(&drv_data->lock, K_FOREVER);
+    uint8_t new_val = (drv_data->regs[reg] & ~mask) | (val & mask);
+    if (new_val != drv_data->regs[reg]) {
+        drv_data->regs[reg] = new_val;
+        drv_data->dirty |= BIT(reg);
+    }
+    k_mutex_unlock(&drv_data->lock);
+}
 
-//    ret = ads1298_wakeup(dev);
-//    if (ret) {
-//        return ret;
-//    }
+/* Device must be in SDATAC mode, -EBUSY while the stream runs unpaused */
+int ads1298_reg_sync(const struct device *dev)
+{
+    struct ads1298_data *drv_data = dev->data;
+    int ret = 0;
+
+    k_mutex_lock(&drv_data->lock, K_FOREVER);
+    drv_data->dirty &= ~ADS1298_RO_REGS;
+
+    while (drv_data->dirty != 0) {
+        uint8_t first = __builtin_ctz(drv_data->dirty);
+        uint8_t last = first;
+
+        for (uint8_t r = first + 1; r < ADS1298_NUM_REGS; r++) {
+            if (ADS1298_RO_REGS & BIT(r)) {
+                break;
+            }
+            if (drv_data->dirty & BIT(r)) {
+                last = r;
+            } else if (r - last > ADS1298_SYNC_MAX_GAP) {
+                break;
+            }
+        }
 
+        ret = ads1298_write_reg(dev, first, last - first + 1, &drv_data->regs[first]);
+        if (ret != 0) {
+            break;
+        }
+        drv_data->dirty &= ~GENMASK(last, first);
+    }
+    k_mutex_unlock(&drv_data->lock);
+    return ret;
+}
 
+/* Replace the shadow with what is in the device, one RREG for the whole map */
+static int ads1298_reg_load(const struct device *dev)
+{
+    struct ads1298_data *drv_data = dev->data;
 
-//    drv_data->pressure = (int32_t) sys_get_be24(&buf[1]);
-//    drv_data->temperature = (int32_t ) sys_get_be24(&buf[4]);
+    k_mutex_lock(&drv_data->lock, K_FOREVER);
+    int ret = ads1298_read_reg(dev, ADS1298_REG_ID, ADS1298_NUM_REGS, drv_data->regs);
+    if (ret == 0) {
+        drv_data->dirty = 0;
+        ads1298_update_scaling(dev, ADS1298_REG_ID, ADS1298_NUM_REGS, drv_data->regs);
+    }
+    k_mutex_unlock(&drv_data->lock);
+    return ret;
+}
 
-	return 0;
+#if CONFIG_ADS1298_REG_CHECK_INTERVAL_MS > 0
+
+/* SDATAC, a 26 byte RREG and RDATAC take ~150us at the command SCLK, above this rate that
+ * no longer fits between two nDRDY edges so the check would cost frames */
+#define ADS1298_REG_CHECK_MAX_SPS 2000
+
+/* Read the map back in one burst and repair anything that differs from the shadow, e.g.
+ * after an ESD event or brown-out has reset the part. */
+static void ads1298_reg_check_handler(struct k_work *work)
+{
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+    struct ads1298_data *drv_data = CONTAINER_OF(dwork, struct ads1298_data, reg_check);
+    const struct device *dev = drv_data->dev;
+    uint8_t live[ADS1298_NUM_REGS];
+    int ret;
+
+    k_mutex_lock(&drv_data->lock, K_FOREVER);
+
+#ifdef CONFIG_ADS1298_STREAM
+    bool streaming = drv_data->streaming;
+    if (streaming) {
+        if (drv_data->data_rate_hz > ADS1298_REG_CHECK_MAX_SPS) {
+            goto out;
+        }
+        /* Pauses straight after a frame so the read fits in the gap before the next one */
+        ret = ads1298_stream_pause(dev);
+        if (ret != 0) {
+            goto out;
+        }
+    }
+#endif
+
+    ret = ads1298_read_reg(dev, ADS1298_REG_ID, ADS1298_NUM_REGS, live);
+    if (ret == 0) {
+        for (uint8_t r = 0; r < ADS1298_NUM_REGS; r++) {
+            uint8_t diff = (live[r] ^ drv_data->regs[r]) & ~ads1298_volatile_bits(r);
+
+            if (diff != 0 && !(ADS1298_RO_REGS & BIT(r))) {
+                LOG_ERR("Register 0x%02x is 0x%02x, expected 0x%02x", r, live[r], drv_data->regs[r]);
+                drv_data->dirty |= BIT(r);
+                drv_data->reg_faults++;
+            }
+        }
+        if (drv_data->dirty != 0) {
+            ads1298_reg_sync(dev);
+        }
+    }
+
+#ifdef CONFIG_ADS1298_STREAM
+    if (streaming) {
+        ads1298_stream_resume(dev);
+    }
+out:
+#endif
+    k_mutex_unlock(&drv_data->lock);
+    k_work_reschedule(dwork, K_MSEC(CONFIG_ADS1298_REG_CHECK_INTERVAL_MS));
+}
+
+#endif
+
+/* 9.5.2.6 RDATA, one frame on demand. Only valid while not in RDATAC mode.
+ * A chain shifts out every device's frame back to back behind the one opcode. */
+int ads1298_read_frame(const struct device *dev, uint8_t *frame)
+{
+    const struct ads1298_dev_config *cfg = dev->config;
+    struct ads1298_data *drv_data = dev->data;
+    size_t frame_bytes = ads1298_frame_bytes(cfg);
+
+    k_mutex_lock(&drv_data->lock, K_FOREVER);
+    memset(drv_data->tx_buf, 0, frame_bytes + 1);
+    drv_data->tx_buf[0] = ADS1298_CMD_RDATA;
+    drv_data->tx_spi_buf.len = frame_bytes + 1;
+    drv_data->rx_spi_buf.len = drv_data->tx_spi_buf.len;
+
+    int ret = ads1298_transact(dev, true);
+
+    memcpy(frame, &drv_data->rx_buf[1], frame_bytes);
+    k_mutex_unlock(&drv_data->lock);
+    return ret;
+}
+
+size_t ads1298_frame_size(const struct device *dev)
+{
+    return ads1298_frame_bytes(dev->config);
+}
+
+unsigned int ads1298_num_channels(const struct device *dev)
+{
+    const struct ads1298_dev_config *cfg = dev->config;
+
+    return ADS1298_NUM_CHANNELS * cfg->n_devices;
+}
+
+void ads1298_get_scaling(const struct device *dev, uint8_t *gain, uint32_t *vref_uv)
+{
+    struct ads1298_data *drv_data = dev->data;
+
+    k_mutex_lock(&drv_data->lock, K_FOREVER);
+    memcpy(gain, drv_data->gain, ads1298_num_channels(dev));
+    *vref_uv = drv_data->vref_uv;
+    k_mutex_unlock(&drv_data->lock);
+}
+
+static int ads1298_sample_fetch(const struct device *dev, enum sensor_channel chan)
+{
+	struct ads1298_data *drv_data = dev->data;
+
+	/* Every channel comes out of the device in the same frame */
+	if (chan != SENSOR_CHAN_ALL && chan != SENSOR_CHAN_VOLTAGE &&
+	    (chan < SENSOR_CHAN_ADS1298_CH1 ||
+	     chan >= SENSOR_CHAN_ADS1298_CH1 + ads1298_num_channels(dev))) {
+		return -ENOTSUP;
+	}
+
+#ifdef CONFIG_ADS1298_STREAM
+    /* The bus belongs to the stream, take a copy of the newest frame instead */
+    if (drv_data->streaming) {
+        return ads1298_stream_latest(dev, drv_data->frame);
+    }
+#endif
+
+	return ads1298_read_frame(dev, drv_data->frame);
 }
 
+/* SENSOR_CHAN_VOLTAGE is channel 1, for the others use SENSOR_CHAN_ADS1298_CH1 + n */
 static int ads1298_channel_get(const struct device *dev, enum sensor_channel chan,
 			       struct sensor_value *val)
 {
 	struct ads1298_data *drv_data = dev->data;
-
-	if (chan != SENSOR_CHAN_PRESS) {
+	unsigned int idx;
+
+	if (chan == SENSOR_CHAN_VOLTAGE) {
+		idx = 0;
+	} else if (chan >= SENSOR_CHAN_ADS1298_CH1 &&
+		   chan < SENSOR_CHAN_ADS1298_CH1 + ads1298_num_channels(dev)) {
+		idx = chan - SENSOR_CHAN_ADS1298_CH1;
+	} else {
 		return -ENOTSUP;
 	}
 
-    /* TODO Convert to mBar or something  (Datasheet unclear on -ve values) */
-	val->val1 = (drv_data->pressure&& 0xFF0000) >> 16;
-	val->val2 = (drv_data->pressure&& 0x00FFFF);
+    int32_t counts = ads1298_sample_counts(&drv_data->frame[ads1298_sample_offset(idx)]);
 
-	return 0;
+	return sensor_value_from_micro(val, ads1298_counts_to_uv(counts, drv_data->gain[idx], drv_data->vref_uv));
 }
 
 
+/* Write whatever attr_set changed, pausing the stream only when there is something to write */
+static int ads1298_reg_apply(const struct device *dev)
+{
+    struct ads1298_data *drv_data = dev->data;
+    int ret;
+
+    if (drv_data->dirty == 0) {
+        return 0;
+    }
+
+#ifdef CONFIG_ADS1298_STREAM
+    ret = ads1298_stream_pause(dev);
+    if (ret != 0) {
+        return ret;
+    }
+#endif
+
+    ret = ads1298_reg_sync(dev);
+
+#ifdef CONFIG_ADS1298_STREAM
+    int resume_ret = ads1298_stream_resume(dev);
+    if (ret == 0) {
+        ret = resume_ret;
+    }
+#endif
+    return ret;
+}
+
+/* Bit of one channel or of all of them in a per channel register. Chained devices share the write */
+static int ads1298_channel_bits(const struct device *dev, enum sensor_channel chan)
+{
+    if (chan >= (enum sensor_channel)SENSOR_CHAN_ADS1298_CH1 &&
+        chan < (enum sensor_channel)(SENSOR_CHAN_ADS1298_CH1 + ads1298_num_channels(dev))) {
+        return BIT((chan - SENSOR_CHAN_ADS1298_CH1) % ADS1298_NUM_CHANNELS);
+    } else if (chan != SENSOR_CHAN_ALL && chan != SENSOR_CHAN_VOLTAGE) {
+        return -ENOTSUP;
+    }
+    return BIT_MASK(ADS1298_NUM_CHANNELS);
+}
+
+/* CHnSET of one channel or all of them */
+static int ads1298_chset_update(const struct device *dev, enum sensor_channel chan, uint8_t mask, uint8_t val)
+{
+    int bits = ads1298_channel_bits(dev, chan);
+
+    if (bits < 0) {
+        return bits;
+    }
+
+    for (unsigned int ch = 0; ch < ADS1298_NUM_CHANNELS; ch++) {
+        if (bits & BIT(ch)) {
+            ads1298_reg_update(dev, ADS1298_REG_CH1SET + ch, mask, val);
+        }
+    }
+    return 0;
+}
+
+/* 9.4.2 Lead-off detection on the P and N inputs of the channels. Excitation is device wide,
+ * the comparators are only of use in DC mode where they fill LOFF_STATP/N in every status word */
+static int ads1298_lead_off_update(const struct device *dev, enum sensor_channel chan, int mode)
+{
+    struct ads1298_data *drv_data = dev->data;
+    int bits = ads1298_channel_bits(dev, chan);
+    uint8_t sens;
+
+    if (bits < 0) {
+        return bits;
+    }
+
+    switch (mode) {
+    case ADS1298_LEAD_OFF_NONE:
+        sens = 0;
+        break;
+    case ADS1298_LEAD_OFF_DC:
+        sens = bits;
+        ads1298_reg_update(dev, ADS1298_REG_LOFF, ADS1298_LOFF_FLEAD_MASK, ADS1298_LOFF_FLEAD_DC);
+        break;
+    case ADS1298_LEAD_OFF_AC:
+        sens = bits;
+        ads1298_reg_update(dev, ADS1298_REG_LOFF, ADS1298_LOFF_FLEAD_MASK, ADS1298_LOFF_FLEAD_AC);
+        break;
+    default:
+        return -EINVAL;
+    }
+
+    ads1298_reg_update(dev, ADS1298_REG_LOFF_SENSP, bits, sens);
+    ads1298_reg_update(dev, ADS1298_REG_LOFF_SENSN, bits, sens);
+
+    bool comparators = (drv_data->regs[ADS1298_REG_LOFF_SENSP] | drv_data->regs[ADS1298_REG_LOFF_SENSN]) != 0 &&
+                       (drv_data->regs[ADS1298_REG_LOFF] & ADS1298_LOFF_FLEAD_MASK) == ADS1298_LOFF_FLEAD_DC;
+
+    ads1298_reg_update(dev, ADS1298_REG_CONFIG4, ADS1298_CONFIG4_PD_LOFF_COMP,
+                       comparators ? ADS1298_CONFIG4_PD_LOFF_COMP : 0);
+    return 0;
+}
+
 static int ads1298_attr_set(const struct device *dev, enum sensor_channel chan,
 			    enum sensor_attribute attr, const struct sensor_value *val)
 {
+    struct ads1298_data *drv_data = dev->data;
+    int ret;
 
-	return 0;
+    if (val->val2 != 0) {
+        return -EINVAL;
+    }
+
+    k_mutex_lock(&drv_data->lock, K_FOREVER);
+
+    switch ((int)attr) {
+    case SENSOR_ATTR_SAMPLING_FREQUENCY:
+        ret = ads1298_data_rate_config1(val->val1);
+        if (ret >= 0) {
+            ads1298_reg_update(dev, ADS1298_REG_CONFIG1, ADS1298_CONFIG1_RATE_MASK, ret);
+        }
+        break;
+    case SENSOR_ATTR_ADS1298_GAIN:
+        ret = val->val1 > 0 && val->val1 <= UINT8_MAX ? ads1298_pga_gain_code(val->val1) : -EINVAL;
+        if (ret >= 0) {
+            ret = ads1298_chset_update(dev, chan, ADS1298_CHNSET_GAIN_MASK,
+                                       ret << ADS1298_CHNSET_GAIN_SHIFT);
+        }
+        break;
+    case SENSOR_ATTR_ADS1298_MUX:
+        switch (val->val1) {
+        case ADS1298_MUX_NORMAL:
+        case ADS1298_MUX_SHORTED:
+        case ADS1298_MUX_SUPPLY:
+        case ADS1298_MUX_TEMPERATURE:
+        case ADS1298_MUX_TEST:
+            ret = ads1298_chset_update(dev, chan, ADS1298_CHNSET_MUX_MASK, val->val1);
+            break;
+        default:
+            ret = -EINVAL;
+            break;
+        }
+        if (ret == 0) {
+            /* 9.3.1.5 Test signal generated internally rather than driven on TESTP/N, only
+             * while some channel is connected to it */
+            bool test = false;
+
+            for (unsigned int ch = 0; ch < ADS1298_NUM_CHANNELS; ch++) {
+                test |= (drv_data->regs[ADS1298_REG_CH1SET + ch] & ADS1298_CHNSET_MUX_MASK) ==
+                        ADS1298_MUX_TEST;
+            }
+            ads1298_reg_update(dev, ADS1298_REG_CONFIG2, ADS1298_CONFIG2_INT_TEST,
+                               test ? ADS1298_CONFIG2_INT_TEST : 0);
+        }
+        break;
+    case SENSOR_ATTR_ADS1298_POWER_DOWN:
+        ret = ads1298_chset_update(dev, chan, ADS1298_CHNSET_PD, val->val1 ? ADS1298_CHNSET_PD : 0);
+        break;
+    case SENSOR_ATTR_ADS1298_LEAD_OFF:
+        ret = ads1298_lead_off_update(dev, chan, val->val1);
+        break;
+    case SENSOR_ATTR_ADS1298_LEAD_OFF_CURRENT:
+        /* ILEAD_OFF[1:0] is 6 nA per step from 6 nA */
+        if (val->val1 >= 6 && val->val1 <= 24 && val->val1 % 6 == 0) {
+            ads1298_reg_update(dev, ADS1298_REG_LOFF, ADS1298_LOFF_ILEAD_MASK,
+                               (val->val1 / 6 - 1) << ADS1298_LOFF_ILEAD_SHIFT);
+            ret = 0;
+        } else {
+            ret = -EINVAL;
+        }
+        break;
+    case SENSOR_ATTR_ADS1298_WCT:
+        /* 9.3.1.4 WCTA on LA, WCTB on LL and WCTC on RA */
+        ads1298_reg_update(dev, ADS1298_REG_WCT1, 0xFF,
+                           val->val1 ? ADS1298_WCT1_PD_WCTA | ADS1298_WCT_CH2P : 0);
+        ads1298_reg_update(dev, ADS1298_REG_WCT2, 0xFF,
+                           val->val1 ? ADS1298_WCT2_PD_WCTC | ADS1298_WCT2_PD_WCTB |
+                                           (ADS1298_WCT_CH3P << ADS1298_WCT2_WCTB_SHIFT) |
+                                           ADS1298_WCT_CH2N
+                                     : 0);
+        ret = 0;
+        break;
+    default:
+        ret = -ENOTSUP;
+        break;
+    }
+
+    if (ret >= 0) {
+        ret = ads1298_reg_apply(dev);
+    }
+
+    k_mutex_unlock(&drv_data->lock);
+    return ret;
 }
 
+/* Checks the ID already loaded into the shadow */
 static int ads1298_probe(const struct device *dev)
 {
-    uint8_t  id = 0;
-    int ret = ads1298_read_reg(dev, ADS1298_REG_ID, 1, &id);
+    struct ads1298_data *drv_data = dev->data;
+    uint8_t id = drv_data->regs[ADS1298_REG_ID];
+
     LOG_DBG("read ID: 0x%02x", id);
-    if( ret != 0 || id != 0x92) /* TODO, there are multiple valid IDs*/
+    /* Both the ADS129x and the ADS129xR, in daisy-chain only the first device answers RREG */
+    if (((id & ADS1298_ID_DEV_MASK) != ADS1298_ID_DEV_ADS129X &&
+         (id & ADS1298_ID_DEV_MASK) != ADS1298_ID_DEV_ADS129XR) ||
+        (id & ADS1298_ID_RSVD_MASK) != ADS1298_ID_RSVD)
     {
-        LOG_ERR("Failed to probe ADS1298, ID: 0x%02x with %d", id, ret);
+        LOG_ERR("Failed to probe ADS1298, ID: 0x%02x", id);
         return -ENODEV;
+    }
+    /* The ADS1294 and ADS1296 shift out shorter frames than the 8 channel layout used here */
+    if ((id & ADS1298_ID_NU_CH_MASK) != ADS1298_ID_NU_CH_8)
+    {
+        LOG_ERR("ID 0x%02x is not an 8 channel part, the only ones supported", id);
+        return -ENOTSUP;
     }
 	return 0;
 }
@@ -259,6 +631,10 @@ static int ads1298_probe(const struct device *dev)
 
 void hack_safe_init_gpio(const struct gpio_dt_spec *spec, int flags)
 {
+    if (spec->port == NULL)
+    {
+        return;
+    }
     if (!gpio_is_ready_dt(spec))
     {
         LOG_ERR("Gpio not ready %s %d",spec->port->name, spec->pin);
@@ -279,14 +655,22 @@ static inline void wait_tpor(void)
     k_sleep(K_MSEC(150)); /* Osc should start and DRDY toggle at 250Hz */
 }
 
-static inline void exg_reset(void)
+static inline void exg_reset(const struct device *dev)
 {
+    const struct ads1298_dev_config *cfg = dev->config;
+
     /* Fig 105 Wait for power rails to settle before setting 'signals' */
     wait_tpor();
+    if (cfg->nrst_gpio.port == NULL) {
+        /* The RESET opcode does the same, with the same 18 tCLK wait after it */
+        ads1298_command(dev, ADS1298_CMD_RESET);
+        k_busy_wait(10);
+        return;
+    }
     /* Fig 105 Issue reset pulse */
-    gpio_pin_set_dt(&exg_nrst, 0);
+    gpio_pin_set_dt(&cfg->nrst_gpio, 0);
     k_busy_wait(1); /* tRST = 2 * tCLKmax = 36n */
-    gpio_pin_set_dt(&exg_nrst, 1);
+    gpio_pin_set_dt(&cfg->nrst_gpio, 1);
     /* Fig105 wait 18x tCKmax => 9.25us */
     k_busy_wait(10);
     /* end of 11.1/fig105*/
@@ -295,7 +679,7 @@ static inline void exg_reset(void)
 static int ads1298_init(const struct device *dev)
 {
 	const struct ads1298_dev_config *cfg = dev->config;
-    uint8_t  buf[7] = {0};
+	struct ads1298_data *drv_data = dev->data;
     int ret;
 
 	if (!spi_is_ready_dt(&cfg->bus)) {
@@ -303,60 +687,116 @@ static int ads1298_init(const struct device *dev)
 		return -ENODEV;
 	}
 
+    drv_data->cmd_cfg = cfg->bus.config;
+    drv_data->cmd_cfg.frequency = MIN(cfg->bus.config.frequency, ADS1298_CMD_SCLK_HZ);
+
+    drv_data->dev = dev;
+    k_mutex_init(&drv_data->lock);
+    drv_data->tx_spi_buf.buf = drv_data->tx_buf;
+    drv_data->rx_spi_buf.buf = drv_data->rx_buf;
+    drv_data->tx_set.buffers = &drv_data->tx_spi_buf;
+    drv_data->tx_set.count = 1;
+    drv_data->rx_set.buffers = &drv_data->rx_spi_buf;
+    drv_data->rx_set.count = 1;
+
     /* Following flow in fig 93 */
 
     /* First step calls out 11.1 and fig 105*/
-    hack_safe_init_gpio(&exg_nrst, GPIO_OUTPUT_HIGH);
-    exg_reset();
+    hack_safe_init_gpio(&cfg->nrst_gpio, GPIO_OUTPUT_HIGH);
+    exg_reset(dev);
 
-    hack_safe_init_gpio(&exg_clksel, GPIO_OUTPUT_HIGH); /* High = internal clock*/
-//    hack_safe_init_gpio(&exg_start_conv, GPIO_OUTPUT_HIGH); /* High to observe nDRDY as sign of life*/
-    hack_safe_init_gpio(&exg_start_conv, GPIO_OUTPUT_LOW);
+    hack_safe_init_gpio(&cfg->clksel_gpio, GPIO_OUTPUT_HIGH); /* High = internal clock*/
+//    hack_safe_init_gpio(&cfg->start_gpio, GPIO_OUTPUT_HIGH); /* High to observe nDRDY as sign of life*/
+    hack_safe_init_gpio(&cfg->start_gpio, GPIO_OUTPUT_LOW);
 
-    hack_safe_init_gpio(&exg_npwdn, GPIO_OUTPUT_HIGH);
-    exg_reset();
+    hack_safe_init_gpio(&cfg->npwdn_gpio, GPIO_OUTPUT_HIGH);
+    exg_reset(dev);
 
     ret = ads1298_set_sdatac_mode(dev);
-    buf[0] = 0xc0;
-    ret = ads1298_write_reg(dev, ADS1298_REG_CONFIG3, 1, buf);
-    buf[0] = 0x86;
-    ret = ads1298_write_reg(dev, ADS1298_REG_CONFIG1, 1, buf);
-    buf[0] = 0x00;
-    ret = ads1298_write_reg(dev, ADS1298_REG_CONFIG2, 1, buf);
-
-    buf[0] = 0x01;
-    ret = ads1298_write_reg(dev, ADS1298_REG_CH1SET, 1, buf);
-    ret = ads1298_write_reg(dev, ADS1298_REG_CH2SET, 1, buf);
-    ret = ads1298_write_reg(dev, ADS1298_REG_CH3SET, 1, buf);
-    ret = ads1298_write_reg(dev, ADS1298_REG_CH4SET, 1, buf);
-    ret = ads1298_write_reg(dev, ADS1298_REG_CH5SET, 1, buf);
-    ret = ads1298_write_reg(dev, ADS1298_REG_CH6SET, 1, buf);
-    ret = ads1298_write_reg(dev, ADS1298_REG_CH7SET, 1, buf);
-    ret = ads1298_write_reg(dev, ADS1298_REG_CH8SET, 1, buf);
+    ret = ads1298_reg_load(dev);
+    if (ret != 0) {
+        return ret;
+    }
 
     ret = ads1298_probe(dev);
+    if (ret != 0) {
+        return ret;
+    }
 
-    gpio_pin_set_dt(&exg_start_conv, 1);
+    ads1298_reg_update(dev, ADS1298_REG_CONFIG3, 0xFF, 0xc0);
+    /* DAISY_EN clear selects daisy-chain rather than multiple readback */
+    ads1298_reg_update(dev, ADS1298_REG_CONFIG1, 0xFF, 0x86);
+    ads1298_reg_update(dev, ADS1298_REG_CONFIG2, 0xFF, 0x00);
+    for (uint8_t reg = ADS1298_REG_CH1SET; reg <= ADS1298_REG_CH8SET; reg++) {
+        ads1298_reg_update(dev, reg, 0xFF, 0x01);
+    }
 
-	return ret;
+    /* CONFIG1..CH8SET goes out as a single burst */
+    ret = ads1298_reg_sync(dev);
+    if (ret != 0) {
+        return ret;
+    }
+
+#ifdef CONFIG_ADS1298_STREAM
+    ret = ads1298_stream_init(dev);
+    if (ret != 0) {
+        return ret;
+    }
+#endif
+
+    if (cfg->start_gpio.port != NULL) {
+        gpio_pin_set_dt(&cfg->start_gpio, 1);
+    } else {
+        ret = ads1298_command(dev, ADS1298_CMD_START);
+        if (ret != 0) {
+            return ret;
+        }
+    }
+
+#if CONFIG_ADS1298_REG_CHECK_INTERVAL_MS > 0
+    k_work_init_delayable(&drv_data->reg_check, ads1298_reg_check_handler);
+    k_work_schedule(&drv_data->reg_check, K_MSEC(CONFIG_ADS1298_REG_CHECK_INTERVAL_MS));
+#endif
+
+	return 0;
 }
 
 static DEVICE_API(sensor, ads1298_driver_api) = {
 	.attr_set = ads1298_attr_set,
 	.sample_fetch = ads1298_sample_fetch, // Device to driver (private)
 	.channel_get  = ads1298_channel_get, // driver to thread
+#ifdef CONFIG_SENSOR_ASYNC_API
+	.submit = ads1298_submit,
+	.get_decoder = ads1298_get_decoder,
+#endif
 };
 
+#define ADS1298_RING_DEFINE(inst)                                                                  \
+	static uint8_t ads1298_ring_##inst[CONFIG_ADS1298_RING_FRAMES * ADS1298_FRAME_BYTES *      \
+					   DT_INST_PROP(inst, daisy_chain_length)] __aligned(4);      \
+	static uint64_t ads1298_ring_ts_##inst[CONFIG_ADS1298_RING_FRAMES];
+
 #define ADS1298_DEFINE(inst)                                                                       \
+	BUILD_ASSERT(DT_INST_PROP(inst, daisy_chain_length) <= ADS1298_MAX_DEVICES,                \
+		     "Daisy chain longer than ADS1298_MAX_DEVICES");                               \
 	static struct ads1298_data ads1298_data_##inst;                                            \
+	IF_ENABLED(CONFIG_ADS1298_STREAM, (ADS1298_RING_DEFINE(inst)))                             \
                                                                                                    \
 	static const struct ads1298_dev_config ads1298_config_##inst = {                           \
 		.bus = SPI_DT_SPEC_INST_GET(                                                       \
 			inst,                                                                      \
 			(SPI_WORD_SET(8) | SPI_TRANSFER_MSB | SPI_MODE_CPHA), 0),  \
+		.n_devices = DT_INST_PROP(inst, daisy_chain_length),                               \
+		.clksel_gpio = ADS1298_INST_GPIO(inst, clksel_gpios, exg_clksel),                  \
+		.nrst_gpio = ADS1298_INST_GPIO(inst, nrst_gpios, exg_nrst),                        \
+		.npwdn_gpio = ADS1298_INST_GPIO(inst, npwdn_gpios, exg_npwdn),                     \
+		.start_gpio = ADS1298_INST_GPIO(inst, start_gpios, exg_start_conv),                \
                                                                                                    \
-		IF_ENABLED(CONFIG_ADT7310_TRIGGER,                                                 \
-			   (.int_gpio = GPIO_DT_SPEC_INST_GET_OR(inst, int_gpios, {0}),))};        \
+		IF_ENABLED(CONFIG_ADS1298_STREAM,                                                  \
+			   (.drdy_gpio = GPIO_DT_SPEC_INST_GET_OR(inst, drdy_gpios, {0}),          \
+			    .drdy_capture = DT_INST_PROP_OR(inst, drdy_capture_channel, -1),       \
+			    .ring = ads1298_ring_##inst,                                           \
+			    .ring_ts = ads1298_ring_ts_##inst,))};                                 \
                                                                                                    \
 	SENSOR_DEVICE_DT_INST_DEFINE(inst, ads1298_init, NULL, &ads1298_data_##inst,               \
 				     &ads1298_config_##inst, POST_KERNEL,                          \
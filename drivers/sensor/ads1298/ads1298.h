@@ -3,17 +3,222 @@
 
 #include <zephyr/types.h>
 #include <zephyr/device.h>
+#include <zephyr/drivers/gpio.h>
 #include <zephyr/drivers/sensor.h>
+#include <zephyr/drivers/spi.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+
+#define ADS1298_CMD_WAKEUP 0x02
+#define ADS1298_CMD_STANDBY 0x04
+#define ADS1298_CMD_RESET 0x06
+#define ADS1298_CMD_START 0x08
+#define ADS1298_CMD_STOP 0x0A
+#define ADS1298_CMD_RDATAC 0x10
+#define ADS1298_CMD_SDATAC 0x11
+#define ADS1298_CMD_RDATA 0x12
+#define ADS1298_CMD_RREG 0x20
+#define ADS1298_CMD_WREG 0x40
+
+#define ADS1298_REG_ID 0x00
+#define ADS1298_REG_CONFIG1 0x01
+#define ADS1298_REG_CONFIG2 0x02
+#define ADS1298_REG_CONFIG3 0x03
+#define ADS1298_REG_LOFF 0x04
+#define ADS1298_REG_CH1SET 0x05
+#define ADS1298_REG_CH2SET 0x06
+#define ADS1298_REG_CH3SET 0x07
+#define ADS1298_REG_CH4SET 0x08
+#define ADS1298_REG_CH5SET 0x09
+#define ADS1298_REG_CH6SET 0x0A
+#define ADS1298_REG_CH7SET 0x0B
+#define ADS1298_REG_CH8SET 0x0C
+#define ADS1298_REG_RLD_SENSP 0x0D
+#define ADS1298_REG_RLD_SENSN 0x0E
+#define ADS1298_REG_LOFF_SENSP 0x0F
+#define ADS1298_REG_LOFF_SENSN 0x10
+#define ADS1298_REG_LOFF_FLIP 0x11
+#define ADS1298_REG_LOFF_STATP 0x12
+#define ADS1298_REG_LOFF_STATN 0x13
+#define ADS1298_REG_GPIO 0x14
+#define ADS1298_REG_PACE 0x15
+#define ADS1298_REG_RESP 0x16
+#define ADS1298_REG_CONFIG4 0x17
+#define ADS1298_REG_WCT1 0x18
+#define ADS1298_REG_WCT2 0x19
+#define ADS1298_NUM_REGS 0x1A
+
+/* Register fields checked or changed at runtime, Tables 9, 10, 11, 13, 14, 24, 31 and 32 */
+#define ADS1298_ID_DEV_MASK GENMASK(7, 5)
+#define ADS1298_ID_DEV_ADS129X 0x80
+#define ADS1298_ID_DEV_ADS129XR 0xC0
+#define ADS1298_ID_RSVD_MASK GENMASK(4, 3)
+#define ADS1298_ID_RSVD 0x10 /* Always reads back 10 */
+#define ADS1298_ID_NU_CH_MASK GENMASK(2, 0)
+#define ADS1298_ID_NU_CH_8 0x02 /* 000 ADS1294, 001 ADS1296, 010 ADS1298 */
+#define ADS1298_CONFIG1_RATE_MASK (BIT(7) | GENMASK(2, 0)) /* HR and DR[2:0] */
+#define ADS1298_CONFIG2_INT_TEST BIT(4)
+#define ADS1298_CHNSET_PD BIT(7)
+#define ADS1298_CHNSET_GAIN_SHIFT 4
+#define ADS1298_CHNSET_GAIN_MASK GENMASK(6, 4)
+#define ADS1298_CHNSET_MUX_MASK GENMASK(2, 0)
+#define ADS1298_LOFF_ILEAD_SHIFT 2
+#define ADS1298_LOFF_ILEAD_MASK GENMASK(3, 2)
+#define ADS1298_LOFF_FLEAD_MASK GENMASK(1, 0)
+#define ADS1298_LOFF_FLEAD_DC 0x00
+#define ADS1298_LOFF_FLEAD_AC 0x01 /* Excitation at fDR / 4 */
+#define ADS1298_CONFIG4_PD_LOFF_COMP BIT(1)
+#define ADS1298_WCT1_PD_WCTA BIT(3)
+#define ADS1298_WCT2_PD_WCTC BIT(7)
+#define ADS1298_WCT2_PD_WCTB BIT(6)
+#define ADS1298_WCT2_WCTB_SHIFT 3
+#define ADS1298_WCT_CH2P 0x2 /* WCTA/B/C[2:0] input selection */
+#define ADS1298_WCT_CH2N 0x3
+#define ADS1298_WCT_CH3P 0x4
+
+/* 9.4.4.2 Data is read out as a 24 bit status word followed by 8 channels of 24 bits */
+#define ADS1298_NUM_CHANNELS 8
+#define ADS1298_STATUS_BYTES 3
+#define ADS1298_SAMPLE_BYTES 3
+#define ADS1298_FRAME_BYTES (ADS1298_STATUS_BYTES + ADS1298_NUM_CHANNELS * ADS1298_SAMPLE_BYTES)
+
+/* 9.5.5.2 Daisy-chain, devices behind one CS shift their frames out back to back */
+#define ADS1298_MAX_DEVICES 2
+#define ADS1298_MAX_CHANNELS (ADS1298_NUM_CHANNELS * ADS1298_MAX_DEVICES)
+#define ADS1298_MAX_FRAME_BYTES (ADS1298_FRAME_BYTES * ADS1298_MAX_DEVICES)
+
+#define ADS1298_MAX_REG_RW_BYTES 256
+#define ADS1298_REG_OPCODE_LEN 2 /* 1 byte for command and reg  + 1 byte for length */
+#define ADS1298_SPI_BUF_LEN MAX(ADS1298_MAX_REG_RW_BYTES + ADS1298_REG_OPCODE_LEN, ADS1298_MAX_FRAME_BYTES + 1)
+
+/* Prefixed to the raw frames in every RTIO buffer, see ads1298_decoder.c */
+struct ads1298_encoded_header {
+    uint64_t timestamp_ns; /* First frame */
+    uint32_t period_ns;
+    uint32_t vref_uv;
+    uint16_t num_frames;
+    uint8_t num_channels;
+    uint8_t is_stream;
+    uint8_t gain[ADS1298_MAX_CHANNELS];
+} __packed;
+
+struct ads1298_encoded_data {
+    struct ads1298_encoded_header header;
+    uint8_t frames[];
+} __packed;
 
 struct ads1298_data
 {
-    int32_t pressure;
-    int32_t temperature;
+    const struct device *dev;
+
+    /* Register access and RDATA, SCLK slow enough that no inter-byte delay is needed */
+    struct spi_config cmd_cfg;
+
+    /* Serialises command transfers, owns everything below down to rx_set */
+    struct k_mutex lock;
+    uint8_t tx_buf[ADS1298_SPI_BUF_LEN];
+    uint8_t rx_buf[ADS1298_SPI_BUF_LEN];
+    struct spi_buf tx_spi_buf;
+    struct spi_buf rx_spi_buf;
+    struct spi_buf_set tx_set;
+    struct spi_buf_set rx_set;
+
+    /* Register shadow and registers changed since the last ads1298_reg_sync, also under lock */
+    uint8_t regs[ADS1298_NUM_REGS];
+    uint32_t dirty;
+#if CONFIG_ADS1298_REG_CHECK_INTERVAL_MS > 0
+    struct k_work_delayable reg_check;
+    uint32_t reg_faults; /* Registers found changed and rewritten */
+#endif
+
+    /* Last frame returned by sample_fetch */
+    uint8_t frame[ADS1298_MAX_FRAME_BYTES];
+
+    /* Scaling, kept in step with CONFIG1, CONFIG3 and CHnSET by ads1298_write_reg */
+    uint8_t gain[ADS1298_MAX_CHANNELS];
+    uint32_t vref_uv;
+    uint32_t data_rate_hz;
+
+#ifdef CONFIG_ADS1298_STREAM
+    struct gpio_callback drdy_cb;
+
+    /* Used for RDATAC frame reads only, at the full DT SCLK. SPI_LOCK_ON is set so the bus stays
+     * owned by the stream between frames and the DRDY ISR never has to block on the SPI context lock. */
+    struct spi_config data_cfg;
+    struct spi_buf frame_buf;
+    struct spi_buf_set frame_set;
+
+    /* Single producer (DRDY/SPI completion) single consumer ring of whole frames in
+     * ads1298_dev_config.ring. head and tail are free running, the slot is
+     * index & (CONFIG_ADS1298_RING_FRAMES - 1) */
+    atomic_t head;
+    atomic_t tail;
+    atomic_t watermark; /* Frames the consumer is waiting for, 0 = nobody waiting */
+    atomic_t in_flight;
+    atomic_t dropped;
+    struct k_sem frames_ready;
+    /* Set by ads1298_stream_pause, the next completed frame gives frame_sync */
+    atomic_t sync_req;
+    struct k_sem frame_sync;
+    bool streaming;
+    /* In SDATAC between ads1298_stream_pause and ads1298_stream_resume, registers reachable */
+    bool paused;
+#ifdef CONFIG_SENSOR_ASYNC_API
+    /* Pending streaming read, completed by stream_work once a batch is in the ring */
+    atomic_ptr_t stream_sqe;
+    struct k_work stream_work;
+#endif
+#endif
 };
 
+/* A control pin from the node's own property, else from the board alias the first boards used,
+ * else none */
+#define ADS1298_INST_GPIO(inst, prop, alias)                                                       \
+	COND_CODE_1(DT_INST_NODE_HAS_PROP(inst, prop), (GPIO_DT_SPEC_INST_GET(inst, prop)),        \
+		    (GPIO_DT_SPEC_GET_OR(DT_ALIAS(alias), gpios, {0})))
+
 struct ads1298_dev_config {
 	struct spi_dt_spec bus;
+	uint8_t n_devices; /* Daisy-chain length */
+	/* Optional, a pin left out is taken to be strapped to its run level */
+	struct gpio_dt_spec clksel_gpio;
+	struct gpio_dt_spec nrst_gpio;
+	struct gpio_dt_spec npwdn_gpio;
+	struct gpio_dt_spec start_gpio; /* Without it conversions are started with the START opcode */
+#ifdef CONFIG_ADS1298_STREAM
+	struct gpio_dt_spec drdy_gpio;
+	int8_t drdy_capture; /* Timebase capture channel wired to nDRDY, -1 if none */
+	uint8_t *ring; /* CONFIG_ADS1298_RING_FRAMES frames of ads1298_frame_bytes() */
+	uint64_t *ring_ts; /* Timebase ticks at each frame's nDRDY edge */
+#endif
 };
 
+static inline size_t ads1298_frame_bytes(const struct ads1298_dev_config *cfg)
+{
+    return ADS1298_FRAME_BYTES * cfg->n_devices;
+}
+
+int ads1298_command(const struct device *dev, uint8_t cmd);
+int ads1298_read_frame(const struct device *dev, uint8_t *frame);
+void ads1298_reg_update(const struct device *dev, uint8_t reg, uint8_t mask, uint8_t val);
+int ads1298_reg_sync(const struct device *dev);
+
+#ifdef CONFIG_SENSOR_ASYNC_API
+void ads1298_submit(const struct device *dev, struct rtio_iodev_sqe *iodev_sqe);
+int ads1298_get_decoder(const struct device *dev, const struct sensor_decoder_api **decoder);
+#ifdef CONFIG_ADS1298_STREAM
+void ads1298_rtio_init(const struct device *dev);
+void ads1298_rtio_frames_ready(const struct device *dev);
+#endif
+#endif
+
+#ifdef CONFIG_ADS1298_STREAM
+int ads1298_stream_init(const struct device *dev);
+int ads1298_stream_latest(const struct device *dev, uint8_t *frame);
+uint32_t ads1298_stream_pending(const struct device *dev);
+int ads1298_stream_pause(const struct device *dev);
+int ads1298_stream_resume(const struct device *dev);
+#endif
 
-#endif
\ No newline at end of file
+#endif
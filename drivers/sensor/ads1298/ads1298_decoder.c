@@ -0,0 +1,96 @@
+#define DT_DRV_COMPAT ti_ads1298
+
+#include <zephyr/drivers/sensor.h>
+
+#include <app/drivers/ads1298.h>
+#include "ads1298.h"
+#include "ads1298_utils.h"
+
+/* Frames are only converted here, and only for the channel the caller asks for, so a
+ * consumer that stores or forwards raw batches never pays for the conversion. */
+
+static int ads1298_decoder_get_frame_count(const uint8_t *buffer, struct sensor_chan_spec chan_spec,
+                                           uint16_t *frame_count)
+{
+    const struct ads1298_encoded_header *hdr = (const struct ads1298_encoded_header *)buffer;
+
+    if (chan_spec.chan_type != SENSOR_CHAN_VOLTAGE || chan_spec.chan_idx >= hdr->num_channels) {
+        return -ENOTSUP;
+    }
+
+    *frame_count = hdr->num_frames;
+    return 0;
+}
+
+static int ads1298_decoder_get_size_info(struct sensor_chan_spec chan_spec, size_t *base_size,
+                                         size_t *frame_size)
+{
+    if (chan_spec.chan_type != SENSOR_CHAN_VOLTAGE) {
+        return -ENOTSUP;
+    }
+
+    *base_size = sizeof(struct sensor_q31_data);
+    *frame_size = sizeof(struct sensor_q31_sample_data);
+    return 0;
+}
+
+static int ads1298_decoder_decode(const uint8_t *buffer, struct sensor_chan_spec chan_spec,
+                                  uint32_t *fit, uint16_t max_count, void *data_out)
+{
+    const struct ads1298_encoded_data *edata = (const struct ads1298_encoded_data *)buffer;
+    const struct ads1298_encoded_header *hdr = &edata->header;
+    struct sensor_q31_data *out = data_out;
+    uint16_t count = 0;
+
+    if (chan_spec.chan_type != SENSOR_CHAN_VOLTAGE || chan_spec.chan_idx >= hdr->num_channels) {
+        return -ENOTSUP;
+    }
+    if (*fit >= hdr->num_frames) {
+        return 0;
+    }
+
+    /* A daisy-chain stores each device's frame back to back */
+    const size_t frame_bytes = (hdr->num_channels / ADS1298_NUM_CHANNELS) * ADS1298_FRAME_BYTES;
+    const uint8_t gain = hdr->gain[chan_spec.chan_idx];
+    const uint8_t *sample = &edata->frames[*fit * frame_bytes + ads1298_sample_offset(chan_spec.chan_idx)];
+
+    out->header.base_timestamp_ns = hdr->timestamp_ns + (uint64_t)*fit * hdr->period_ns;
+    out->shift = ADS1298_Q31_SHIFT;
+
+    while (count < max_count && *fit < hdr->num_frames) {
+        out->readings[count].timestamp_delta = count * hdr->period_ns;
+        out->readings[count].value =
+            ads1298_counts_to_q31(ads1298_sample_counts(sample), gain, hdr->vref_uv);
+        sample += frame_bytes;
+        count++;
+        (*fit)++;
+    }
+
+    out->header.reading_count = count;
+    return count;
+}
+
+static bool ads1298_decoder_has_trigger(const uint8_t *buffer, enum sensor_trigger_type trigger)
+{
+    const struct ads1298_encoded_header *hdr = (const struct ads1298_encoded_header *)buffer;
+
+    if (!hdr->is_stream) {
+        return false;
+    }
+    return trigger == SENSOR_TRIG_DATA_READY || trigger == SENSOR_TRIG_FIFO_WATERMARK;
+}
+
+SENSOR_DECODER_API_DT_DEFINE() = {
+    .get_frame_count = ads1298_decoder_get_frame_count,
+    .get_size_info = ads1298_decoder_get_size_info,
+    .decode = ads1298_decoder_decode,
+    .has_trigger = ads1298_decoder_has_trigger,
+};
+
+int ads1298_get_decoder(const struct device *dev, const struct sensor_decoder_api **decoder)
+{
+    ARG_UNUSED(dev);
+    *decoder = &SENSOR_DECODER_NAME();
+
+    return 0;
+}
@@ -0,0 +1,426 @@
+#define DT_DRV_COMPAT ti_ads1298
+
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/emul.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/gpio/gpio_emul.h>
+#include <zephyr/drivers/spi.h>
+#include <zephyr/drivers/spi_emul.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+
+#include <app/drivers/ads1298.h>
+#include <app/drivers/emul_ads1298.h>
+#include "ads1298.h"
+#include "ads1298_utils.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(ads1298_emul, CONFIG_SENSOR_LOG_LEVEL);
+
+/* The chained devices are identical and see the same register writes, so one register map
+ * stands in for all of them and only the frames differ. */
+
+BUILD_ASSERT(IS_POWER_OF_TWO(ADS1298_EMUL_DRDY_HISTORY), "History must be a power of two");
+
+#define LEAD_CHANNELS (ADS1298_NUM_CHANNELS - 1)
+#define SEQ_CHANNEL (ADS1298_NUM_CHANNELS - 1)
+#define SEQ_MASK GENMASK(23, 0)
+
+/* Table 8 reset values */
+static const uint8_t ads1298_emul_defaults[ADS1298_NUM_REGS] = {
+    [ADS1298_REG_ID] = 0x92,
+    [ADS1298_REG_CONFIG1] = 0x06,
+    [ADS1298_REG_CONFIG2] = 0x40,
+    [ADS1298_REG_CONFIG3] = 0x40,
+    [ADS1298_REG_GPIO] = 0x0F,
+};
+
+/* Percent of the synthetic ECG on each of channels 1 to 7, loosely the limb and chest leads */
+static const int8_t ads1298_emul_lead_pct[LEAD_CHANNELS] = {100, 150, 50, -125, 25, 100, 75};
+
+struct ads1298_emul_cfg {
+    uint8_t n_devices;
+    struct gpio_dt_spec drdy_gpio;
+    struct gpio_dt_spec start_gpio;
+};
+
+struct ads1298_emul_data {
+    const struct emul *target;
+    struct k_spinlock lock;
+    struct k_timer drdy_timer;
+
+    uint8_t regs[ADS1298_NUM_REGS];
+    bool rdatac;
+    bool start_cmd;
+
+    /* Latest conversion and whether it has been clocked out yet */
+    uint8_t frame[ADS1298_MAX_FRAME_BYTES];
+    bool unread;
+    uint32_t seq;
+    uint32_t drdy_cycles[ADS1298_EMUL_DRDY_HISTORY];
+    struct ads1298_emul_stats stats;
+
+    const int32_t *playback;
+    uint32_t playback_frames;
+    uint8_t playback_channels;
+    uint32_t playback_pos;
+};
+
+static int32_t tri(int32_t t_us, int32_t centre_us, int32_t half_us, int32_t peak_uv)
+{
+    int32_t d = abs(t_us - centre_us);
+
+    return d < half_us ? (int32_t)(((int64_t)peak_uv * (half_us - d)) / half_us) : 0;
+}
+
+/* One 60 bpm beat of straight line segments, enough for a QRS detector to chew on */
+static int32_t ecg_uv(uint32_t seq, uint32_t rate_hz)
+{
+    int32_t t_us = (int32_t)(((uint64_t)seq * USEC_PER_SEC / rate_hz) % USEC_PER_SEC);
+
+    return tri(t_us, 200000, 40000, 150) +   /* P */
+           tri(t_us, 280000, 10000, -100) +  /* Q */
+           tri(t_us, 300000, 12000, 1000) +  /* R */
+           tri(t_us, 320000, 10000, -200) +  /* S */
+           tri(t_us, 550000, 80000, 300);    /* T */
+}
+
+static int32_t uv_to_counts(int64_t uv, uint8_t gain, uint32_t vref_uv)
+{
+    int64_t counts = (uv * gain * (int64_t)BIT(23)) / vref_uv;
+
+    return (int32_t)CLAMP(counts, -(int64_t)BIT(23), (int64_t)BIT(23) - 1);
+}
+
+/* What the PGA of channel ch sees, in microvolts */
+static int32_t input_uv(struct ads1298_emul_data *data, uint8_t dev_idx, uint8_t ch, uint32_t rate_hz,
+                        int32_t ecg)
+{
+    uint8_t chset = data->regs[ADS1298_REG_CH1SET + ch];
+    uint32_t vref_uv = ads1298_vref_uv(data->regs[ADS1298_REG_CONFIG3]);
+
+    if (chset & ADS1298_CHNSET_PD) {
+        return 0;
+    }
+
+    switch (chset & ADS1298_CHNSET_MUX_MASK) {
+    case ADS1298_MUX_NORMAL:
+        if (data->playback != NULL) {
+            unsigned int idx = dev_idx * ADS1298_NUM_CHANNELS + ch;
+
+            return idx < data->playback_channels
+                ? data->playback[data->playback_pos * data->playback_channels + idx]
+                : 0;
+        }
+        return ch < LEAD_CHANNELS ? (ecg * ads1298_emul_lead_pct[ch]) / 100 : 0;
+    case ADS1298_MUX_TEMPERATURE:
+        return 145300; /* 9.3.1.3.2 at 25 degrees */
+    case ADS1298_MUX_TEST:
+        /* 9.3.1.5 +-1 mV * Vref / 2.4 V square wave at fCLK / 2^21, ~1 Hz */
+        return ((((uint64_t)data->seq * MSEC_PER_SEC / rate_hz) / 512) & 1 ? 1 : -1) *
+               (int32_t)(vref_uv / 2400);
+    default:
+        return 0;
+    }
+}
+
+/* 9.4.4.2 Status word 1100 LOFF_STATP LOFF_STATN GPIO[7:4], then the eight channels */
+static void build_frame(struct ads1298_emul_data *data, const struct ads1298_emul_cfg *cfg)
+{
+    uint32_t rate_hz = ads1298_data_rate_hz(data->regs[ADS1298_REG_CONFIG1]);
+    uint32_t vref_uv = ads1298_vref_uv(data->regs[ADS1298_REG_CONFIG3]);
+    uint8_t statp = data->regs[ADS1298_REG_LOFF_STATP];
+    uint8_t statn = data->regs[ADS1298_REG_LOFF_STATN];
+    int32_t ecg = ecg_uv(data->seq, rate_hz);
+
+    for (uint8_t d = 0; d < cfg->n_devices; d++) {
+        uint8_t *f = &data->frame[d * ADS1298_FRAME_BYTES];
+
+        f[0] = 0xC0 | (statp >> 4);
+        f[1] = (statp << 4) | (statn >> 4);
+        f[2] = (statn << 4) | (data->regs[ADS1298_REG_GPIO] >> 4);
+
+        for (uint8_t ch = 0; ch < ADS1298_NUM_CHANNELS; ch++) {
+            uint8_t gain = ads1298_pga_gain(data->regs[ADS1298_REG_CH1SET + ch]);
+            int32_t counts;
+
+            if (data->playback == NULL && ch == SEQ_CHANNEL) {
+                counts = data->seq & SEQ_MASK;
+            } else {
+                counts = uv_to_counts(input_uv(data, d, ch, rate_hz, ecg), gain, vref_uv);
+            }
+            sys_put_be24((uint32_t)counts & SEQ_MASK, &f[ADS1298_STATUS_BYTES + ch * ADS1298_SAMPLE_BYTES]);
+        }
+    }
+
+    if (data->playback != NULL) {
+        data->playback_pos = (data->playback_pos + 1) % data->playback_frames;
+    }
+}
+
+static bool converting(struct ads1298_emul_data *data, const struct ads1298_emul_cfg *cfg)
+{
+    return data->start_cmd ||
+           (cfg->start_gpio.port != NULL && gpio_emul_output_get(cfg->start_gpio.port, cfg->start_gpio.pin) == 1);
+}
+
+/* A conversion finished. nDRDY is pulsed high then low so that every frame is a falling edge,
+ * whether or not the last one was read, as the part does after 4 tCLK */
+static void ads1298_emul_drdy(struct k_timer *timer)
+{
+    struct ads1298_emul_data *data = CONTAINER_OF(timer, struct ads1298_emul_data, drdy_timer);
+    const struct ads1298_emul_cfg *cfg = data->target->cfg;
+    k_spinlock_key_t key = k_spin_lock(&data->lock);
+
+    if (!converting(data, cfg)) {
+        k_spin_unlock(&data->lock, key);
+        return;
+    }
+
+    if (data->unread) {
+        data->stats.unread++;
+    }
+    build_frame(data, cfg);
+    data->unread = true;
+    data->drdy_cycles[data->seq & (ADS1298_EMUL_DRDY_HISTORY - 1)] = k_cycle_get_32();
+    data->seq++;
+    data->stats.frames++;
+    k_spin_unlock(&data->lock, key);
+
+    if (cfg->drdy_gpio.port == NULL) {
+        return;
+    }
+    /* Outside the lock, the edge runs the driver's handler and with it the frame read */
+    gpio_emul_input_set(cfg->drdy_gpio.port, cfg->drdy_gpio.pin, 1);
+    gpio_emul_input_set(cfg->drdy_gpio.port, cfg->drdy_gpio.pin, 0);
+}
+
+static void drdy_timer_start(struct ads1298_emul_data *data)
+{
+    uint32_t rate_hz = ads1298_data_rate_hz(data->regs[ADS1298_REG_CONFIG1]);
+
+    if (rate_hz == 0) {
+        k_timer_stop(&data->drdy_timer);
+        return;
+    }
+    k_timer_start(&data->drdy_timer, K_NSEC(NSEC_PER_SEC / rate_hz), K_NSEC(NSEC_PER_SEC / rate_hz));
+}
+
+static void reset(struct ads1298_emul_data *data)
+{
+    memcpy(data->regs, ads1298_emul_defaults, sizeof(data->regs));
+    /* 9.5.2.7 The part powers up in RDATAC */
+    data->rdatac = true;
+    data->start_cmd = false;
+}
+
+/* One transaction, CS low to CS high. Returns true if the data rate changed. Caller holds lock */
+static bool transact(struct ads1298_emul_data *data, const struct ads1298_emul_cfg *cfg,
+                     const uint8_t *tx, bool has_tx, uint8_t *rx, size_t len)
+{
+    const size_t frame_bytes = ADS1298_FRAME_BYTES * cfg->n_devices;
+    const uint8_t op = tx[0];
+    const uint8_t reg = op & 0x1F;
+    bool rate_changed = false;
+
+    /* In RDATAC DIN is held low and every transfer clocks out the latest frame */
+    if (data->rdatac && (!has_tx || op == 0)) {
+        memcpy(rx, data->frame, MIN(len, frame_bytes));
+        data->unread = false;
+        return false;
+    }
+
+    switch (op & 0xE0) {
+    case ADS1298_CMD_RREG:
+        /* 9.5.2.7 Register reads and writes are ignored in RDATAC */
+        for (size_t i = 0; !data->rdatac && i <= tx[1] && ADS1298_REG_OPCODE_LEN + i < len; i++) {
+            rx[ADS1298_REG_OPCODE_LEN + i] = reg + i < ADS1298_NUM_REGS ? data->regs[reg + i] : 0;
+        }
+        return false;
+    case ADS1298_CMD_WREG:
+        for (size_t i = 0; !data->rdatac && i <= tx[1] && ADS1298_REG_OPCODE_LEN + i < len; i++) {
+            uint8_t r = reg + i;
+
+            if (r >= ADS1298_NUM_REGS || r == ADS1298_REG_ID || r == ADS1298_REG_LOFF_STATP ||
+                r == ADS1298_REG_LOFF_STATN) {
+                continue;
+            }
+            if (r == ADS1298_REG_CONFIG1 &&
+                ads1298_data_rate_hz(data->regs[r]) != ads1298_data_rate_hz(tx[ADS1298_REG_OPCODE_LEN + i])) {
+                rate_changed = true;
+            }
+            data->regs[r] = tx[ADS1298_REG_OPCODE_LEN + i];
+        }
+        return rate_changed;
+    default:
+        break;
+    }
+
+    switch (op) {
+    case ADS1298_CMD_RDATA:
+        if (!data->rdatac && len > 1) {
+            memcpy(&rx[1], data->frame, MIN(len - 1, frame_bytes));
+            data->unread = false;
+        }
+        break;
+    case ADS1298_CMD_RDATAC:
+        data->rdatac = true;
+        break;
+    case ADS1298_CMD_SDATAC:
+        data->rdatac = false;
+        break;
+    case ADS1298_CMD_START:
+        data->start_cmd = true;
+        break;
+    case ADS1298_CMD_STOP:
+        data->start_cmd = false;
+        break;
+    case ADS1298_CMD_RESET:
+        reset(data);
+        rate_changed = true;
+        break;
+    default:
+        /* WAKEUP, STANDBY and anything unknown */
+        break;
+    }
+    return rate_changed;
+}
+
+static size_t buf_set_len(const struct spi_buf_set *set)
+{
+    size_t len = 0;
+
+    for (size_t i = 0; set != NULL && i < set->count; i++) {
+        len += set->buffers[i].len;
+    }
+    return len;
+}
+
+static int ads1298_emul_io(const struct emul *target, const struct spi_config *config,
+                           const struct spi_buf_set *tx_bufs, const struct spi_buf_set *rx_bufs)
+{
+    const struct ads1298_emul_cfg *cfg = target->cfg;
+    struct ads1298_emul_data *data = target->data;
+    uint8_t tx[ADS1298_SPI_BUF_LEN] = {0};
+    uint8_t rx[ADS1298_SPI_BUF_LEN] = {0};
+    size_t len = MAX(buf_set_len(tx_bufs), buf_set_len(rx_bufs));
+    size_t pos = 0;
+
+    ARG_UNUSED(config);
+
+    if (len == 0 || len > sizeof(tx)) {
+        return -EIO;
+    }
+
+    /* A NULL buffer in a set clocks out zeros */
+    for (size_t i = 0; tx_bufs != NULL && i < tx_bufs->count; i++) {
+        if (tx_bufs->buffers[i].buf != NULL) {
+            memcpy(&tx[pos], tx_bufs->buffers[i].buf, tx_bufs->buffers[i].len);
+        }
+        pos += tx_bufs->buffers[i].len;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&data->lock);
+    bool rate_changed = transact(data, cfg, tx, tx_bufs != NULL, rx, len);
+    k_spin_unlock(&data->lock, key);
+
+    if (rate_changed) {
+        drdy_timer_start(data);
+    }
+
+    pos = 0;
+    for (size_t i = 0; rx_bufs != NULL && i < rx_bufs->count; i++) {
+        if (rx_bufs->buffers[i].buf != NULL) {
+            memcpy(rx_bufs->buffers[i].buf, &rx[pos], rx_bufs->buffers[i].len);
+        }
+        pos += rx_bufs->buffers[i].len;
+    }
+    return 0;
+}
+
+uint8_t ads1298_emul_reg_get(const struct emul *target, uint8_t reg)
+{
+    struct ads1298_emul_data *data = target->data;
+
+    __ASSERT_NO_MSG(reg < ADS1298_NUM_REGS);
+    return data->regs[reg];
+}
+
+void ads1298_emul_reg_set(const struct emul *target, uint8_t reg, uint8_t val)
+{
+    struct ads1298_emul_data *data = target->data;
+
+    __ASSERT_NO_MSG(reg < ADS1298_NUM_REGS);
+    K_SPINLOCK(&data->lock) {
+        data->regs[reg] = val;
+    }
+}
+
+void ads1298_emul_set_playback(const struct emul *target, const int32_t *uv, uint32_t n_frames,
+                               uint8_t n_channels)
+{
+    struct ads1298_emul_data *data = target->data;
+
+    K_SPINLOCK(&data->lock) {
+        data->playback = (n_frames != 0) ? uv : NULL;
+        data->playback_frames = n_frames;
+        data->playback_channels = n_channels;
+        data->playback_pos = 0;
+    }
+}
+
+uint32_t ads1298_emul_drdy_cycles(const struct emul *target, uint32_t seq)
+{
+    struct ads1298_emul_data *data = target->data;
+
+    return data->drdy_cycles[seq & (ADS1298_EMUL_DRDY_HISTORY - 1)];
+}
+
+void ads1298_emul_get_stats(const struct emul *target, struct ads1298_emul_stats *stats)
+{
+    struct ads1298_emul_data *data = target->data;
+
+    K_SPINLOCK(&data->lock) {
+        *stats = data->stats;
+    }
+}
+
+static int ads1298_emul_init(const struct emul *target, const struct device *parent)
+{
+    const struct ads1298_emul_cfg *cfg = target->cfg;
+    struct ads1298_emul_data *data = target->data;
+
+    ARG_UNUSED(parent);
+
+    data->target = target;
+    reset(data);
+    k_timer_init(&data->drdy_timer, ads1298_emul_drdy, NULL);
+
+    if (cfg->drdy_gpio.port != NULL && !device_is_ready(cfg->drdy_gpio.port)) {
+        LOG_ERR("DRDY gpio %s not ready", cfg->drdy_gpio.port->name);
+        return -ENODEV;
+    }
+
+    /* Like the part, conversions are timed from power up whether anyone listens or not */
+    drdy_timer_start(data);
+    return 0;
+}
+
+static struct spi_emul_api ads1298_emul_api = {
+    .io = ads1298_emul_io,
+};
+
+#define ADS1298_EMUL(n)                                                                            \
+	static struct ads1298_emul_data ads1298_emul_data_##n;                                     \
+	static const struct ads1298_emul_cfg ads1298_emul_cfg_##n = {                              \
+		.n_devices = DT_INST_PROP(n, daisy_chain_length),                                  \
+		.drdy_gpio = GPIO_DT_SPEC_INST_GET_OR(n, drdy_gpios, {0}),                         \
+		.start_gpio = ADS1298_INST_GPIO(n, start_gpios, exg_start_conv),                   \
+	};                                                                                         \
+	EMUL_DT_INST_DEFINE(n, ads1298_emul_init, &ads1298_emul_data_##n, &ads1298_emul_cfg_##n,   \
+			    &ads1298_emul_api, NULL)
+
+DT_INST_FOREACH_STATUS_OKAY(ADS1298_EMUL)
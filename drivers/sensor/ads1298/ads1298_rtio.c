@@ -0,0 +1,189 @@
+#include <string.h>
+#include <zephyr/drivers/sensor.h>
+#include <zephyr/kernel.h>
+#include <zephyr/rtio/rtio.h>
+#include <zephyr/sys/util.h>
+
+#include <app/drivers/ads1298.h>
+#include <app/drivers/timebase.h>
+#include "ads1298.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(ADS1298);
+
+/* sensor_read() support. Buffers hold an ads1298_encoded_header followed by raw frames,
+ * conversion to volts is left to the decoder so nothing is done per sample here. */
+
+/* timestamp is in timebase ticks, of the first frame */
+static void ads1298_encode_header(const struct device *dev, struct ads1298_encoded_header *hdr,
+                                  uint64_t timestamp, uint16_t num_frames, bool is_stream)
+{
+    const struct ads1298_dev_config *cfg = dev->config;
+    struct ads1298_data *data = dev->data;
+
+    hdr->period_ns = data->data_rate_hz ? NSEC_PER_SEC / data->data_rate_hz : 0;
+    hdr->timestamp_ns = timebase_ticks_to_ns(timestamp);
+    hdr->vref_uv = data->vref_uv;
+    hdr->num_frames = num_frames;
+    hdr->num_channels = ADS1298_NUM_CHANNELS * cfg->n_devices;
+    hdr->is_stream = is_stream;
+    memcpy(hdr->gain, data->gain, sizeof(hdr->gain));
+}
+
+static void ads1298_submit_one_shot(const struct device *dev, struct rtio_iodev_sqe *iodev_sqe)
+{
+    const uint32_t min_len = sizeof(struct ads1298_encoded_data) + ads1298_frame_bytes(dev->config);
+    struct ads1298_encoded_data *edata;
+    uint8_t *buf;
+    uint32_t buf_len;
+    int ret;
+
+    ret = rtio_sqe_rx_buf(iodev_sqe, min_len, min_len, &buf, &buf_len);
+    if (ret != 0) {
+        LOG_ERR("Failed to get a read buffer of size %u bytes", min_len);
+        rtio_iodev_sqe_err(iodev_sqe, ret);
+        return;
+    }
+    edata = (struct ads1298_encoded_data *)buf;
+
+#ifdef CONFIG_ADS1298_STREAM
+    struct ads1298_data *data = dev->data;
+
+    if (data->streaming) {
+        ret = ads1298_stream_latest(dev, edata->frames);
+    } else
+#endif
+    {
+        ret = ads1298_read_frame(dev, edata->frames);
+    }
+
+    if (ret != 0) {
+        rtio_iodev_sqe_err(iodev_sqe, ret);
+        return;
+    }
+
+    ads1298_encode_header(dev, &edata->header, timebase_now(), 1, false);
+    rtio_iodev_sqe_ok(iodev_sqe, 0);
+}
+
+#ifdef CONFIG_ADS1298_STREAM
+
+/* Copies a batch out of the ring and completes the pending streaming read. Runs on the system
+ * work queue so the SPI ISR is not held up by the copy. Whoever takes the sqe owns the ring
+ * tail. */
+static void ads1298_rtio_stream_work(struct k_work *work)
+{
+    struct ads1298_data *data = CONTAINER_OF(work, struct ads1298_data, stream_work);
+    const struct device *dev = data->dev;
+    struct rtio_iodev_sqe *iodev_sqe = atomic_ptr_get(&data->stream_sqe);
+    const size_t frame_bytes = ads1298_frame_bytes(dev->config);
+    const uint32_t min_len = sizeof(struct ads1298_encoded_data) + frame_bytes;
+    const uint32_t max_len = sizeof(struct ads1298_encoded_data) +
+                             CONFIG_ADS1298_RTIO_BATCH_FRAMES * frame_bytes;
+    struct ads1298_encoded_data *edata;
+    const uint8_t *frames;
+    uint8_t *buf;
+    uint32_t buf_len;
+    uint32_t n_frames;
+    uint64_t timestamp;
+    uint32_t copied = 0;
+
+    if (iodev_sqe == NULL || ads1298_stream_pending(dev) < CONFIG_ADS1298_RTIO_BATCH_FRAMES) {
+        return;
+    }
+    if (!atomic_ptr_cas(&data->stream_sqe, iodev_sqe, NULL)) {
+        return;
+    }
+
+    if (rtio_sqe_rx_buf(iodev_sqe, min_len, max_len, &buf, &buf_len) != 0) {
+        /* Leave the frames in the ring, the next submit will pick them up */
+        rtio_iodev_sqe_err(iodev_sqe, -ENOMEM);
+        return;
+    }
+    edata = (struct ads1298_encoded_data *)buf;
+    n_frames = MIN((buf_len - sizeof(*edata)) / frame_bytes, CONFIG_ADS1298_RTIO_BATCH_FRAMES);
+    timestamp = ads1298_stream_timestamp(dev);
+
+    /* At most two runs, either side of the ring wrap */
+    while (copied < n_frames) {
+        uint32_t run = ads1298_stream_claim(dev, &frames, n_frames - copied);
+
+        memcpy(&edata->frames[copied * frame_bytes], frames, run * frame_bytes);
+        ads1298_stream_release(dev, run);
+        copied += run;
+    }
+
+    ads1298_encode_header(dev, &edata->header, timestamp, n_frames, true);
+    rtio_iodev_sqe_ok(iodev_sqe, 0);
+}
+
+/* Called from the SPI ISR after every frame while a streaming read is pending, and once
+ * from submit in case a batch was already waiting. Only checks and hands over to the work. */
+void ads1298_rtio_frames_ready(const struct device *dev)
+{
+    struct ads1298_data *data = dev->data;
+
+    if (atomic_ptr_get(&data->stream_sqe) != NULL &&
+        ads1298_stream_pending(dev) >= CONFIG_ADS1298_RTIO_BATCH_FRAMES) {
+        k_work_submit(&data->stream_work);
+    }
+}
+
+void ads1298_rtio_init(const struct device *dev)
+{
+    struct ads1298_data *data = dev->data;
+
+    k_work_init(&data->stream_work, ads1298_rtio_stream_work);
+}
+
+static void ads1298_submit_stream(const struct device *dev, struct rtio_iodev_sqe *iodev_sqe)
+{
+    const struct sensor_read_config *read_cfg = iodev_sqe->sqe.iodev->data;
+    struct ads1298_data *data = dev->data;
+    int ret;
+
+    for (size_t i = 0; i < read_cfg->count; i++) {
+        enum sensor_trigger_type trig = read_cfg->triggers[i].trigger;
+
+        if (trig != SENSOR_TRIG_DATA_READY && trig != SENSOR_TRIG_FIFO_WATERMARK) {
+            LOG_ERR("Unsupported stream trigger %d", trig);
+            rtio_iodev_sqe_err(iodev_sqe, -ENOTSUP);
+            return;
+        }
+    }
+
+    if (!atomic_ptr_cas(&data->stream_sqe, NULL, iodev_sqe)) {
+        LOG_ERR("Streaming read already pending");
+        rtio_iodev_sqe_err(iodev_sqe, -EBUSY);
+        return;
+    }
+
+    if (!data->streaming) {
+        ret = ads1298_stream_start(dev);
+        if (ret != 0) {
+            atomic_ptr_clear(&data->stream_sqe);
+            rtio_iodev_sqe_err(iodev_sqe, ret);
+            return;
+        }
+    }
+
+    ads1298_rtio_frames_ready(dev);
+}
+
+#endif
+
+void ads1298_submit(const struct device *dev, struct rtio_iodev_sqe *iodev_sqe)
+{
+    const struct sensor_read_config *read_cfg = iodev_sqe->sqe.iodev->data;
+
+    if (!read_cfg->is_streaming) {
+        ads1298_submit_one_shot(dev, iodev_sqe);
+        return;
+    }
+
+#ifdef CONFIG_ADS1298_STREAM
+    ads1298_submit_stream(dev, iodev_sqe);
+#else
+    rtio_iodev_sqe_err(iodev_sqe, -ENOTSUP);
+#endif
+}
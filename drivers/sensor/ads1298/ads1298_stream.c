@@ -0,0 +1,366 @@
+#define DT_DRV_COMPAT ti_ads1298
+
+#include <string.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/spi.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+
+#include <app/drivers/ads1298.h>
+#include <app/drivers/timebase.h>
+#include "ads1298.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(ADS1298);
+
+/* RDATAC streaming (9.5.2.7). After RDATAC the device shifts out a new frame on every
+ * falling edge of nDRDY without any opcode, so each frame is a single receive-only SPI
+ * transfer. The transfer is started from the DRDY ISR and completes in the SPI ISR, no
+ * thread is involved until the consumer's watermark is reached. */
+
+BUILD_ASSERT(IS_POWER_OF_TWO(CONFIG_ADS1298_RING_FRAMES), "Ring must be a power of two");
+BUILD_ASSERT(ADS1298_FRAME_SIZE == ADS1298_FRAME_BYTES, "Public frame size out of step");
+#define RING_MASK (CONFIG_ADS1298_RING_FRAMES - 1)
+
+/* Longest a frame transfer can take at the slowest SCLK we use */
+#define STOP_TIMEOUT_US 1000
+/* Longer than a frame period at the slowest data rate (250 SPS) */
+#define PAUSE_SYNC_TIMEOUT_MS 10
+
+static inline uint32_t ring_used(struct ads1298_data *data)
+{
+    return (uint32_t)atomic_get(&data->head) - (uint32_t)atomic_get(&data->tail);
+}
+
+static inline uint8_t *ring_slot(const struct ads1298_dev_config *cfg, uint32_t index)
+{
+    return &cfg->ring[(index & RING_MASK) * ads1298_frame_bytes(cfg)];
+}
+
+static void ads1298_frame_done(const struct device *spi, int result, void *userdata)
+{
+    struct ads1298_data *data = userdata;
+
+    if (result == 0) {
+        atomic_inc(&data->head);
+
+        if (atomic_cas(&data->sync_req, 1, 0)) {
+            k_sem_give(&data->frame_sync);
+        }
+
+        uint32_t watermark = atomic_get(&data->watermark);
+        if (watermark != 0 && ring_used(data) >= watermark) {
+            atomic_clear(&data->watermark);
+            k_sem_give(&data->frames_ready);
+        }
+#ifdef CONFIG_SENSOR_ASYNC_API
+        if (atomic_ptr_get(&data->stream_sqe) != NULL) {
+            ads1298_rtio_frames_ready(data->dev);
+        }
+#endif
+    } else {
+        atomic_inc(&data->dropped);
+    }
+    atomic_clear(&data->in_flight);
+}
+
+static void ads1298_drdy_handler(const struct device *port, struct gpio_callback *cb,
+                                 gpio_port_pins_t pins)
+{
+    struct ads1298_data *data = CONTAINER_OF(cb, struct ads1298_data, drdy_cb);
+    const struct ads1298_dev_config *cfg = data->dev->config;
+
+    /* Previous frame still being clocked out, SCLK is too slow for the data rate */
+    if (!atomic_cas(&data->in_flight, 0, 1)) {
+        atomic_inc(&data->dropped);
+        return;
+    }
+
+    /* Consumer has fallen behind, keep what is already in the ring */
+    if (ring_used(data) >= CONFIG_ADS1298_RING_FRAMES) {
+        atomic_inc(&data->dropped);
+        atomic_clear(&data->in_flight);
+        return;
+    }
+
+    /* The captured edge if nDRDY is wired to the timebase, otherwise now, which is later by
+     * the interrupt latency */
+    uint32_t head = atomic_get(&data->head);
+
+    cfg->ring_ts[head & RING_MASK] = (cfg->drdy_capture >= 0)
+        ? timebase_capture_get(cfg->drdy_capture) : timebase_now();
+
+    /* A whole daisy-chain is read in the one burst */
+    data->frame_buf.buf = ring_slot(cfg, head);
+    data->frame_buf.len = ads1298_frame_bytes(cfg);
+
+    /* DIN is held low by the NULL tx set, which the device requires in RDATAC */
+    int ret = spi_transceive_cb(cfg->bus.bus, &data->data_cfg, NULL, &data->frame_set,
+                                ads1298_frame_done, data);
+    if (ret != 0) {
+        atomic_inc(&data->dropped);
+        atomic_clear(&data->in_flight);
+    }
+}
+
+int ads1298_stream_init(const struct device *dev)
+{
+    const struct ads1298_dev_config *cfg = dev->config;
+    struct ads1298_data *data = dev->data;
+    int ret;
+
+    data->data_cfg = cfg->bus.config;
+    data->data_cfg.operation |= SPI_LOCK_ON;
+    data->frame_set.buffers = &data->frame_buf;
+    data->frame_set.count = 1;
+    k_sem_init(&data->frames_ready, 0, 1);
+    k_sem_init(&data->frame_sync, 0, 1);
+#ifdef CONFIG_SENSOR_ASYNC_API
+    ads1298_rtio_init(dev);
+#endif
+
+    if (cfg->drdy_gpio.port == NULL) {
+        LOG_WRN("No drdy-gpios, streaming unavailable");
+        return 0;
+    }
+
+    if (!gpio_is_ready_dt(&cfg->drdy_gpio)) {
+        LOG_ERR("DRDY gpio %s not ready", cfg->drdy_gpio.port->name);
+        return -ENODEV;
+    }
+
+    ret = gpio_pin_configure_dt(&cfg->drdy_gpio, GPIO_INPUT);
+    if (ret != 0) {
+        LOG_ERR("Failed to configure DRDY gpio (%d)", ret);
+        return ret;
+    }
+
+    if (cfg->drdy_capture >= 0) {
+        ret = timebase_capture_enable(cfg->drdy_capture);
+        if (ret != 0) {
+            LOG_ERR("Failed to capture DRDY on timebase channel %d (%d)", cfg->drdy_capture, ret);
+            return ret;
+        }
+    }
+
+    gpio_init_callback(&data->drdy_cb, ads1298_drdy_handler, BIT(cfg->drdy_gpio.pin));
+    ret = gpio_add_callback(cfg->drdy_gpio.port, &data->drdy_cb);
+    if (ret != 0) {
+        LOG_ERR("Failed to add DRDY callback (%d)", ret);
+    }
+    return ret;
+}
+
+/* Send RDATAC and arm nDRDY. Sent on the data config so this transfer also takes the bus
+ * lock for the session */
+static int ads1298_stream_enter(const struct device *dev)
+{
+    const struct ads1298_dev_config *cfg = dev->config;
+    struct ads1298_data *data = dev->data;
+    uint8_t opcode = ADS1298_CMD_RDATAC;
+    const struct spi_buf buf = { .buf = &opcode, .len = 1 };
+    const struct spi_buf_set tx_set = { .buffers = &buf, .count = 1 };
+
+    int ret = spi_write(cfg->bus.bus, &data->data_cfg, &tx_set);
+    if (ret != 0) {
+        LOG_ERR("Failed to enter RDATAC (%d)", ret);
+        spi_release(cfg->bus.bus, &data->data_cfg);
+        return ret;
+    }
+
+    ret = gpio_pin_interrupt_configure_dt(&cfg->drdy_gpio, GPIO_INT_EDGE_TO_ACTIVE);
+    if (ret != 0) {
+        LOG_ERR("Failed to enable DRDY interrupt (%d)", ret);
+        spi_release(cfg->bus.bus, &data->data_cfg);
+        ads1298_command(dev, ADS1298_CMD_SDATAC);
+    }
+    return ret;
+}
+
+/* Disarm nDRDY, let the last frame finish, give the bus back and send SDATAC */
+static int ads1298_stream_exit(const struct device *dev)
+{
+    const struct ads1298_dev_config *cfg = dev->config;
+    struct ads1298_data *data = dev->data;
+
+    gpio_pin_interrupt_configure_dt(&cfg->drdy_gpio, GPIO_INT_DISABLE);
+
+    for (int i = 0; i < STOP_TIMEOUT_US / 10 && atomic_get(&data->in_flight); i++) {
+        k_busy_wait(10);
+    }
+    if (atomic_get(&data->in_flight)) {
+        LOG_WRN("Frame transfer still in flight at stop");
+    }
+
+    spi_release(cfg->bus.bus, &data->data_cfg);
+
+    return ads1298_command(dev, ADS1298_CMD_SDATAC);
+}
+
+int ads1298_stream_start(const struct device *dev)
+{
+    const struct ads1298_dev_config *cfg = dev->config;
+    struct ads1298_data *data = dev->data;
+    int ret;
+
+    if (cfg->drdy_gpio.port == NULL) {
+        return -ENOTSUP;
+    }
+
+    /* Under the register lock, so RDATAC cannot land in the middle of a register check or
+     * attribute write */
+    k_mutex_lock(&data->lock, K_FOREVER);
+    if (data->streaming) {
+        k_mutex_unlock(&data->lock);
+        return -EALREADY;
+    }
+
+    atomic_clear(&data->head);
+    atomic_clear(&data->tail);
+    atomic_clear(&data->watermark);
+    atomic_clear(&data->in_flight);
+    atomic_clear(&data->dropped);
+    atomic_clear(&data->sync_req);
+    k_sem_reset(&data->frames_ready);
+
+    data->paused = false;
+    ret = ads1298_stream_enter(dev);
+    data->streaming = (ret == 0);
+    k_mutex_unlock(&data->lock);
+    return ret;
+}
+
+int ads1298_stream_stop(const struct device *dev)
+{
+    struct ads1298_data *data = dev->data;
+    int ret = 0;
+
+    /* As for start, SDATAC must not land between the commands of a register check */
+    k_mutex_lock(&data->lock, K_FOREVER);
+    if (data->streaming) {
+        data->streaming = false;
+        data->paused = false;
+        ret = ads1298_stream_exit(dev);
+    }
+    k_mutex_unlock(&data->lock);
+    return ret;
+}
+
+/* Drop to SDATAC for register access without ending the stream, the ring and its consumer
+ * are left alone. Waits for the next frame first so the caller has most of a frame period
+ * before the following nDRDY edge would have been due. */
+int ads1298_stream_pause(const struct device *dev)
+{
+    struct ads1298_data *data = dev->data;
+
+    if (!data->streaming) {
+        return 0;
+    }
+
+    k_sem_reset(&data->frame_sync);
+    atomic_set(&data->sync_req, 1);
+    if (k_sem_take(&data->frame_sync, K_MSEC(PAUSE_SYNC_TIMEOUT_MS)) != 0) {
+        /* No frames arriving, nothing to lose by stopping now */
+        atomic_clear(&data->sync_req);
+    }
+
+    int ret = ads1298_stream_exit(dev);
+    if (ret == 0) {
+        data->paused = true;
+    }
+    return ret;
+}
+
+int ads1298_stream_resume(const struct device *dev)
+{
+    struct ads1298_data *data = dev->data;
+
+    if (!data->streaming) {
+        return 0;
+    }
+
+    data->paused = false;
+    int ret = ads1298_stream_enter(dev);
+    if (ret != 0) {
+        data->streaming = false;
+    }
+    return ret;
+}
+
+int ads1298_stream_wait(const struct device *dev, uint32_t min_frames, k_timeout_t timeout)
+{
+    struct ads1298_data *data = dev->data;
+
+    if (min_frames == 0 || min_frames > CONFIG_ADS1298_RING_FRAMES) {
+        return -EINVAL;
+    }
+
+    while (ring_used(data) < min_frames) {
+        atomic_set(&data->watermark, min_frames);
+        /* A frame may have landed between the check and arming the watermark */
+        if (ring_used(data) >= min_frames) {
+            atomic_clear(&data->watermark);
+            break;
+        }
+        if (k_sem_take(&data->frames_ready, timeout) != 0) {
+            atomic_clear(&data->watermark);
+            return -EAGAIN;
+        }
+    }
+    return ring_used(data);
+}
+
+uint32_t ads1298_stream_claim(const struct device *dev, const uint8_t **frames, uint32_t max_frames)
+{
+    const struct ads1298_dev_config *cfg = dev->config;
+    struct ads1298_data *data = dev->data;
+    uint32_t tail = atomic_get(&data->tail);
+    uint32_t slot = tail & RING_MASK;
+    uint32_t n = MIN(ring_used(data), max_frames);
+
+    /* Only hand out the contiguous run up to the end of the ring */
+    n = MIN(n, CONFIG_ADS1298_RING_FRAMES - slot);
+    *frames = ring_slot(cfg, slot);
+    return n;
+}
+
+void ads1298_stream_release(const struct device *dev, uint32_t n_frames)
+{
+    struct ads1298_data *data = dev->data;
+
+    __ASSERT_NO_MSG(n_frames <= ring_used(data));
+    atomic_add(&data->tail, n_frames);
+}
+
+uint64_t ads1298_stream_timestamp(const struct device *dev)
+{
+    const struct ads1298_dev_config *cfg = dev->config;
+    struct ads1298_data *data = dev->data;
+
+    return cfg->ring_ts[(uint32_t)atomic_get(&data->tail) & RING_MASK];
+}
+
+uint32_t ads1298_stream_pending(const struct device *dev)
+{
+    return ring_used(dev->data);
+}
+
+uint32_t ads1298_stream_dropped(const struct device *dev)
+{
+    struct ads1298_data *data = dev->data;
+
+    return atomic_get(&data->dropped);
+}
+
+int ads1298_stream_latest(const struct device *dev, uint8_t *frame)
+{
+    const struct ads1298_dev_config *cfg = dev->config;
+    struct ads1298_data *data = dev->data;
+    uint32_t head = atomic_get(&data->head);
+
+    if (head == 0) {
+        return -EAGAIN;
+    }
+    memcpy(frame, ring_slot(cfg, head - 1), ads1298_frame_bytes(cfg));
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include "ads1298_utils.h"
+
+#include <errno.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+
+/* 24 bit two's complement, full scale is +-(2^23) counts = +-Vref/gain (9.4.4.1) */
+#define ADS1298_FULL_SCALE_BITS 23
+
+#define CHNSET_GAIN_SHIFT 4
+#define CHNSET_GAIN_MASK 0x07
+#define CONFIG1_HR BIT(7)
+#define CONFIG1_DR_MASK 0x07
+#define CONFIG1_DR_RESERVED 0x07
+#define CONFIG3_VREF_4V BIT(5)
+
+int32_t ads1298_sample_counts(const uint8_t *sample)
+{
+    return sign_extend(sys_get_be24(sample), 23);
+}
+
+/* Table 14 CHnSET GAIN[2:0] */
+uint8_t ads1298_pga_gain(uint8_t chset)
+{
+    static const uint8_t gains[] = {6, 1, 2, 3, 4, 8, 12, 0};
+
+    return gains[(chset >> CHNSET_GAIN_SHIFT) & CHNSET_GAIN_MASK];
+}
+
+/* GAIN[2:0] for a gain, ready to be shifted into CHnSET */
+int ads1298_pga_gain_code(uint8_t gain)
+{
+    for (uint8_t code = 0; code <= CHNSET_GAIN_MASK; code++) {
+        if (gain != 0 && ads1298_pga_gain(code << CHNSET_GAIN_SHIFT) == gain) {
+            return code;
+        }
+    }
+    return -EINVAL;
+}
+
+/* Table 10 CONFIG1 DR[2:0], each step halves the rate, low power mode runs at half of HR */
+uint32_t ads1298_data_rate_hz(uint8_t config1)
+{
+    uint8_t dr = config1 & CONFIG1_DR_MASK;
+
+    if (dr == CONFIG1_DR_RESERVED) {
+        return 0;
+    }
+    return ((config1 & CONFIG1_HR) ? 32000 : 16000) >> dr;
+}
+
+/* HR and DR[2:0] for an exact rate. HR is preferred when both modes can do it, low power
+ * mode is only needed for 250 SPS */
+int ads1298_data_rate_config1(uint32_t hz)
+{
+    for (uint8_t dr = 0; dr < CONFIG1_DR_RESERVED; dr++) {
+        if (ads1298_data_rate_hz(CONFIG1_HR | dr) == hz) {
+            return CONFIG1_HR | dr;
+        }
+    }
+    for (uint8_t dr = 0; dr < CONFIG1_DR_RESERVED; dr++) {
+        if (ads1298_data_rate_hz(dr) == hz) {
+            return dr;
+        }
+    }
+    return -EINVAL;
+}
+
+/* Table 12 CONFIG3 VREF_4V */
+uint32_t ads1298_vref_uv(uint8_t config3)
+{
+    return (config3 & CONFIG3_VREF_4V) ? 4000000 : 2400000;
+}
+
+int64_t ads1298_counts_to_uv(int32_t counts, uint8_t gain, uint32_t vref_uv)
+{
+    if (gain == 0) {
+        return 0;
+    }
+    return ((int64_t)counts * vref_uv) / ((int64_t)gain << ADS1298_FULL_SCALE_BITS);
+}
+
+q31_t ads1298_counts_to_q31(int32_t counts, uint8_t gain, uint32_t vref_uv)
+{
+    if (gain == 0) {
+        return 0;
+    }
+    /* volts * 2^(31 - shift) = counts * Vref / (gain * 2^23) * 2^(31 - shift) */
+    return (q31_t)(((int64_t)counts * vref_uv << (31 - ADS1298_Q31_SHIFT - ADS1298_FULL_SCALE_BITS)) /
+                   ((int64_t)gain * 1000000));
+}
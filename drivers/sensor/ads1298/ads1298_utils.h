@@ -0,0 +1,15 @@
+#pragma once
+#include "stdint.h"
+#include <zephyr/dsp/types.h>
+
+/* Decoded values are q31 volts with this shift, +-4 V covers Vref 4 V at gain 1 */
+#define ADS1298_Q31_SHIFT 2
+
+int32_t ads1298_sample_counts(const uint8_t *sample);
+uint8_t ads1298_pga_gain(uint8_t chset);
+int ads1298_pga_gain_code(uint8_t gain);
+uint32_t ads1298_data_rate_hz(uint8_t config1);
+int ads1298_data_rate_config1(uint32_t hz);
+uint32_t ads1298_vref_uv(uint8_t config3);
+int64_t ads1298_counts_to_uv(int32_t counts, uint8_t gain, uint32_t vref_uv);
+q31_t ads1298_counts_to_q31(int32_t counts, uint8_t gain, uint32_t vref_uv);
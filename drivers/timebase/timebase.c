@@ -0,0 +1,138 @@
+#include <errno.h>
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/init.h>
+#include <zephyr/kernel.h>
+#include <zephyr/spinlock.h>
+#include <zephyr/sys/util.h>
+
+#include <app/drivers/timebase.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(timebase, LOG_LEVEL_INF);
+
+#ifdef CONFIG_TIMEBASE_MCUX_CTIMER
+#include <fsl_ctimer.h>
+#include <zephyr/drivers/clock_control.h>
+
+#define TIMEBASE_NODE DT_CHOSEN(app_timebase)
+#define TIMEBASE_CAPTURE_CHANNELS 4
+
+static CTIMER_Type *const base = (CTIMER_Type *)DT_REG_ADDR(TIMEBASE_NODE);
+#endif
+
+/* The counter is 32 bits, last holds every bit of the most recent reading. Reading it at
+ * least every half wrap keeps the extension unambiguous. */
+static struct k_spinlock lock;
+static uint64_t last;
+static uint32_t freq_hz;
+static struct k_timer keepalive;
+
+static inline uint32_t counter_read(void)
+{
+#ifdef CONFIG_TIMEBASE_MCUX_CTIMER
+	return base->TC;
+#else
+	return k_cycle_get_32();
+#endif
+}
+
+uint64_t timebase_now(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	uint64_t now = last + (uint32_t)(counter_read() - (uint32_t)last);
+
+	last = now;
+	k_spin_unlock(&lock, key);
+	return now;
+}
+
+uint32_t timebase_freq_hz(void)
+{
+	return freq_hz;
+}
+
+uint64_t timebase_ticks_to_ns(uint64_t ticks)
+{
+	/* The timebase failed to start */
+	if (freq_hz == 0) {
+		return 0;
+	}
+
+	/* Split so that ticks * 10^9 cannot overflow */
+	return (ticks / freq_hz) * NSEC_PER_SEC + ((ticks % freq_hz) * NSEC_PER_SEC) / freq_hz;
+}
+
+int timebase_capture_enable(uint8_t channel)
+{
+#ifdef CONFIG_TIMEBASE_MCUX_CTIMER
+	if (channel >= TIMEBASE_CAPTURE_CHANNELS) {
+		return -EINVAL;
+	}
+	CTIMER_SetupCapture(base, (ctimer_capture_channel_t)channel, kCTIMER_Capture_FallEdge,
+			    false);
+	return 0;
+#else
+	ARG_UNUSED(channel);
+	return -ENOTSUP;
+#endif
+}
+
+uint64_t timebase_capture_get(uint8_t channel)
+{
+#ifdef CONFIG_TIMEBASE_MCUX_CTIMER
+	/* Capture first so that it is never later than now */
+	uint32_t capture = base->CR[channel];
+	uint64_t now = timebase_now();
+
+	return now - (uint32_t)((uint32_t)now - capture);
+#else
+	ARG_UNUSED(channel);
+	return timebase_now();
+#endif
+}
+
+static void keepalive_handler(struct k_timer *timer)
+{
+	ARG_UNUSED(timer);
+	(void)timebase_now();
+}
+
+static int timebase_init(void)
+{
+#ifdef CONFIG_TIMEBASE_MCUX_CTIMER
+	const struct device *clk = DEVICE_DT_GET(DT_CLOCKS_CTLR(TIMEBASE_NODE));
+	ctimer_config_t config;
+
+	if (!device_is_ready(clk)) {
+		LOG_ERR("Clock controller not ready");
+		return -ENODEV;
+	}
+	if (clock_control_get_rate(clk, (clock_control_subsys_t)DT_CLOCKS_CELL(TIMEBASE_NODE, name),
+				   &freq_hz) != 0 ||
+	    freq_hz == 0) {
+		LOG_ERR("No CTIMER clock rate, timestamps unavailable");
+		freq_hz = 0;
+		return -EINVAL;
+	}
+
+	CTIMER_GetDefaultConfig(&config);
+	config.prescale = 0;
+	CTIMER_Init(base, &config);
+	CTIMER_StartTimer(base);
+#else
+	freq_hz = sys_clock_hw_cycles_per_sec();
+#endif
+
+	/* Half a wrap, 14 s at 150 MHz */
+	uint32_t period_ms = MAX((uint32_t)((BIT64(31) * MSEC_PER_SEC) / freq_hz), 1);
+
+	last = counter_read();
+	k_timer_init(&keepalive, keepalive_handler, NULL);
+	k_timer_start(&keepalive, K_MSEC(period_ms), K_MSEC(period_ms));
+
+	LOG_INF("%u Hz", freq_hz);
+	return 0;
+}
+
+SYS_INIT(timebase_init, POST_KERNEL, CONFIG_TIMEBASE_INIT_PRIORITY);
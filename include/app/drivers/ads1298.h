@@ -0,0 +1,190 @@
+#ifndef APP_DRIVERS_ADS1298_H_
+#define APP_DRIVERS_ADS1298_H_
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/sensor.h>
+#include <zephyr/kernel.h>
+
+/**
+ * @defgroup drivers_ads1298 ADS1298 ExG front end
+ * @ingroup drivers
+ * @{
+ *
+ * @brief Extensions to the sensor API for the TI ADS1298.
+ *
+ * The standard sensor API cannot keep up with continuous ExG acquisition, so the
+ * driver also exposes its RDATAC frame ring directly. Frames are the raw device
+ * output: a 24 bit status word followed by eight big endian 24 bit two's
+ * complement samples. Devices in a daisy-chain are read in one burst and their
+ * frames are stored back to back, nearest the MCU first, so channel 8 is the
+ * first channel of the second device.
+ */
+
+/** Bytes in one device's frame as clocked out of the device */
+#define ADS1298_FRAME_SIZE 27
+
+/** Channels per device */
+#define ADS1298_DEVICE_CHANNELS 8
+
+/**
+ * @brief Byte offset of channel @p ch within a (possibly chained) frame.
+ */
+static inline size_t ads1298_sample_offset(unsigned int ch)
+{
+	return (ch / ADS1298_DEVICE_CHANNELS) * ADS1298_FRAME_SIZE + 3 +
+	       (ch % ADS1298_DEVICE_CHANNELS) * 3;
+}
+
+/**
+ * @brief Bytes per ring frame, ADS1298_FRAME_SIZE times the daisy-chain length.
+ */
+size_t ads1298_frame_size(const struct device *dev);
+
+/**
+ * @brief Channels per ring frame across the whole daisy-chain.
+ */
+unsigned int ads1298_num_channels(const struct device *dev);
+
+/**
+ * @brief Current PGA gain of every channel and the reference voltage.
+ *
+ * Needed to scale frames taken from the ring with ads1298_stream_claim().
+ *
+ * @param gain Filled with ads1298_num_channels() gains, 0 for a reserved code.
+ * @param vref_uv Set to the reference voltage in microvolts.
+ */
+void ads1298_get_scaling(const struct device *dev, uint8_t *gain, uint32_t *vref_uv);
+
+/**
+ * @brief Per electrode channels for sensor_channel_get(), channel n is
+ * SENSOR_CHAN_ADS1298_CH1 + n. Values are in volts.
+ *
+ * With the async API use SENSOR_CHAN_VOLTAGE and chan_idx instead.
+ */
+enum sensor_channel_ads1298 {
+	SENSOR_CHAN_ADS1298_CH1 = SENSOR_CHAN_PRIV_START,
+};
+
+/**
+ * @brief Private attributes for sensor_attr_set().
+ *
+ * These apply to SENSOR_CHAN_ADS1298_CH1 + n, or to every channel when set on
+ * SENSOR_CHAN_ALL or SENSOR_CHAN_VOLTAGE. The chained devices share DIN and
+ * receive the same register writes, so channel n and n + 8 always change
+ * together. SENSOR_ATTR_SAMPLING_FREQUENCY is device wide and accepts the rates
+ * in datasheet table 10, 250 SPS to 32 kSPS.
+ *
+ * When streaming, the stream is paused for the register write right after a
+ * frame and resumes with the ring intact. Setting a value that is already in
+ * place does not touch the device.
+ */
+enum sensor_attribute_ads1298 {
+	/** PGA gain, one of 1, 2, 3, 4, 6, 8 or 12 */
+	SENSOR_ATTR_ADS1298_GAIN = SENSOR_ATTR_PRIV_START,
+	/** Input selection, an enum ads1298_mux */
+	SENSOR_ATTR_ADS1298_MUX,
+	/** Non-zero powers the channel down */
+	SENSOR_ATTR_ADS1298_POWER_DOWN,
+	/**
+	 * Lead-off detection on both inputs of the channel, an enum
+	 * ads1298_lead_off. DC or AC excitation is device wide, the last
+	 * mode set applies to every channel with detection on.
+	 */
+	SENSOR_ATTR_ADS1298_LEAD_OFF,
+	/** Device wide lead-off current in nA, one of 6, 12, 18 or 24 */
+	SENSOR_ATTR_ADS1298_LEAD_OFF_CURRENT,
+	/**
+	 * Non-zero powers up the Wilson central terminal for 12-lead ECG,
+	 * device wide. It averages the limb electrodes wired as LA on IN2P,
+	 * RA on IN2N and IN3N, and LL on IN3P, so channel 2 is lead I and
+	 * channel 3 lead II, see exg_leads.
+	 */
+	SENSOR_ATTR_ADS1298_WCT,
+};
+
+/** Values for SENSOR_ATTR_ADS1298_LEAD_OFF */
+enum ads1298_lead_off {
+	ADS1298_LEAD_OFF_NONE = 0,
+	/** Comparators report in every frame's status word, see exg_leadoff */
+	ADS1298_LEAD_OFF_DC = 1,
+	/** Excitation at fs / 4 appears in the samples, see exg_impedance */
+	ADS1298_LEAD_OFF_AC = 2,
+};
+
+/** CHnSET MUX[2:0] values for SENSOR_ATTR_ADS1298_MUX */
+enum ads1298_mux {
+	/** Electrode input */
+	ADS1298_MUX_NORMAL = 0,
+	/** Inputs shorted together, for offset and noise measurement */
+	ADS1298_MUX_SHORTED = 1,
+	/** (AVDD - AVSS) / 2 on channels 1, 2, 5-8, DVDD / 4 on channels 3 and 4 */
+	ADS1298_MUX_SUPPLY = 3,
+	/** Internal temperature sensor */
+	ADS1298_MUX_TEMPERATURE = 4,
+	/** Internal square wave test signal */
+	ADS1298_MUX_TEST = 5,
+};
+
+/**
+ * @brief Enter RDATAC mode and start filling the frame ring from nDRDY.
+ *
+ * The SPI bus is held by the stream until ads1298_stream_stop().
+ *
+ * @retval 0 if successful.
+ * @retval -ENOTSUP if the devicetree node has no drdy-gpios.
+ * @retval -EALREADY if already streaming.
+ */
+int ads1298_stream_start(const struct device *dev);
+
+/**
+ * @brief Stop streaming and return the device to SDATAC mode.
+ */
+int ads1298_stream_stop(const struct device *dev);
+
+/**
+ * @brief Block until at least @p min_frames are waiting in the ring.
+ *
+ * The consumer is woken once per call rather than once per frame.
+ *
+ * @return Number of frames available, -EAGAIN on timeout, -EINVAL if
+ * @p min_frames is zero or larger than the ring.
+ */
+int ads1298_stream_wait(const struct device *dev, uint32_t min_frames, k_timeout_t timeout);
+
+/**
+ * @brief Borrow the oldest unread frames without copying.
+ *
+ * @param frames Set to the first frame, frames are ads1298_frame_size() apart.
+ * @param max_frames Most frames wanted.
+ *
+ * @return Number of contiguous frames at @p frames. This can be less than are
+ * available when the run wraps the end of the ring, call again after release.
+ */
+uint32_t ads1298_stream_claim(const struct device *dev, const uint8_t **frames, uint32_t max_frames);
+
+/**
+ * @brief Time of the oldest unread frame, the first one the next
+ * ads1298_stream_claim() returns.
+ *
+ * Frames are stamped at their nDRDY edge on the shared timebase, captured in
+ * hardware when the devicetree node has drdy-capture-channel. Only valid while
+ * ads1298_stream_pending() is non-zero.
+ *
+ * @return Timebase ticks, see timebase_ticks_to_ns().
+ */
+uint64_t ads1298_stream_timestamp(const struct device *dev);
+
+/**
+ * @brief Hand back frames obtained from ads1298_stream_claim().
+ */
+void ads1298_stream_release(const struct device *dev, uint32_t n_frames);
+
+/**
+ * @brief Frames lost since the stream started, either to a full ring or to an
+ * nDRDY edge arriving while the previous frame was still being read.
+ */
+uint32_t ads1298_stream_dropped(const struct device *dev);
+
+/** @} */
+
+#endif /* APP_DRIVERS_ADS1298_H_ */
@@ -0,0 +1,79 @@
+#ifndef APP_DRIVERS_EMUL_ADS1298_H_
+#define APP_DRIVERS_EMUL_ADS1298_H_
+
+#include <stdint.h>
+#include <zephyr/drivers/emul.h>
+
+/**
+ * @defgroup drivers_ads1298_emul ADS1298 emulator
+ * @ingroup drivers
+ * @{
+ *
+ * @brief SPI emulator for the TI ADS1298, for running the driver on native_sim.
+ *
+ * Sits on a zephyr,spi-emul-controller in place of the ti,ads1298 node and
+ * answers the same opcodes as the part: RREG, WREG, RDATA, RDATAC, SDATAC,
+ * START, STOP and RESET. While converting, started either by START or by the
+ * exg-start-conv pin, nDRDY is pulsed on its gpio-emul pin at the rate set in
+ * CONFIG1 and a new frame is ready to be clocked out.
+ *
+ * By default the frames hold a synthetic 60 bpm ECG on channels 1 to 7 of
+ * every chained device and a 24 bit frame sequence number on channel 8, which
+ * lets a consumer spot lost frames and look up when each one was converted.
+ * ads1298_emul_set_playback() replaces this with a recording.
+ */
+
+/** Frames for which ads1298_emul_drdy_cycles() remembers the nDRDY time */
+#define ADS1298_EMUL_DRDY_HISTORY 1024
+
+/** Counters since the emulator started */
+struct ads1298_emul_stats {
+	/** Conversions completed, one nDRDY pulse each */
+	uint32_t frames;
+	/** Frames overwritten by the next conversion before they were read */
+	uint32_t unread;
+};
+
+/**
+ * @brief Register as the emulated device holds it.
+ */
+uint8_t ads1298_emul_reg_get(const struct emul *target, uint8_t reg);
+
+/**
+ * @brief Change a register behind the driver's back.
+ *
+ * Also the way to inject lead-off, LOFF_STATP and LOFF_STATN go out in the
+ * status word of every following frame.
+ */
+void ads1298_emul_reg_set(const struct emul *target, uint8_t reg, uint8_t val);
+
+/**
+ * @brief Play back a recording instead of the synthetic ECG.
+ *
+ * The recording loops and must stay valid while it is in use. Samples are
+ * scaled with the channel's current gain and reference like a real input.
+ *
+ * @param uv Samples in microvolts, @p n_channels per frame.
+ * @param n_frames Frames in @p uv, 0 or a NULL @p uv goes back to the synthetic ECG.
+ * @param n_channels Channels per frame, at most 8 per chained device.
+ */
+void ads1298_emul_set_playback(const struct emul *target, const int32_t *uv, uint32_t n_frames,
+			       uint8_t n_channels);
+
+/**
+ * @brief k_cycle_get_32() at the nDRDY edge of frame @p seq.
+ *
+ * @param seq Sequence number from channel 8 of the synthetic ECG.
+ *
+ * @return Cycle count, only meaningful for the last ADS1298_EMUL_DRDY_HISTORY frames.
+ */
+uint32_t ads1298_emul_drdy_cycles(const struct emul *target, uint32_t seq);
+
+/**
+ * @brief Conversion and overrun counters.
+ */
+void ads1298_emul_get_stats(const struct emul *target, struct ads1298_emul_stats *stats);
+
+/** @} */
+
+#endif /* APP_DRIVERS_EMUL_ADS1298_H_ */
@@ -0,0 +1,62 @@
+#ifndef APP_DRIVERS_TIMEBASE_H_
+#define APP_DRIVERS_TIMEBASE_H_
+
+#include <stdint.h>
+
+/**
+ * @defgroup drivers_timebase Shared timebase
+ * @ingroup drivers
+ * @{
+ *
+ * @brief One free running 64 bit clock for timestamping every sensor stream.
+ *
+ * With a CTIMER chosen as app,timebase it counts at the CTIMER clock, 150 MHz
+ * on db1, and edges routed to the timer's capture inputs are timestamped in
+ * hardware with no interrupt latency. Without one it falls back to the kernel
+ * cycle counter and captures are unavailable.
+ *
+ * The hardware counter is 32 bits wide and extended in software, which needs
+ * timebase_now() to be called at least once per wrap. A timer takes care of
+ * that.
+ */
+
+/**
+ * @brief Ticks since boot.
+ *
+ * Callable from any context.
+ */
+uint64_t timebase_now(void);
+
+/**
+ * @brief Ticks per second, 0 if the timebase failed to start.
+ */
+uint32_t timebase_freq_hz(void);
+
+/**
+ * @brief Convert ticks to nanoseconds, 0 if the timebase failed to start.
+ */
+uint64_t timebase_ticks_to_ns(uint64_t ticks);
+
+/**
+ * @brief Start timestamping falling edges on a capture input.
+ *
+ * Which pin drives which capture channel is board wiring, set up through
+ * pinctrl and INPUTMUX.
+ *
+ * @retval 0 if successful.
+ * @retval -ENOTSUP without a CTIMER timebase.
+ * @retval -EINVAL if @p channel does not exist.
+ */
+int timebase_capture_enable(uint8_t channel);
+
+/**
+ * @brief Time of the last edge captured on @p channel.
+ *
+ * Must be read before the timer wraps again, e.g. from the edge's own
+ * interrupt.
+ */
+uint64_t timebase_capture_get(uint8_t channel);
+
+/** @} */
+
+#endif /* APP_DRIVERS_TIMEBASE_H_ */
@@ -0,0 +1,157 @@
+#ifndef APP_LIB_AUDIO_CLS_H_
+#define APP_LIB_AUDIO_CLS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @defgroup lib_audio_cls Cough and snore classifier
+ * @ingroup lib
+ * @{
+ *
+ * @brief Fixed point tree ensemble over the audio_feat band levels.
+ *
+ * Feature frames are averaged over segments of a few frames. Each band keeps
+ * a background level that follows quieter segments at once and louder ones
+ * slowly, and a segment is stored as its levels above that background, so a
+ * model does not depend on the microphone gain or the room.
+ *
+ * An inference looks at the last n_segments segments. Every tree walks from
+ * its root comparing one segment's level in one band against a split until
+ * it reaches a leaf, and the leaf scores of each class's trees are summed. A
+ * class whose score reaches its threshold, having been below it, is an
+ * event, stamped with the start of the newest segment.
+ *
+ * Inferences wait until a batch of segments is ready and then run back to
+ * back, so the model tables are fetched once per batch rather than once per
+ * segment. Frames still have to be pushed as they come, only the inference
+ * work is batched. Everything is integer arithmetic on the Q7 dB levels.
+ */
+
+/** Classes of event */
+enum audio_cls_class {
+	AUDIO_CLS_COUGH,
+	AUDIO_CLS_SNORE,
+	AUDIO_CLS_CLASSES,
+};
+
+/** Feature of a leaf node */
+#define AUDIO_CLS_LEAF UINT16_MAX
+
+/** A split, or a leaf when feature is AUDIO_CLS_LEAF */
+struct audio_cls_node {
+	/** Level compared, segment * n_bands + band, segment 0 the oldest */
+	uint16_t feature;
+	/** Split level in audio_feat units, or the leaf's score */
+	int16_t value;
+	/** Next node when the level is below value */
+	uint16_t below;
+	/** Next node otherwise */
+	uint16_t above;
+};
+
+/** A tree and the class its leaves score for */
+struct audio_cls_tree {
+	uint16_t root;
+	uint8_t cls;
+};
+
+/** A trained or hand-set ensemble */
+struct audio_cls_model {
+	/** Bands of the feature frames, as configured in audio_feat */
+	uint8_t n_bands;
+	/** Feature frames averaged into a segment */
+	uint8_t segment_frames;
+	/** Segments an inference looks at */
+	uint8_t n_segments;
+	uint8_t n_trees;
+	uint16_t n_nodes;
+	const struct audio_cls_tree *trees;
+	const struct audio_cls_node *nodes;
+	/** Score at which each class is an event */
+	int32_t threshold[AUDIO_CLS_CLASSES];
+};
+
+/**
+ * @brief A hand-set model for AUDIO_FEAT_CONFIG_DEFAULT features.
+ *
+ * Four 80 ms segments. A cough is a broadband onset after a quieter
+ * segment, a snore lasting low frequency energy without much above 2 kHz.
+ */
+extern const struct audio_cls_model audio_cls_default_model;
+
+/**
+ * @brief Receives every event.
+ *
+ * @param timestamp Start of the segment in which the score crossed the threshold.
+ */
+typedef void (*audio_cls_sink_t)(enum audio_cls_class cls, uint64_t timestamp, int32_t score,
+				 void *user_data);
+
+/** Classifier state */
+struct audio_cls {
+	const struct audio_cls_model *model;
+	audio_cls_sink_t sink;
+	void *user_data;
+	uint8_t batch;
+	/* Segment being averaged */
+	int32_t sum[CONFIG_AUDIO_FEAT_MAX_BANDS];
+	uint8_t frames;
+	uint64_t segment_ts;
+	/* Background level of each band, valid once a segment is complete */
+	int16_t floor[CONFIG_AUDIO_FEAT_MAX_BANDS];
+	/* Segments above the background, segment n in slot n % CONFIG_AUDIO_CLS_MAX_SEGMENTS */
+	int16_t level[CONFIG_AUDIO_CLS_MAX_SEGMENTS][CONFIG_AUDIO_FEAT_MAX_BANDS];
+	uint64_t level_ts[CONFIG_AUDIO_CLS_MAX_SEGMENTS];
+	uint32_t segments;
+	/* Segments up to which inference has run */
+	uint32_t done;
+	bool active[AUDIO_CLS_CLASSES];
+	/** Inferences run */
+	uint32_t inferences;
+	/** Segments never inferred on because audio_cls_run() was late */
+	uint32_t skipped;
+	/** Events passed to the sink */
+	uint32_t events[AUDIO_CLS_CLASSES];
+};
+
+/**
+ * @brief Set up a classifier running @p batch inferences at a time.
+ *
+ * @retval 0 if successful.
+ * @retval -EINVAL if the model does not fit the Kconfig limits, refers to a
+ * feature or node it does not have, or context and batch together are more
+ * than CONFIG_AUDIO_CLS_MAX_SEGMENTS.
+ */
+int audio_cls_init(struct audio_cls *cls, const struct audio_cls_model *model, uint8_t batch,
+		   audio_cls_sink_t sink, void *user_data);
+
+/**
+ * @brief Drop the segment being averaged, e.g. after a gap in the audio.
+ *
+ * The next frame starts a new segment. Stored segments and the background
+ * are kept.
+ */
+void audio_cls_reset(struct audio_cls *cls);
+
+/**
+ * @brief Add a feature frame, e.g. from an audio_feat sink.
+ *
+ * Frames with other than the model's n_bands are ignored.
+ *
+ * @return true once a batch is waiting for audio_cls_run().
+ */
+bool audio_cls_push(struct audio_cls *cls, const int16_t *feat, uint8_t n_feat,
+		    uint64_t timestamp);
+
+/**
+ * @brief Run every waiting inference, passing events to the sink.
+ *
+ * Meant for a low priority thread. Not to be called concurrently with
+ * audio_cls_push().
+ */
+void audio_cls_run(struct audio_cls *cls);
+
+/** @} */
+
+#endif /* APP_LIB_AUDIO_CLS_H_ */
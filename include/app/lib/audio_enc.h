@@ -0,0 +1,92 @@
+#ifndef APP_LIB_AUDIO_ENC_H_
+#define APP_LIB_AUDIO_ENC_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @defgroup lib_audio_enc Audio block encoder
+ * @ingroup lib
+ * @{
+ *
+ * @brief Streaming encoders for 16 bit PCM blocks from the capture pipe.
+ *
+ * The input is interleaved frames as the SAI DMA writes them. Every encoded
+ * block decodes on its own, so a block lost in storage or on the uplink does
+ * not corrupt the ones after it, while the encoder carries its state from
+ * block to block so there is no discontinuity at block edges.
+ *
+ * Formats are entries in a table of encode and decode functions, a new codec
+ * adds an entry and a value to enum audio_enc_format.
+ *
+ * IMA-ADPCM's per channel header costs a block of n frames 4 bytes on top of
+ * the n / 2 bytes of codes, so audio.c's 32 frame blocks shrink 3.2:1 rather
+ * than 4:1. The encoder is not yet registered on the capture pipe.
+ */
+
+/** Most interleaved channels in a frame */
+#define AUDIO_ENC_MAX_CHANNELS 2
+
+/** Bytes in front of every channel of an IMA-ADPCM block */
+#define AUDIO_ENC_IMA_HEADER_BYTES 4
+
+enum audio_enc_format {
+	/**
+	 * IMA-ADPCM, 4 bits a sample. Every channel of a block starts with a
+	 * little endian int16 predictor, the step index and a zero byte, then
+	 * the codes, two to a byte with the earlier sample in the low nibble.
+	 * Frames per block must be even.
+	 */
+	AUDIO_ENC_IMA_ADPCM,
+	/** G.711 mu-law, 8 bits a sample, interleaved as the input */
+	AUDIO_ENC_MULAW,
+	AUDIO_ENC_FORMATS,
+};
+
+/** Encoder state */
+struct audio_enc {
+	enum audio_enc_format format;
+	uint8_t n_channels;
+	/* IMA-ADPCM predictor and step index per channel */
+	int16_t predictor[AUDIO_ENC_MAX_CHANNELS];
+	uint8_t index[AUDIO_ENC_MAX_CHANNELS];
+};
+
+/**
+ * @brief Set up an encoder.
+ *
+ * @retval 0 if successful.
+ * @retval -EINVAL for an unknown format, no channels or more than
+ * AUDIO_ENC_MAX_CHANNELS.
+ */
+int audio_enc_init(struct audio_enc *enc, enum audio_enc_format format, uint8_t n_channels);
+
+/**
+ * @brief Bytes an encoded block of @p n_frames takes, the same for every
+ * block, or 0 if @p format cannot code that many frames.
+ */
+size_t audio_enc_block_bytes(enum audio_enc_format format, uint8_t n_channels, size_t n_frames);
+
+/**
+ * @brief Encode a block.
+ *
+ * @param pcm Interleaved frames.
+ * @param out Room for audio_enc_block_bytes() bytes.
+ *
+ * @return Bytes written, or -EINVAL if the format cannot code @p n_frames.
+ */
+int audio_enc_encode(struct audio_enc *enc, const int16_t *pcm, size_t n_frames, uint8_t *out);
+
+/**
+ * @brief Decode a block.
+ *
+ * @param pcm Room for the block's frames, interleaved.
+ *
+ * @return Frames decoded, or -EINVAL if @p size is not a whole block.
+ */
+int audio_enc_decode(enum audio_enc_format format, uint8_t n_channels, const uint8_t *in,
+		     size_t size, int16_t *pcm);
+
+/** @} */
+
+#endif /* APP_LIB_AUDIO_ENC_H_ */
@@ -0,0 +1,129 @@
+#ifndef APP_LIB_AUDIO_FEAT_H_
+#define APP_LIB_AUDIO_FEAT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <arm_math.h>
+
+/**
+ * @defgroup lib_audio_feat Audio spectral features
+ * @ingroup lib
+ * @{
+ *
+ * @brief Mel band energies or MFCCs from the capture stream.
+ *
+ * The channels of each frame are mixed to mono and kept in a history one
+ * window long. Every hop samples the history is Hann windowed, transformed
+ * with a real FFT and its power spectrum summed into triangular bands evenly
+ * spaced on the mel scale. A 256 point window with a hop of 80 at 8 kHz
+ * gives 100 feature frames a second, each covering 32 ms.
+ *
+ * Features are levels in dB, 0 dB being about a full scale sine, with
+ * AUDIO_FEAT_FRAC_BITS fractional bits. Cepstral coefficient k is the mean
+ * of the band levels weighted by cos(pi k (b + 1/2) / n_bands), so
+ * coefficient 0 is the mean level.
+ *
+ * Every frame is computed in the same scratch arena inside the instance,
+ * nothing is allocated once it is set up.
+ */
+
+/** Fractional bits of the features */
+#define AUDIO_FEAT_FRAC_BITS 7
+
+/** Most cepstral coefficients */
+#define AUDIO_FEAT_MAX_MFCC 16
+
+/** Tuning, see audio_feat_init() */
+struct audio_feat_config {
+	/** Window and FFT length, a power of two up to CONFIG_AUDIO_FEAT_MAX_FFT */
+	uint16_t fft_len;
+	/** Samples from one frame to the next, up to fft_len */
+	uint16_t hop;
+	/** Mel bands, up to CONFIG_AUDIO_FEAT_MAX_BANDS */
+	uint8_t n_bands;
+	/** Cepstral coefficients, up to n_bands and AUDIO_FEAT_MAX_MFCC, 0 for band levels */
+	uint8_t n_mfcc;
+	/** Lower edge of the first band */
+	uint16_t f_min_hz;
+	/** Upper edge of the last band, up to half the sample rate */
+	uint16_t f_max_hz;
+};
+
+/**
+ * @brief Receives every feature frame.
+ *
+ * @param feat n_mfcc coefficients, or n_bands levels, valid only for the call.
+ * @param timestamp Time of the first sample in the window.
+ */
+typedef void (*audio_feat_sink_t)(const int16_t *feat, uint8_t n_feat, uint64_t timestamp,
+				  void *user_data);
+
+/** Extractor state */
+struct audio_feat {
+	struct audio_feat_config cfg;
+	audio_feat_sink_t sink;
+	void *user_data;
+	uint8_t n_channels;
+	uint32_t fs_hz;
+	uint32_t ts_hz;
+	arm_rfft_fast_instance_f32 rfft;
+	/* Scales the power spectrum so a full scale sine reads 0 dB */
+	float norm;
+	/* Mono samples, the window is due when fill reaches fft_len */
+	uint16_t fill;
+	float history[CONFIG_AUDIO_FEAT_MAX_FFT];
+	float window[CONFIG_AUDIO_FEAT_MAX_FFT];
+	/* Bins lo to hi are in some band. Bin k is on the falling edge of band bin_band[k] - 1
+	 * with bin_weight[k] and on the rising edge of band bin_band[k] with the rest. */
+	uint16_t bin_lo;
+	uint16_t bin_hi;
+	uint8_t bin_band[CONFIG_AUDIO_FEAT_MAX_FFT / 2 + 1];
+	float bin_weight[CONFIG_AUDIO_FEAT_MAX_FFT / 2 + 1];
+	float dct[AUDIO_FEAT_MAX_MFCC][CONFIG_AUDIO_FEAT_MAX_BANDS];
+	/* Windowed samples and spectrum, then power spectrum and band levels */
+	float scratch[2 * CONFIG_AUDIO_FEAT_MAX_FFT];
+	int16_t out[CONFIG_AUDIO_FEAT_MAX_BANDS];
+	/** Feature frames passed to the sink */
+	uint32_t frames;
+};
+
+/** 100 frames a second of 16 band levels from 100 Hz to 4 kHz at 8 kHz */
+#define AUDIO_FEAT_CONFIG_DEFAULT                                                                  \
+	{                                                                                          \
+		.fft_len = 256,                                                                    \
+		.hop = 80,                                                                         \
+		.n_bands = 16,                                                                     \
+		.n_mfcc = 0,                                                                       \
+		.f_min_hz = 100,                                                                   \
+		.f_max_hz = 4000,                                                                  \
+	}
+
+/**
+ * @brief Set up an extractor for interleaved frames of @p n_channels.
+ *
+ * @param fs_hz Sample rate.
+ * @param ts_hz Timestamp ticks per second, e.g. of timebase_now().
+ *
+ * @retval 0 if successful.
+ * @retval -EINVAL if the FFT length or band count is not supported, or a
+ * band is so narrow that no bin falls in it.
+ */
+int audio_feat_init(struct audio_feat *feat, uint32_t fs_hz, uint32_t ts_hz, uint8_t n_channels,
+		    const struct audio_feat_config *cfg, audio_feat_sink_t sink, void *user_data);
+
+/**
+ * @brief Forget the history, e.g. after a gap in the stream.
+ */
+void audio_feat_reset(struct audio_feat *feat);
+
+/**
+ * @brief Add a block, passing every feature frame it completes to the sink.
+ *
+ * @param timestamp Time of the first frame in the block.
+ */
+void audio_feat_process(struct audio_feat *feat, const int16_t *pcm, size_t n_frames,
+			uint64_t timestamp);
+
+/** @} */
+
+#endif /* APP_LIB_AUDIO_FEAT_H_ */
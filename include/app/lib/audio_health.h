@@ -0,0 +1,108 @@
+#ifndef APP_LIB_AUDIO_HEALTH_H_
+#define APP_LIB_AUDIO_HEALTH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @defgroup lib_audio_health Audio stream health
+ * @ingroup lib
+ * @{
+ *
+ * @brief Counters and histograms for a block based capture stream.
+ *
+ * The capture thread reports every block it reads and every error. Latency
+ * is from the DMA completing a block to the thread reading it. The DMA is
+ * not observable directly, so completion times come from the block period
+ * counted from the stream start. The count is re-anchored whenever a block
+ * arrives sooner than predicted, and creeps later by a little every block,
+ * so the shortest recent latency reads zero and drift between the sample
+ * clock and the timebase cannot build up.
+ *
+ * The stats go out as a fixed little endian record, see
+ * audio_health_encode():
+ *
+ *   uint8 version, uint8 latency bins, uint8 queue bins, uint8 reserved,
+ *   uint32 blocks, rx_overruns, rx_errors, tx_underruns, restarts,
+ *   uint16 slab_used_max, uint16 reserved, uint32 latency_max_us,
+ *   uint32 latency[AUDIO_HEALTH_LATENCY_BINS],
+ *   uint32 dma_queued[AUDIO_HEALTH_QUEUE_BINS]
+ */
+
+/** Latency bins, the first below 250 us, each next twice as wide, the last open */
+#define AUDIO_HEALTH_LATENCY_BINS 8
+
+/** Lower edge of the second latency bin */
+#define AUDIO_HEALTH_LATENCY_BIN0_US 250
+
+/** DMA queue occupancy bins, 0 up to AUDIO_HEALTH_QUEUE_BINS - 1 or more blocks */
+#define AUDIO_HEALTH_QUEUE_BINS 8
+
+/** Format of the record */
+#define AUDIO_HEALTH_VERSION 1
+
+/** Bytes in a record */
+#define AUDIO_HEALTH_RECORD_BYTES                                                                  \
+	(4 + 5 * 4 + 4 + 4 + 4 * AUDIO_HEALTH_LATENCY_BINS + 4 * AUDIO_HEALTH_QUEUE_BINS)
+
+/** Stream stats, read directly or with audio_health_encode() */
+struct audio_health {
+	/** Blocks read */
+	uint32_t blocks;
+	/** Reads that failed because the DMA had nowhere to write */
+	uint32_t rx_overruns;
+	/** Other failed reads */
+	uint32_t rx_errors;
+	/** Times the transmitter ran out of data */
+	uint32_t tx_underruns;
+	/** Times the stream was restarted after an error */
+	uint32_t restarts;
+	/** Most slab blocks in use at once */
+	uint16_t slab_used_max;
+	/** Longest latency */
+	uint32_t latency_max_us;
+	/** Latency from DMA completion to the read */
+	uint32_t latency[AUDIO_HEALTH_LATENCY_BINS];
+	/** Blocks queued for the DMA when each block was read */
+	uint32_t dma_queued[AUDIO_HEALTH_QUEUE_BINS];
+	/* Block period and predicted completion of block 0 of this run */
+	uint32_t block_us;
+	uint64_t anchor_us;
+	uint32_t run_blocks;
+};
+
+/**
+ * @brief Clear the stats for a stream of blocks @p block_us long.
+ */
+void audio_health_init(struct audio_health *h, uint32_t block_us);
+
+/**
+ * @brief The stream has been (re)started, the first block completes one
+ * period after @p now_us.
+ */
+void audio_health_start(struct audio_health *h, uint64_t now_us);
+
+/**
+ * @brief Account for a block read at @p now_us.
+ *
+ * @param slab_used Blocks in use in the slab, including this one.
+ * @param dma_queued Blocks the DMA has to write into.
+ */
+void audio_health_block(struct audio_health *h, uint64_t now_us, uint16_t slab_used,
+			uint16_t dma_queued);
+
+/**
+ * @brief Account for a failed read, -EIO counts as an overrun.
+ */
+void audio_health_error(struct audio_health *h, int err);
+
+/**
+ * @brief Write the stats record.
+ *
+ * @return AUDIO_HEALTH_RECORD_BYTES, or -ENOMEM if @p size is too small.
+ */
+int audio_health_encode(const struct audio_health *h, uint8_t *buf, size_t size);
+
+/** @} */
+
+#endif /* APP_LIB_AUDIO_HEALTH_H_ */
@@ -0,0 +1,165 @@
+#ifndef APP_LIB_AUDIO_PIPE_H_
+#define APP_LIB_AUDIO_PIPE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/slist.h>
+
+/**
+ * @defgroup lib_audio_pipe Audio block fan-out
+ * @ingroup lib
+ * @{
+ *
+ * @brief Zero-copy delivery of captured audio blocks to several consumers.
+ *
+ * The capture thread publishes each block i2s_read() returns, still in the
+ * RX memory slab the SAI DMA wrote it to. Every registered consumer gets a
+ * pointer to the same block on its own queue and releases it when done. The
+ * block goes back to the slab with the last release, so nothing is copied
+ * between DMA and the consumers.
+ *
+ * Each consumer lags the capture by at most its queue depth. When its queue
+ * is full a consumer misses blocks, either the new one or, for a live
+ * consumer that wants the freshest audio, its oldest queued one, and its
+ * dropped count goes up. Capture and the other consumers carry on.
+ *
+ * Blocks held by consumers are not available to the DMA, so a pipe holds at
+ * most max_blocks at once. Size it below the slab less the DMA's own chain
+ * and the RX DMA never stalls. With every block held, the pipe takes the
+ * oldest queued block back from the consumer that lags furthest, so one slow
+ * reader cannot cost the others blocks either.
+ */
+
+struct audio_pipe;
+
+/** A published block, valid from audio_pipe_get() until audio_pipe_release() */
+struct audio_block {
+	/** Samples as the DMA wrote them, in the RX slab */
+	void *data;
+	/** Bytes of samples */
+	size_t size;
+	/** Publish count, gaps mean the consumer missed blocks */
+	uint32_t seq;
+	/** Caller supplied capture time, e.g. timebase_now() */
+	uint64_t timestamp;
+	/* Consumers still holding the block */
+	atomic_t refs;
+	struct audio_pipe *pipe;
+};
+
+/** What a consumer misses when its queue is full */
+enum audio_pipe_overrun {
+	/** The new block, what is queued plays on without a gap */
+	AUDIO_PIPE_DROP_NEWEST,
+	/** The oldest queued block, the consumer stays as close to live as it can */
+	AUDIO_PIPE_DROP_OLDEST,
+};
+
+/** A consumer and its queue of block pointers, see AUDIO_PIPE_CONSUMER_DEFINE() */
+struct audio_pipe_consumer {
+	sys_snode_t node;
+	struct k_msgq *queue;
+	enum audio_pipe_overrun overrun;
+	/** Blocks missed, queue full or taken back for capture */
+	atomic_t dropped;
+	/** Most blocks queued at once, how far the consumer has lagged */
+	atomic_t max_queued;
+};
+
+/** Publisher side state, see AUDIO_PIPE_DEFINE() */
+struct audio_pipe {
+	struct k_mem_slab *slab;
+	struct k_mem_slab *descs;
+	struct k_spinlock lock;
+	sys_slist_t consumers;
+	uint32_t seq;
+	/** Blocks no consumer got because every block was taken out of the queues */
+	atomic_t dropped;
+};
+
+/**
+ * @brief Statically define a pipe for blocks from @p slab_.
+ *
+ * @param max_blocks_ Most blocks held by consumers at once, at most the
+ * blocks in the slab less those the DMA needs queued.
+ */
+#define AUDIO_PIPE_DEFINE(name_, slab_, max_blocks_)                                               \
+	K_MEM_SLAB_DEFINE_STATIC(_audio_pipe_descs_##name_, sizeof(struct audio_block),             \
+				 (max_blocks_), __alignof__(struct audio_block));                   \
+	struct audio_pipe name_ = {                                                                \
+		.slab = &(slab_),                                                                  \
+		.descs = &_audio_pipe_descs_##name_,                                               \
+	}
+
+/**
+ * @brief Statically define a consumer that lags by up to @p depth_ blocks
+ * and misses new blocks beyond that.
+ */
+#define AUDIO_PIPE_CONSUMER_DEFINE(name_, depth_)                                                  \
+	AUDIO_PIPE_CONSUMER_DEFINE_OVERRUN(name_, depth_, AUDIO_PIPE_DROP_NEWEST)
+
+/**
+ * @brief Statically define a consumer with room for @p depth_ blocks queued
+ * and the @p overrun_ policy.
+ */
+#define AUDIO_PIPE_CONSUMER_DEFINE_OVERRUN(name_, depth_, overrun_)                                \
+	K_MSGQ_DEFINE(_audio_pipe_queue_##name_, sizeof(struct audio_block *), (depth_),            \
+		      sizeof(void *));                                                             \
+	struct audio_pipe_consumer name_ = {                                                       \
+		.queue = &_audio_pipe_queue_##name_,                                               \
+		.overrun = (overrun_),                                                             \
+	}
+
+/**
+ * @brief Start delivering blocks to @p consumer.
+ *
+ * Normally done before capture starts. A consumer registered later sees only
+ * blocks published after the call.
+ */
+void audio_pipe_register(struct audio_pipe *pipe, struct audio_pipe_consumer *consumer);
+
+/**
+ * @brief Stop delivering blocks to @p consumer and release any it has not
+ * taken yet.
+ */
+void audio_pipe_unregister(struct audio_pipe *pipe, struct audio_pipe_consumer *consumer);
+
+/**
+ * @brief Hand a block from the slab to every consumer.
+ *
+ * Ownership of @p data passes to the pipe. With no consumers registered the
+ * block goes straight back to the slab.
+ *
+ * @retval 0 if at least one consumer has the block.
+ * @retval -ENODATA if no consumer took it.
+ * @retval -ENOMEM if the consumers hold max_blocks outside their queues, the
+ * block was freed.
+ */
+int audio_pipe_publish(struct audio_pipe *pipe, void *data, size_t size, uint64_t timestamp);
+
+/**
+ * @brief Wait for the next block for @p consumer.
+ *
+ * @return The block, NULL on timeout.
+ */
+struct audio_block *audio_pipe_get(struct audio_pipe_consumer *consumer, k_timeout_t timeout);
+
+/**
+ * @brief Give up a block, the last release returns it to the slab.
+ */
+void audio_pipe_release(struct audio_block *block);
+
+/**
+ * @brief Take another reference, e.g. to keep a block past the next
+ * audio_pipe_get(). Every hold needs its own audio_pipe_release().
+ */
+static inline void audio_pipe_hold(struct audio_block *block)
+{
+	atomic_inc(&block->refs);
+}
+
+/** @} */
+
+#endif /* APP_LIB_AUDIO_PIPE_H_ */
@@ -0,0 +1,118 @@
+#ifndef APP_LIB_AUDIO_VAD_H_
+#define APP_LIB_AUDIO_VAD_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/sys/util.h>
+
+/**
+ * @defgroup lib_audio_vad Audio activity detection
+ * @ingroup lib
+ * @{
+ *
+ * @brief Gates captured blocks so only sound, not silence, reaches storage.
+ *
+ * Every block is classed active when its energy is a threshold above the
+ * tracked noise floor, unless it also crosses zero so often that it looks
+ * like hiss and is not much louder. The floor follows quieter blocks at once
+ * and louder ones slowly, so a steady rise in room noise stops triggering
+ * after a few seconds.
+ *
+ * Active blocks, and hangover blocks after the last one, go to the sink. The
+ * last pre-roll blocks before an onset are copied aside, so the start of a
+ * sound that takes a block or two to cross the threshold is not lost. The
+ * copies leave the capture slab free for the DMA.
+ */
+
+/** Tuning in time rather than blocks, see audio_vad_init() */
+struct audio_vad_config {
+	/** Energy above the noise floor for a block to be active, up to 30 */
+	uint8_t threshold_db;
+	/** Zero crossings per 1000 samples above which a block is taken for hiss */
+	uint16_t zcr_max;
+	/** Forwarded after the last active block, in milliseconds */
+	uint16_t hangover_ms;
+	/** Forwarded ahead of an onset, in milliseconds, up to
+	 * CONFIG_AUDIO_VAD_PREROLL_BLOCKS blocks */
+	uint16_t preroll_ms;
+	/** How fast the noise floor follows a louder room, in dB a second */
+	uint8_t floor_rise_db;
+};
+
+/**
+ * @brief Receives the forwarded blocks, in capture order.
+ *
+ * @param pcm Interleaved frames, valid only for the call.
+ */
+typedef void (*audio_vad_sink_t)(const int16_t *pcm, size_t n_frames, uint64_t timestamp,
+				 void *user_data);
+
+/** Detector and gate state */
+struct audio_vad {
+	struct audio_vad_config cfg;
+	audio_vad_sink_t sink;
+	void *user_data;
+	uint8_t n_channels;
+	uint16_t block_frames;
+	/* The config in blocks */
+	uint16_t hangover_blocks;
+	uint16_t preroll_blocks;
+	/* Energy threshold over the floor, Q8 */
+	uint32_t ratio;
+	/* Floor rise a block, Q16 */
+	uint32_t rise;
+	/* Mean square of the quietest recent blocks, Q8 so a slow rise does not round away,
+	 * 0 before the first block */
+	uint64_t floor;
+	/* Blocks still forwarded after the last active one */
+	uint16_t hangover;
+	/* Pre-roll ring, oldest at head */
+	uint16_t head;
+	uint16_t count;
+	uint64_t preroll_ts[CONFIG_AUDIO_VAD_PREROLL_BLOCKS];
+	int16_t preroll[CONFIG_AUDIO_VAD_PREROLL_BLOCKS][CONFIG_AUDIO_VAD_BLOCK_BYTES / 2];
+	/** Blocks in */
+	uint32_t blocks_in;
+	/** Blocks passed to the sink */
+	uint32_t blocks_out;
+};
+
+/** Defaults for speech and coughs in a bedroom */
+#define AUDIO_VAD_CONFIG_DEFAULT                                                                   \
+	{                                                                                          \
+		.threshold_db = 9,                                                                 \
+		.zcr_max = 400,                                                                    \
+		.hangover_ms = 320,                                                                \
+		.preroll_ms = 256,                                                                 \
+		.floor_rise_db = 2,                                                                \
+	}
+
+/**
+ * @brief Set up a detector for blocks of @p block_frames interleaved frames
+ * sampled at @p fs_hz.
+ *
+ * Hangover and pre-roll are rounded up to whole blocks.
+ *
+ * @retval 0 if successful.
+ * @retval -EINVAL if a block is larger than CONFIG_AUDIO_VAD_BLOCK_BYTES, the
+ * pre-roll longer than CONFIG_AUDIO_VAD_PREROLL_BLOCKS blocks or the
+ * threshold over 30 dB.
+ */
+int audio_vad_init(struct audio_vad *vad, uint32_t fs_hz, uint8_t n_channels,
+		   uint16_t block_frames, const struct audio_vad_config *cfg, audio_vad_sink_t sink,
+		   void *user_data);
+
+/**
+ * @brief Classify a block and forward it, with any pre-roll, if it is
+ * active or in the hangover.
+ *
+ * @param timestamp Capture time, passed on to the sink.
+ *
+ * @return true if the block was forwarded.
+ */
+bool audio_vad_process(struct audio_vad *vad, const int16_t *pcm, uint64_t timestamp);
+
+/** @} */
+
+#endif /* APP_LIB_AUDIO_VAD_H_ */
@@ -0,0 +1,121 @@
+#ifndef APP_LIB_EXG_COMPRESS_H_
+#define APP_LIB_EXG_COMPRESS_H_
+
+#include <stdint.h>
+
+#include <app/lib/exg_convert.h>
+
+/**
+ * @defgroup lib_exg_compress ExG lossless compression
+ * @ingroup lib
+ * @{
+ *
+ * @brief Streaming lossless coder for ADC counts, in fixed size packets.
+ *
+ * FLAC style: every block of EXG_COMPRESS_BLOCK_FRAMES frames picks, per
+ * channel, the fixed polynomial predictor of order 0 to 3 with the smallest
+ * residuals and the Rice parameter that codes them in the fewest bits. A
+ * block whose residuals would cost more than the samples themselves is stored
+ * verbatim, so no input expands by more than the 7 bit channel header.
+ *
+ * Every packet is CONFIG_EXG_COMPRESS_PACKET_BYTES long and decodes on its
+ * own, a lost flash page or uplink message costs only its own frames. The
+ * packet starts with a little endian header:
+ *
+ *   uint32 first_frame, uint16 n_frames, uint8 n_channels, uint8 version
+ *
+ * followed by the bit stream, most significant bit first, padded with zeros.
+ * Input is sign extended 24 bit counts, see exg_convert_init_counts().
+ */
+
+/** Frames per block, the unit of predictor and Rice parameter choice */
+#define EXG_COMPRESS_BLOCK_FRAMES 16
+
+/** Bytes before the bit stream */
+#define EXG_COMPRESS_HEADER_BYTES 8
+
+/** Format of the bit stream, in the header */
+#define EXG_COMPRESS_VERSION 1
+
+/**
+ * Packets exg_compress_process() may write for @p n_frames of input. A block
+ * always fits a packet, so at most one packet is closed per block.
+ */
+#define EXG_COMPRESS_MAX_PACKETS(n_frames) ((n_frames) / EXG_COMPRESS_BLOCK_FRAMES + 1)
+
+/** Encoder state */
+struct exg_compress {
+	uint8_t n_channels;
+	/* Input frames waiting for a whole block */
+	uint8_t n_pending;
+	/* Frames in the open packet, 0 when the next block starts one */
+	uint16_t n_frames;
+	uint32_t first_frame;
+	uint32_t next_frame;
+	/* Bit writer into packet */
+	uint64_t acc;
+	uint8_t acc_bits;
+	uint32_t pos;
+	/* Last three samples of every channel, most recent first */
+	int32_t hist[EXG_MAX_CHANNELS][3];
+	int32_t pending[EXG_MAX_CHANNELS][EXG_COMPRESS_BLOCK_FRAMES];
+	uint8_t packet[CONFIG_EXG_COMPRESS_PACKET_BYTES];
+};
+
+/** What a packet holds, from its header */
+struct exg_compress_info {
+	uint32_t first_frame;
+	uint16_t n_frames;
+	uint8_t n_channels;
+};
+
+/**
+ * @brief Set up an encoder, the first frame in is numbered 0.
+ *
+ * @retval 0 if successful.
+ * @retval -EINVAL for no channels or more than EXG_MAX_CHANNELS.
+ */
+int exg_compress_init(struct exg_compress *c, uint8_t n_channels);
+
+/**
+ * @brief Compress a block of rows.
+ *
+ * Frames that do not complete a block are kept until the next call.
+ *
+ * @param rows Channel-major counts, sample @p f of channel @p ch at
+ * rows[ch * stride + f].
+ * @param out Room for @p max_packets packets, back to back.
+ * @param max_packets At least EXG_COMPRESS_MAX_PACKETS(n).
+ *
+ * @return Packets written, or -ENOMEM if @p max_packets is too small, in
+ * which case nothing is consumed.
+ */
+int exg_compress_process(struct exg_compress *c, const int32_t *rows, uint32_t n, uint32_t stride,
+			 uint8_t *out, uint32_t max_packets);
+
+/**
+ * @brief Compress any frames held back and close the open packet, e.g.
+ * before a recording is closed.
+ *
+ * @param out Room for two packets.
+ *
+ * @return Packets written, 0 to 2.
+ */
+int exg_compress_flush(struct exg_compress *c, uint8_t *out);
+
+/**
+ * @brief Decode one packet.
+ *
+ * @param rows Channel-major output, sample @p f of channel @p ch at
+ * rows[ch * stride + f].
+ * @param stride At least the packet's frame count.
+ *
+ * @return Frames decoded, -EINVAL for a corrupt packet or another version,
+ * -ENOMEM if @p stride is too small.
+ */
+int exg_compress_decode(const uint8_t *packet, struct exg_compress_info *info, int32_t *rows,
+			uint32_t stride);
+
+/** @} */
+
+#endif /* APP_LIB_EXG_COMPRESS_H_ */
@@ -0,0 +1,71 @@
+#ifndef APP_LIB_EXG_CONVERT_H_
+#define APP_LIB_EXG_CONVERT_H_
+
+#include <stdint.h>
+
+/**
+ * @defgroup lib_exg_convert ExG frame conversion
+ * @ingroup lib
+ * @{
+ *
+ * @brief Block conversion of raw ADS1298 frames to scaled samples.
+ *
+ * Takes frames exactly as they sit in the driver ring, see
+ * ads1298_stream_claim(), and writes one row per channel so the filters
+ * downstream can run over contiguous samples. Scaling is fixed point with one
+ * multiply per sample, no division or float.
+ */
+
+/** Most channels handled, two daisy-chained devices */
+#define EXG_MAX_CHANNELS 16
+
+/** Fraction bits of q31 output are 31 - EXG_CONVERT_Q31_SHIFT, +-4 V full scale */
+#define EXG_CONVERT_Q31_SHIFT 2
+
+/** Per channel scale, set up by one of the init functions */
+struct exg_convert {
+	uint8_t n_devices;
+	int32_t mul[EXG_MAX_CHANNELS];
+};
+
+/**
+ * @brief Set up conversion to microvolts.
+ *
+ * @param n_devices Daisy-chain length, 1 or 2.
+ * @param gain PGA gain of each of the 8 * @p n_devices channels, 0 for reserved.
+ * @param vref_uv Reference voltage in microvolts.
+ */
+void exg_convert_init_uv(struct exg_convert *cv, uint8_t n_devices, const uint8_t *gain,
+			 uint32_t vref_uv);
+
+/**
+ * @brief Set up conversion to q31 volts with EXG_CONVERT_Q31_SHIFT, the same
+ * representation the sensor decoder produces.
+ */
+void exg_convert_init_q31(struct exg_convert *cv, uint8_t n_devices, const uint8_t *gain,
+			  uint32_t vref_uv);
+
+/**
+ * @brief Set up unpacking to sign extended ADC counts, bit exact for lossless
+ * storage with exg_compress.
+ */
+void exg_convert_init_counts(struct exg_convert *cv, uint8_t n_devices);
+
+/**
+ * @brief Convert a run of frames into channel-major output.
+ *
+ * Sample @p f of channel @p ch is written to out[ch * out_stride + f]. A run
+ * that wraps the ring can be converted with two calls, the second with @p out
+ * advanced by the frames already done.
+ *
+ * @param frames First frame, frames are 27 bytes per device and back to back.
+ * @param n_frames Frames to convert.
+ * @param out Output rows, 8 * n_devices of them.
+ * @param out_stride Distance between rows in samples, at least @p n_frames.
+ */
+void exg_convert_block(const struct exg_convert *cv, const uint8_t *frames, uint32_t n_frames,
+		       int32_t *out, uint32_t out_stride);
+
+/** @} */
+
+#endif /* APP_LIB_EXG_CONVERT_H_ */
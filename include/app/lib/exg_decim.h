@@ -0,0 +1,78 @@
+#ifndef APP_LIB_EXG_DECIM_H_
+#define APP_LIB_EXG_DECIM_H_
+
+#include <stdint.h>
+#include <zephyr/dsp/types.h>
+
+#include <app/lib/exg_convert.h>
+
+/**
+ * @defgroup lib_exg_decim ExG decimator
+ * @ingroup lib
+ * @{
+ *
+ * @brief Multi-stage FIR decimation of oversampled ExG rows.
+ *
+ * The ADS1298 has less noise per unit bandwidth at high data rates, so it can
+ * be run at 8 to 32 kSPS and brought down to the rate that is stored or sent.
+ * Decimation is a chain of halving stages, each a half-band FIR of which only
+ * the retained outputs are computed. The early stages can use short filters
+ * because anything they let through is removed by the sharper last stage.
+ * The passband is flat to 0.38 of the output rate.
+ */
+
+/** Taps of the intermediate stages */
+#define EXG_DECIM_TAPS 15
+
+/** Taps of the final stage, sets the transition band */
+#define EXG_DECIM_FINAL_TAPS 47
+
+struct exg_decim {
+	uint8_t n_channels;
+	uint8_t n_stages;
+	/* Shared by every channel, they all see the same number of samples */
+	uint8_t pos[CONFIG_EXG_DECIM_MAX_STAGES];
+	uint8_t odd[CONFIG_EXG_DECIM_MAX_STAGES];
+	q31_t taps[EXG_DECIM_TAPS];
+	q31_t final_taps[EXG_DECIM_FINAL_TAPS];
+	/* Each history holds the last taps samples twice so the newest run is contiguous */
+	q31_t hist[EXG_MAX_CHANNELS][CONFIG_EXG_DECIM_MAX_STAGES - 1][2 * EXG_DECIM_TAPS];
+	q31_t final_hist[EXG_MAX_CHANNELS][2 * EXG_DECIM_FINAL_TAPS];
+};
+
+/**
+ * @brief Set up decimation from @p fs_in_hz to @p fs_out_hz.
+ *
+ * May be called again at any time to change the output rate, the history is
+ * cleared.
+ *
+ * @retval 0 if successful.
+ * @retval -EINVAL if the ratio is not a power of two, needs more than
+ * CONFIG_EXG_DECIM_MAX_STAGES stages or there are too many channels.
+ */
+int exg_decim_init(struct exg_decim *dec, uint8_t n_channels, uint32_t fs_in_hz,
+		   uint32_t fs_out_hz);
+
+/**
+ * @brief Clear the history of every channel.
+ */
+void exg_decim_reset(struct exg_decim *dec);
+
+/**
+ * @brief Decimate @p n_frames samples of every channel in place.
+ *
+ * Output samples are written to the start of each row, over the input that
+ * produced them. Blocks need not be a multiple of the ratio, the phase is
+ * carried over to the next call.
+ *
+ * @param rows Channel-major samples as written by exg_convert_block().
+ * @param out_stride Distance between rows in samples.
+ *
+ * @return Output samples per channel.
+ */
+uint32_t exg_decim_process(struct exg_decim *dec, int32_t *rows, uint32_t n_frames,
+			   uint32_t out_stride);
+
+/** @} */
+
+#endif /* APP_LIB_EXG_DECIM_H_ */
@@ -0,0 +1,85 @@
+#ifndef APP_LIB_EXG_FILTER_H_
+#define APP_LIB_EXG_FILTER_H_
+
+#include <stdint.h>
+#include <arm_math.h>
+
+#include <app/lib/exg_convert.h>
+
+/**
+ * @defgroup lib_exg_filter ExG biquad filter
+ * @ingroup lib
+ * @{
+ *
+ * @brief Per channel biquad cascade run in place over converted ExG rows.
+ *
+ * Every channel shares one set of coefficients and has its own state. The
+ * rows written by exg_convert_block() are filtered where they are, so the
+ * filter adds no copies between the ring and the consumer.
+ */
+
+/** Coefficients per biquad stage, {b0, b1, b2, a1, a2} in CMSIS-DSP order */
+#define EXG_FILTER_STAGE_COEFFS 5
+
+/** Post shift used by the design functions, coefficients are scaled by 1/2 */
+#define EXG_FILTER_POST_SHIFT 1
+
+struct exg_filter {
+	uint8_t n_channels;
+	q31_t coeffs[EXG_FILTER_STAGE_COEFFS * CONFIG_EXG_FILTER_MAX_STAGES];
+	arm_biquad_cas_df1_32x64_ins_q31 inst[EXG_MAX_CHANNELS];
+	q63_t state[EXG_MAX_CHANNELS][4 * CONFIG_EXG_FILTER_MAX_STAGES];
+};
+
+/**
+ * @brief Set up a cascade, coefficients are copied so the caller's may be discarded.
+ *
+ * @param coeffs @p n_stages groups of EXG_FILTER_STAGE_COEFFS, with a1 and a2
+ * negated as CMSIS-DSP expects and everything scaled by 2^-post_shift.
+ *
+ * @retval 0 if successful.
+ * @retval -EINVAL if there are too many stages or channels.
+ */
+int exg_filter_init(struct exg_filter *flt, uint8_t n_channels, const q31_t *coeffs,
+		    uint8_t n_stages, uint8_t post_shift);
+
+/**
+ * @brief Set up the usual ExG cascade: a notch at @p mains_hz followed by a
+ * 0.5 Hz second order high-pass to remove baseline wander.
+ *
+ * @param fs_hz Sample rate of the rows, the ADS1298 data rate.
+ * @param mains_hz 50 or 60.
+ */
+int exg_filter_init_default(struct exg_filter *flt, uint8_t n_channels, uint32_t fs_hz,
+			    uint32_t mains_hz);
+
+/**
+ * @brief Clear the state of every channel, e.g. after a gap in the stream.
+ */
+void exg_filter_reset(struct exg_filter *flt);
+
+/**
+ * @brief Filter @p n_frames samples of every channel in place.
+ *
+ * @param rows Channel-major samples as written by exg_convert_block().
+ * @param out_stride Distance between rows in samples.
+ */
+void exg_filter_process(struct exg_filter *flt, int32_t *rows, uint32_t n_frames,
+			uint32_t out_stride);
+
+/**
+ * @brief Design a notch stage (RBJ cookbook) with EXG_FILTER_POST_SHIFT scaling.
+ *
+ * @param q Quality factor, centre frequency over -3 dB bandwidth.
+ */
+int exg_filter_design_notch(q31_t *stage, uint32_t fs_hz, float f0_hz, float q);
+
+/**
+ * @brief Design a second order Butterworth high-pass stage with
+ * EXG_FILTER_POST_SHIFT scaling.
+ */
+int exg_filter_design_highpass(q31_t *stage, uint32_t fs_hz, float fc_hz);
+
+/** @} */
+
+#endif /* APP_LIB_EXG_FILTER_H_ */
@@ -0,0 +1,169 @@
+#ifndef APP_LIB_EXG_LEADOFF_H_
+#define APP_LIB_EXG_LEADOFF_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <app/lib/exg_convert.h>
+
+/**
+ * @defgroup lib_exg_leadoff ExG lead-off monitoring
+ * @ingroup lib
+ * @{
+ *
+ * @brief Per electrode contact status from the stream itself.
+ *
+ * With DC lead-off detection on, see SENSOR_ATTR_ADS1298_LEAD_OFF, every
+ * frame's status word carries the comparator outputs LOFF_STATP and
+ * LOFF_STATN, so watching contact costs no SPI traffic. The raw bits are
+ * debounced into on and off events per electrode input.
+ *
+ * In AC mode the comparators are not usable and the excitation current shows
+ * up in the samples at a quarter of the data rate instead. exg_impedance
+ * measures that tone per channel, and its mask can be fed to the same
+ * debouncer.
+ *
+ * Electrode inputs are numbered as bits of a mask: INnP of device d is bit
+ * d * 16 + n - 1, INnN is bit d * 16 + 8 + n - 1.
+ */
+
+/** Electrode inputs, P and N of every channel */
+#define EXG_LEADOFF_MAX_INPUTS (2 * EXG_MAX_CHANNELS)
+
+/** Bit of input INnP of channel @p ch, 0 based across the chain */
+#define EXG_LEADOFF_P(ch) (((ch) / 8) * 16 + (ch) % 8)
+/** Bit of input INnN of channel @p ch, 0 based across the chain */
+#define EXG_LEADOFF_N(ch) (EXG_LEADOFF_P(ch) + 8)
+
+/** A debounced change of one input */
+struct exg_leadoff_event {
+	/** Update within the block that confirmed the change, e.g. the frame */
+	uint32_t index;
+	/** Bit number of the input */
+	uint8_t input;
+	/** True if contact was lost, false if it came back */
+	bool off;
+};
+
+/** Debouncer state */
+struct exg_leadoff {
+	uint16_t debounce;
+	uint32_t state;
+	/* Inputs whose raw value differs from state, with how many updates in a row */
+	uint32_t pending;
+	uint16_t count[EXG_LEADOFF_MAX_INPUTS];
+};
+
+/**
+ * @brief Set up a debouncer, every input starts with good contact.
+ *
+ * @param debounce Updates in a row a raw change must hold to become an event,
+ * e.g. fs_hz / 10 for 100 ms of frames.
+ */
+void exg_leadoff_init(struct exg_leadoff *lo, uint16_t debounce);
+
+/**
+ * @brief Lead-off bits of one frame's status words.
+ *
+ * @param frame Frame as in the driver ring, 27 bytes per device.
+ * @param n_devices Daisy-chain length.
+ */
+uint32_t exg_leadoff_status(const uint8_t *frame, uint8_t n_devices);
+
+/**
+ * @brief Apply one raw lead-off mask.
+ *
+ * Every change of state is reported. A change that finds @p events full
+ * stays pending and is reported by the next update with room, if the raw
+ * value still holds, with that update's index.
+ *
+ * @param index Copied into any events.
+ *
+ * @return Number of events written, at most @p max_events.
+ */
+uint32_t exg_leadoff_update(struct exg_leadoff *lo, uint32_t raw, uint32_t index,
+			    struct exg_leadoff_event *events, uint32_t max_events);
+
+/**
+ * @brief Debounce the status words of a run of frames.
+ *
+ * Frames with unchanged status, i.e. almost all of them, cost a load and a
+ * compare. Event indexes are frame numbers within the run.
+ *
+ * @return Number of events written, at most @p max_events.
+ */
+uint32_t exg_leadoff_process(struct exg_leadoff *lo, const uint8_t *frames, uint32_t n_frames,
+			     uint8_t n_devices, struct exg_leadoff_event *events,
+			     uint32_t max_events);
+
+/**
+ * @brief Debounced inputs without contact.
+ */
+static inline uint32_t exg_leadoff_state(const struct exg_leadoff *lo)
+{
+	return lo->state;
+}
+
+/** AC impedance estimate per channel */
+struct exg_impedance {
+	uint8_t n_channels;
+	uint16_t window;
+	uint16_t pos;
+	uint32_t current_na;
+	int64_t i[EXG_MAX_CHANNELS];
+	int64_t q[EXG_MAX_CHANNELS];
+	uint32_t ohms[EXG_MAX_CHANNELS];
+};
+
+/**
+ * @brief Set up impedance estimation over windows of 200 ms or more.
+ *
+ * At rates that are a multiple of 10 Hz a window holds whole periods of 50
+ * and 60 Hz mains as well as of the excitation, which at 250 SPS takes
+ * 400 ms. Elsewhere mains is not fully rejected.
+ *
+ * @param n_channels Channels in the rows passed to exg_impedance_process().
+ * @param fs_hz Sample rate, the excitation is at fs_hz / 4.
+ * @param current_na Lead-off current, ILEAD_OFF in the LOFF register.
+ *
+ * @retval 0 if successful.
+ * @retval -EINVAL for too many channels, a rate under 20 Hz or no current.
+ */
+int exg_impedance_init(struct exg_impedance *imp, uint8_t n_channels, uint32_t fs_hz,
+		       uint32_t current_na);
+
+/**
+ * @brief Demodulate a block of converted rows.
+ *
+ * Rows are q31 volts with EXG_CONVERT_Q31_SHIFT, as from exg_convert_block()
+ * set up with exg_convert_init_q31() and before any filtering. Each sample
+ * costs one add.
+ *
+ * @return True if a window finished in this block and exg_impedance_ohms()
+ * has new values.
+ */
+bool exg_impedance_process(struct exg_impedance *imp, const int32_t *rows, uint32_t n,
+			   uint32_t stride);
+
+/**
+ * @brief Magnitude at fs / 4 over the last whole window divided by the
+ * current, i.e. the two electrodes of the channel in series. This is
+ * uncalibrated against the ADC's decimation filter response at fs / 4, so
+ * compare against thresholds found on the board.
+ */
+static inline uint32_t exg_impedance_ohms(const struct exg_impedance *imp, uint8_t ch)
+{
+	return imp->ohms[ch];
+}
+
+/**
+ * @brief Channels above @p max_ohms as a lead-off mask, for exg_leadoff_update().
+ *
+ * A channel cannot tell its two electrodes apart, both its P and N inputs
+ * are set.
+ */
+uint32_t exg_impedance_mask(const struct exg_impedance *imp, uint32_t max_ohms);
+
+/** @} */
+
+#endif /* APP_LIB_EXG_LEADOFF_H_ */
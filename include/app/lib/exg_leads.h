@@ -0,0 +1,56 @@
+#ifndef APP_LIB_EXG_LEADS_H_
+#define APP_LIB_EXG_LEADS_H_
+
+#include <stdint.h>
+
+/**
+ * @defgroup lib_exg_leads ExG derived limb leads
+ * @ingroup lib
+ * @{
+ *
+ * @brief Leads III, aVR, aVL and aVF from leads I and II.
+ *
+ * In 12-lead mode the ADS1298 measures I and II directly and V1 to V6 against
+ * the Wilson central terminal, see SENSOR_ATTR_ADS1298_WCT. The other four
+ * limb leads carry no new information and follow from Einthoven's law:
+ *
+ *   III = II - I, aVR = -(I + II) / 2, aVL = I - II / 2, aVF = II - I / 2
+ *
+ * Computing them once on converted rows means every consumer sees the same
+ * lead set. The kernel is one pass over both inputs with no branches,
+ * results saturate rather than wrap.
+ */
+
+/** Channels carrying leads I and II with the electrodes as in SENSOR_ATTR_ADS1298_WCT */
+#define EXG_LEADS_I_CHANNEL 1
+#define EXG_LEADS_II_CHANNEL 2
+
+/** Rows written by exg_leads_derive(), in this order */
+enum exg_leads_derived {
+	EXG_LEAD_III,
+	EXG_LEAD_AVR,
+	EXG_LEAD_AVL,
+	EXG_LEAD_AVF,
+	EXG_LEADS_DERIVED,
+};
+
+/**
+ * @brief Derive the four remaining limb leads from a block of rows.
+ *
+ * Works on any linear representation, microvolts or q31 volts, and may run
+ * before or after linear filtering as long as every row has seen the same
+ * filter.
+ *
+ * @param lead_i Row of lead I, e.g. rows + EXG_LEADS_I_CHANNEL * stride.
+ * @param lead_ii Row of lead II.
+ * @param out EXG_LEADS_DERIVED rows, lead @p l at out[l * out_stride]. These
+ * may follow the acquired channels in the same buffer.
+ * @param out_stride Distance between output rows in samples, at least @p n.
+ * @param n Samples per row.
+ */
+void exg_leads_derive(const int32_t *lead_i, const int32_t *lead_ii, int32_t *out,
+		      uint32_t out_stride, uint32_t n);
+
+/** @} */
+
+#endif /* APP_LIB_EXG_LEADS_H_ */
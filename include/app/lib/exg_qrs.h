@@ -0,0 +1,131 @@
+#ifndef APP_LIB_EXG_QRS_H_
+#define APP_LIB_EXG_QRS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @defgroup lib_exg_qrs ExG QRS detector
+ * @ingroup lib
+ * @{
+ *
+ * @brief Streaming Pan-Tompkins R-peak detector.
+ *
+ * One ECG lead is band-passed (5-15 Hz), differentiated, squared and
+ * integrated over 150 ms. Peaks of the integrated signal are classified as
+ * QRS or noise against thresholds that track both, with a 200 ms refractory
+ * period, T-wave rejection by slope and a search back for a missed beat when
+ * nothing is found in 1.66 average RR intervals. The first two seconds are
+ * used to learn the initial thresholds and produce no beats.
+ *
+ * Every sample costs the same fixed amount of work and the state is a fixed
+ * size, only the beats found are reported.
+ */
+
+/** Highest sample rate, sets the size of the integration window */
+#define EXG_QRS_MAX_FS_HZ 1000
+
+/** One detected beat */
+struct exg_qrs_beat {
+	/** Time of the R-peak, on the same clock as the block timestamps */
+	int64_t timestamp_ns;
+	/** Interval since the previous beat, 0 for the first beat */
+	uint32_t rr_ms;
+};
+
+/** @cond INTERNAL_HIDDEN */
+struct exg_qrs_biquad {
+	int32_t b0, b1, b2, a1, a2;
+	int32_t x1, x2, y1, y2;
+};
+/** @endcond */
+
+struct exg_qrs {
+	uint32_t fs_hz;
+	uint64_t n; /* Samples seen */
+
+	struct exg_qrs_biquad lp;
+	struct exg_qrs_biquad hp;
+	uint32_t bp_delay;
+	int32_t bp_hist[4];
+
+	/* Moving window integration over squared slope */
+	int64_t sq[EXG_QRS_MAX_FS_HZ * 150 / 1000];
+	uint16_t window;
+	uint16_t sq_pos;
+	int64_t mwi;
+
+	/* Segment since the last integrated peak */
+	int64_t seg_peak;
+	uint64_t seg_peak_n;
+	int32_t seg_bp_max;
+	uint64_t seg_r;
+	int32_t seg_slope;
+
+	/* Thresholds */
+	uint32_t learn_len;
+	int64_t learn_max;
+	int64_t learn_sum;
+	int64_t spki;
+	int64_t npki;
+	int64_t thr1;
+
+	/* Last beat */
+	bool have_beat;
+	uint64_t last_peak_n;
+	uint64_t last_r;
+	int32_t last_slope;
+	uint32_t refractory;
+	uint32_t t_wave_window;
+
+	/* Average of the last 8 RR intervals in samples */
+	uint32_t rr[8];
+	uint8_t rr_pos;
+	uint8_t rr_count;
+	uint32_t rr_sum;
+
+	/* Best noise peak since the last beat, for search back */
+	bool sb_valid;
+	int64_t sb_peak;
+	uint64_t sb_peak_n;
+	uint64_t sb_r;
+	int32_t sb_slope;
+};
+
+/**
+ * @brief Set up a detector for a lead sampled at @p fs_hz.
+ *
+ * @retval 0 if successful.
+ * @retval -EINVAL if @p fs_hz is below 100 or above EXG_QRS_MAX_FS_HZ.
+ */
+int exg_qrs_init(struct exg_qrs *qrs, uint32_t fs_hz);
+
+/**
+ * @brief Feed a block of samples of one lead.
+ *
+ * Any scale will do, e.g. q31 volts from exg_convert_block(), as long as it
+ * does not change while the detector runs. Beats are reported once they are
+ * confirmed, which can be up to 1.66 RR intervals after the R-peak, so their
+ * timestamps can fall in an earlier block.
+ *
+ * @param samples Samples, consecutive, e.g. one row from exg_convert_block().
+ * @param n Number of samples.
+ * @param timestamp_ns Time of samples[0].
+ * @param beats Filled with the beats found.
+ * @param max_beats Room in @p beats, any further beats in the block are lost.
+ *
+ * @return Number of beats written to @p beats.
+ */
+uint32_t exg_qrs_process(struct exg_qrs *qrs, const int32_t *samples, uint32_t n,
+			 int64_t timestamp_ns, struct exg_qrs_beat *beats, uint32_t max_beats);
+
+/**
+ * @brief Heart rate from the average of the last eight RR intervals.
+ *
+ * @return Beats per minute, 0 before the second beat.
+ */
+uint32_t exg_qrs_heart_rate_bpm(const struct exg_qrs *qrs);
+
+/** @} */
+
+#endif /* APP_LIB_EXG_QRS_H_ */
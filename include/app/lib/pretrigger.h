@@ -0,0 +1,122 @@
+#ifndef APP_LIB_PRETRIGGER_H_
+#define APP_LIB_PRETRIGGER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/slist.h>
+#include <zephyr/sys/util.h>
+
+/**
+ * @defgroup lib_pretrigger Event triggered capture windows
+ * @ingroup lib
+ * @{
+ *
+ * @brief Keeps the last seconds of every stream in RAM and stores only the
+ * windows around events.
+ *
+ * Each stream, audio blocks or ExG frames, writes its records with their
+ * timebase timestamps into its own ring, overwriting the oldest. Nothing
+ * reaches the sink until some subsystem fires a trigger, a cough, an
+ * arrhythmia or a fall. Then every registered ring passes the records from
+ * the pre-trigger time before the event to the post-trigger time after it to
+ * its sink. Triggers whose windows overlap merge into one window. A window
+ * that starts after the open one ends waits behind it, so records of the
+ * open window not yet written still go out. Any trigger while one waits
+ * merges with the waiting window, gap included.
+ *
+ * The sink runs in the thread that writes the ring, when a write finds
+ * records in the window, so the ring needs no lock against its producer. The
+ * pre-trigger records all go out with the first write after the trigger, a
+ * sink that stores to flash should queue rather than block.
+ *
+ * Records are copied in. The capture slabs are sized for DMA latency, not
+ * seconds of audio, so holding blocks in them would stall capture.
+ *
+ * Nothing in the app uses this yet. No ring is registered on the capture
+ * pipe or the ExG stream, and no event fires a trigger, until there is a
+ * storage sink to take the windows.
+ */
+
+/**
+ * @brief Receives the records of a window, oldest first.
+ *
+ * @param record The record as written, valid only for the call.
+ */
+typedef void (*pretrigger_sink_t)(const void *record, uint64_t timestamp, void *user_data);
+
+/** A stream's ring, see PRETRIGGER_RING_DEFINE() */
+struct pretrigger_ring {
+	sys_snode_t node;
+	uint8_t *records;
+	uint64_t *timestamps;
+	size_t record_size;
+	/* Power of two */
+	uint32_t n_records;
+	pretrigger_sink_t sink;
+	void *user_data;
+	/* Records written, the next goes at head % n_records */
+	uint32_t head;
+	/* Records before this one have been sent or passed over */
+	uint32_t sent;
+	/* Window under the trigger lock, open while end is not 0 */
+	uint64_t start;
+	uint64_t end;
+	/* Window waiting for it to close, queued while next_end is not 0 */
+	uint64_t next_start;
+	uint64_t next_end;
+	/** Windows that began before the oldest record still in the ring */
+	uint32_t short_windows;
+};
+
+/**
+ * @brief Statically define a ring of @p n_records_ records of
+ * @p record_size_ bytes.
+ *
+ * The ring holds n_records_ records, so for a pre-trigger time of T seconds
+ * it must hold at least T seconds of the stream.
+ */
+#define PRETRIGGER_RING_DEFINE(name_, record_size_, n_records_, sink_, user_data_)                 \
+	BUILD_ASSERT(IS_POWER_OF_TWO(n_records_), "Ring must be a power of two");                  \
+	static uint8_t _pretrigger_records_##name_[(n_records_) * (record_size_)] __aligned(4);    \
+	static uint64_t _pretrigger_ts_##name_[n_records_];                                        \
+	struct pretrigger_ring name_ = {                                                           \
+		.records = _pretrigger_records_##name_,                                            \
+		.timestamps = _pretrigger_ts_##name_,                                              \
+		.record_size = (record_size_),                                                     \
+		.n_records = (n_records_),                                                         \
+		.sink = (sink_),                                                                   \
+		.user_data = (user_data_),                                                         \
+	}
+
+/**
+ * @brief Include @p ring in every trigger from now on.
+ */
+void pretrigger_register(struct pretrigger_ring *ring);
+
+/**
+ * @brief Remove @p ring from triggers, records still in it are not sent.
+ */
+void pretrigger_unregister(struct pretrigger_ring *ring);
+
+/**
+ * @brief Store a record and send any records now known to be in a window.
+ *
+ * Called only from the stream's own thread, timestamps must not decrease.
+ */
+void pretrigger_write(struct pretrigger_ring *ring, const void *record, uint64_t timestamp);
+
+/**
+ * @brief Store the window around an event in every registered ring.
+ *
+ * Safe from any thread or ISR.
+ *
+ * @param timestamp Time of the event, in the ring timestamps' units.
+ * @param pre Time kept before the event.
+ * @param post Time kept after the event.
+ */
+void pretrigger_fire(uint64_t timestamp, uint64_t pre, uint64_t post);
+
+/** @} */
+
+#endif /* APP_LIB_PRETRIGGER_H_ */
@@ -0,0 +1,207 @@
+#include <errno.h>
+#include <string.h>
+#include <zephyr/sys/util.h>
+
+#include <app/lib/audio_cls.h>
+#include <app/lib/audio_feat.h>
+
+/* The background rises by 0.1 dB a segment when the room gets louder, about 1.2 dB a
+ * second with 80 ms segments */
+#define FLOOR_RISE (BIT(AUDIO_FEAT_FRAC_BITS) / 10)
+
+/* AUDIO_FEAT_CONFIG_DEFAULT */
+#define DEFAULT_BANDS 16
+
+#define DB(db) ((db) * BIT(AUDIO_FEAT_FRAC_BITS))
+#define FEATURE(segment, band) ((segment) * DEFAULT_BANDS + (band))
+#define SPLIT(segment, band, db, below_, above_)                                                   \
+	{.feature = FEATURE(segment, band), .value = DB(db), .below = (below_), .above = (above_)}
+#define LEAF(score) {.feature = AUDIO_CLS_LEAF, .value = (score)}
+
+/* Bands 2, 9, 12 and 15 of the default features are centred near 390 Hz, 1.6, 2.4 and
+ * 3.5 kHz. Segment 3 is the newest. */
+static const struct audio_cls_node default_nodes[] = {
+	/* Cough: loud above 2 kHz now, more so if it was quiet 240 ms ago */
+	[0] = SPLIT(3, 12, 15, 1, 2),
+	[1] = LEAF(-2),
+	[2] = SPLIT(0, 12, 10, 3, 4),
+	[3] = LEAF(3),
+	[4] = LEAF(1),
+	/* Cough: and across the spectrum */
+	[5] = SPLIT(3, 9, 15, 6, 7),
+	[6] = LEAF(-1),
+	[7] = LEAF(1),
+	[8] = SPLIT(3, 15, 10, 9, 10),
+	[9] = LEAF(-1),
+	[10] = LEAF(1),
+	/* Snore: loud around 400 Hz now and 160 ms ago */
+	[11] = SPLIT(3, 2, 15, 12, 13),
+	[12] = LEAF(-2),
+	[13] = LEAF(2),
+	[14] = SPLIT(1, 2, 15, 15, 16),
+	[15] = LEAF(-1),
+	[16] = LEAF(1),
+	/* Snore: but not broadband */
+	[17] = SPLIT(3, 12, 15, 18, 19),
+	[18] = LEAF(1),
+	[19] = LEAF(-2),
+};
+
+static const struct audio_cls_tree default_trees[] = {
+	{.root = 0, .cls = AUDIO_CLS_COUGH},  {.root = 5, .cls = AUDIO_CLS_COUGH},
+	{.root = 8, .cls = AUDIO_CLS_COUGH},  {.root = 11, .cls = AUDIO_CLS_SNORE},
+	{.root = 14, .cls = AUDIO_CLS_SNORE}, {.root = 17, .cls = AUDIO_CLS_SNORE},
+};
+
+const struct audio_cls_model audio_cls_default_model = {
+	.n_bands = DEFAULT_BANDS,
+	.segment_frames = 8,
+	.n_segments = 4,
+	.n_trees = ARRAY_SIZE(default_trees),
+	.n_nodes = ARRAY_SIZE(default_nodes),
+	.trees = default_trees,
+	.nodes = default_nodes,
+	.threshold = {[AUDIO_CLS_COUGH] = 4, [AUDIO_CLS_SNORE] = 4},
+};
+
+static bool model_valid(const struct audio_cls_model *model)
+{
+	if (model->n_bands == 0 || model->n_bands > CONFIG_AUDIO_FEAT_MAX_BANDS ||
+	    model->segment_frames == 0 || model->n_segments == 0) {
+		return false;
+	}
+
+	for (uint8_t t = 0; t < model->n_trees; t++) {
+		if (model->trees[t].root >= model->n_nodes ||
+		    model->trees[t].cls >= AUDIO_CLS_CLASSES) {
+			return false;
+		}
+	}
+	for (uint16_t i = 0; i < model->n_nodes; i++) {
+		const struct audio_cls_node *node = &model->nodes[i];
+
+		if (node->feature == AUDIO_CLS_LEAF) {
+			continue;
+		}
+		/* Children after their parent, so every walk ends */
+		if (node->feature >= model->n_segments * model->n_bands || node->below <= i ||
+		    node->above <= i || node->below >= model->n_nodes ||
+		    node->above >= model->n_nodes) {
+			return false;
+		}
+	}
+	return true;
+}
+
+int audio_cls_init(struct audio_cls *cls, const struct audio_cls_model *model, uint8_t batch,
+		   audio_cls_sink_t sink, void *user_data)
+{
+	if (batch == 0 || !model_valid(model) ||
+	    model->n_segments + batch - 1 > CONFIG_AUDIO_CLS_MAX_SEGMENTS) {
+		return -EINVAL;
+	}
+
+	memset(cls, 0, sizeof(*cls));
+	cls->model = model;
+	cls->batch = batch;
+	cls->sink = sink;
+	cls->user_data = user_data;
+	return 0;
+}
+
+void audio_cls_reset(struct audio_cls *cls)
+{
+	cls->frames = 0;
+}
+
+/* Levels above the background, which follows the segment down at once and up slowly */
+static void store_segment(struct audio_cls *cls)
+{
+	const struct audio_cls_model *model = cls->model;
+	int16_t *level = cls->level[cls->segments % CONFIG_AUDIO_CLS_MAX_SEGMENTS];
+
+	for (uint8_t b = 0; b < model->n_bands; b++) {
+		int16_t mean = cls->sum[b] / model->segment_frames;
+
+		if (cls->segments == 0) {
+			cls->floor[b] = mean;
+		}
+		level[b] = CLAMP(mean - cls->floor[b], INT16_MIN, INT16_MAX);
+		cls->floor[b] = MIN(mean, cls->floor[b] + FLOOR_RISE);
+	}
+	cls->level_ts[cls->segments % CONFIG_AUDIO_CLS_MAX_SEGMENTS] = cls->segment_ts;
+	cls->segments++;
+
+	/* The oldest waiting segment is about to be overwritten with its context */
+	if (cls->segments - cls->done > CONFIG_AUDIO_CLS_MAX_SEGMENTS - model->n_segments + 1) {
+		cls->done++;
+		cls->skipped++;
+	}
+}
+
+bool audio_cls_push(struct audio_cls *cls, const int16_t *feat, uint8_t n_feat,
+		    uint64_t timestamp)
+{
+	const struct audio_cls_model *model = cls->model;
+
+	if (n_feat != model->n_bands) {
+		return false;
+	}
+
+	if (cls->frames == 0) {
+		memset(cls->sum, 0, sizeof(cls->sum));
+		cls->segment_ts = timestamp;
+	}
+	for (uint8_t b = 0; b < n_feat; b++) {
+		cls->sum[b] += feat[b];
+	}
+	if (++cls->frames == model->segment_frames) {
+		cls->frames = 0;
+		store_segment(cls);
+	}
+
+	return cls->segments - cls->done >= cls->batch;
+}
+
+/* The context ends with segment @p newest */
+static void infer(struct audio_cls *cls, uint32_t newest)
+{
+	const struct audio_cls_model *model = cls->model;
+	const uint32_t oldest = newest + 1 - model->n_segments;
+	int32_t score[AUDIO_CLS_CLASSES] = {0};
+
+	for (uint8_t t = 0; t < model->n_trees; t++) {
+		const struct audio_cls_node *node = &model->nodes[model->trees[t].root];
+
+		while (node->feature != AUDIO_CLS_LEAF) {
+			uint32_t segment = oldest + node->feature / model->n_bands;
+			int16_t level = cls->level[segment % CONFIG_AUDIO_CLS_MAX_SEGMENTS]
+						  [node->feature % model->n_bands];
+
+			node = &model->nodes[level < node->value ? node->below : node->above];
+		}
+		score[model->trees[t].cls] += node->value;
+	}
+	cls->inferences++;
+
+	for (int c = 0; c < AUDIO_CLS_CLASSES; c++) {
+		bool active = score[c] >= model->threshold[c];
+
+		if (active && !cls->active[c]) {
+			cls->events[c]++;
+			cls->sink(c, cls->level_ts[newest % CONFIG_AUDIO_CLS_MAX_SEGMENTS], score[c],
+				  cls->user_data);
+		}
+		cls->active[c] = active;
+	}
+}
+
+void audio_cls_run(struct audio_cls *cls)
+{
+	for (; cls->done < cls->segments; cls->done++) {
+		/* The first few segments have no full context before them */
+		if (cls->done + 1 >= cls->model->n_segments) {
+			infer(cls, cls->done);
+		}
+	}
+}
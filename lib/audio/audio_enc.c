@@ -0,0 +1,237 @@
+#include <errno.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+
+#include <app/lib/audio_enc.h>
+
+struct audio_enc_ops {
+	size_t (*block_bytes)(uint8_t n_channels, size_t n_frames);
+	void (*encode)(struct audio_enc *enc, const int16_t *pcm, size_t n_frames, uint8_t *out);
+	/* Frames in a block of size bytes, 0 if it is not one */
+	size_t (*block_frames)(uint8_t n_channels, size_t size);
+	void (*decode)(uint8_t n_channels, const uint8_t *in, size_t n_frames, int16_t *pcm);
+};
+
+/* IMA-ADPCM, the IMA Digital Audio Focus and Technical Working Groups'
+ * recommended practice of 1992, as in WAV and most Bluetooth headsets */
+
+static const int16_t ima_steps[89] = {
+	7,     8,     9,     10,    11,    12,    13,    14,    16,    17,    19,    21,    23,
+	25,    28,    31,    34,    37,    41,    45,    50,    55,    60,    66,    73,    80,
+	88,    97,    107,   118,   130,   143,   157,   173,   190,   209,   230,   253,   279,
+	307,   337,   371,   408,   449,   494,   544,   598,   658,   724,   796,   876,   963,
+	1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,  2272,  2499,  2749,  3024,  3327,
+	3660,  4026,  4428,  4871,  5358,  5894,  6484,  7132,  7845,  8630,  9493,  10442, 11487,
+	12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+};
+
+static const int8_t ima_index_adjust[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+
+/* Applies a code to the predictor and step index, identical in encoder and decoder */
+static inline void ima_update(int32_t *predictor, int32_t *index, uint8_t code)
+{
+	int32_t step = ima_steps[*index];
+	int32_t diff = step >> 3;
+
+	if (code & 4) {
+		diff += step;
+	}
+	if (code & 2) {
+		diff += step >> 1;
+	}
+	if (code & 1) {
+		diff += step >> 2;
+	}
+	*predictor = CLAMP(*predictor + ((code & 8) ? -diff : diff), INT16_MIN, INT16_MAX);
+	*index = CLAMP(*index + ima_index_adjust[code & 7], 0, ARRAY_SIZE(ima_steps) - 1);
+}
+
+static inline uint8_t ima_code(int32_t predictor, int32_t index, int32_t sample)
+{
+	int32_t step = ima_steps[index];
+	int32_t diff = sample - predictor;
+	uint8_t code = 0;
+
+	if (diff < 0) {
+		code = 8;
+		diff = -diff;
+	}
+	if (diff >= step) {
+		code |= 4;
+		diff -= step;
+	}
+	step >>= 1;
+	if (diff >= step) {
+		code |= 2;
+		diff -= step;
+	}
+	step >>= 1;
+	if (diff >= step) {
+		code |= 1;
+	}
+	return code;
+}
+
+static size_t ima_block_bytes(uint8_t n_channels, size_t n_frames)
+{
+	if (n_frames & 1) {
+		return 0;
+	}
+	return n_channels * (AUDIO_ENC_IMA_HEADER_BYTES + n_frames / 2);
+}
+
+static void ima_encode(struct audio_enc *enc, const int16_t *pcm, size_t n_frames, uint8_t *out)
+{
+	const uint8_t n_channels = enc->n_channels;
+
+	for (uint8_t ch = 0; ch < n_channels; ch++) {
+		int32_t predictor = enc->predictor[ch];
+		int32_t index = enc->index[ch];
+		const int16_t *in = &pcm[ch];
+
+		sys_put_le16(predictor, out);
+		out[2] = index;
+		out[3] = 0;
+		out += AUDIO_ENC_IMA_HEADER_BYTES;
+
+		for (size_t f = 0; f < n_frames; f += 2) {
+			uint8_t lo = ima_code(predictor, index, in[0]);
+			uint8_t hi;
+
+			ima_update(&predictor, &index, lo);
+			hi = ima_code(predictor, index, in[n_channels]);
+			ima_update(&predictor, &index, hi);
+			*out++ = lo | (hi << 4);
+			in += 2 * n_channels;
+		}
+
+		enc->predictor[ch] = predictor;
+		enc->index[ch] = index;
+	}
+}
+
+static size_t ima_block_frames(uint8_t n_channels, size_t size)
+{
+	if (size % n_channels != 0 || size / n_channels <= AUDIO_ENC_IMA_HEADER_BYTES) {
+		return 0;
+	}
+	return 2 * (size / n_channels - AUDIO_ENC_IMA_HEADER_BYTES);
+}
+
+static void ima_decode(uint8_t n_channels, const uint8_t *in, size_t n_frames, int16_t *pcm)
+{
+	for (uint8_t ch = 0; ch < n_channels; ch++) {
+		int32_t predictor = (int16_t)sys_get_le16(in);
+		int32_t index = MIN(in[2], ARRAY_SIZE(ima_steps) - 1);
+		int16_t *out = &pcm[ch];
+
+		in += AUDIO_ENC_IMA_HEADER_BYTES;
+		for (size_t f = 0; f < n_frames; f += 2) {
+			ima_update(&predictor, &index, *in & 0xF);
+			out[0] = predictor;
+			ima_update(&predictor, &index, *in++ >> 4);
+			out[n_channels] = predictor;
+			out += 2 * n_channels;
+		}
+	}
+}
+
+/* G.711 mu-law, segment and 4 bit mantissa of the biased magnitude, inverted */
+
+#define MULAW_BIAS 0x84
+#define MULAW_CLIP 32635
+
+static void mulaw_encode(struct audio_enc *enc, const int16_t *pcm, size_t n_frames, uint8_t *out)
+{
+	for (size_t i = 0; i < n_frames * enc->n_channels; i++) {
+		int32_t x = pcm[i];
+		uint8_t sign = 0;
+
+		if (x < 0) {
+			x = -x;
+			sign = 0x80;
+		}
+		x = MIN(x, MULAW_CLIP) + MULAW_BIAS;
+
+		/* Bit 7 upwards, x is at least the bias so the segment is 0 to 7 */
+		uint8_t segment = 31 - __builtin_clz((uint32_t)x) - 7;
+
+		out[i] = ~(sign | (segment << 4) | ((x >> (segment + 3)) & 0xF));
+	}
+}
+
+static size_t mulaw_block_bytes(uint8_t n_channels, size_t n_frames)
+{
+	return n_channels * n_frames;
+}
+
+static size_t mulaw_block_frames(uint8_t n_channels, size_t size)
+{
+	return size % n_channels == 0 ? size / n_channels : 0;
+}
+
+static void mulaw_decode(uint8_t n_channels, const uint8_t *in, size_t n_frames, int16_t *pcm)
+{
+	for (size_t i = 0; i < n_frames * n_channels; i++) {
+		uint8_t u = ~in[i];
+		uint8_t segment = (u >> 4) & 7;
+		int32_t x = ((((u & 0xF) << 3) + MULAW_BIAS) << segment) - MULAW_BIAS;
+
+		pcm[i] = (u & 0x80) ? -x : x;
+	}
+}
+
+static const struct audio_enc_ops formats[AUDIO_ENC_FORMATS] = {
+	[AUDIO_ENC_IMA_ADPCM] = {ima_block_bytes, ima_encode, ima_block_frames, ima_decode},
+	[AUDIO_ENC_MULAW] = {mulaw_block_bytes, mulaw_encode, mulaw_block_frames, mulaw_decode},
+};
+
+int audio_enc_init(struct audio_enc *enc, enum audio_enc_format format, uint8_t n_channels)
+{
+	if (format >= AUDIO_ENC_FORMATS || n_channels == 0 || n_channels > AUDIO_ENC_MAX_CHANNELS) {
+		return -EINVAL;
+	}
+
+	*enc = (struct audio_enc){
+		.format = format,
+		.n_channels = n_channels,
+	};
+	return 0;
+}
+
+size_t audio_enc_block_bytes(enum audio_enc_format format, uint8_t n_channels, size_t n_frames)
+{
+	if (format >= AUDIO_ENC_FORMATS || n_frames == 0) {
+		return 0;
+	}
+	return formats[format].block_bytes(n_channels, n_frames);
+}
+
+int audio_enc_encode(struct audio_enc *enc, const int16_t *pcm, size_t n_frames, uint8_t *out)
+{
+	const struct audio_enc_ops *ops = &formats[enc->format];
+	size_t size = audio_enc_block_bytes(enc->format, enc->n_channels, n_frames);
+
+	if (size == 0) {
+		return -EINVAL;
+	}
+	ops->encode(enc, pcm, n_frames, out);
+	return size;
+}
+
+int audio_enc_decode(enum audio_enc_format format, uint8_t n_channels, const uint8_t *in,
+		     size_t size, int16_t *pcm)
+{
+	size_t n_frames;
+
+	if (format >= AUDIO_ENC_FORMATS || n_channels == 0 || n_channels > AUDIO_ENC_MAX_CHANNELS) {
+		return -EINVAL;
+	}
+
+	n_frames = formats[format].block_frames(n_channels, size);
+	if (n_frames == 0) {
+		return -EINVAL;
+	}
+	formats[format].decode(n_channels, in, n_frames, pcm);
+	return n_frames;
+}
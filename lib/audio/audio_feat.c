@@ -0,0 +1,201 @@
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+#include <zephyr/sys/util.h>
+
+#include <app/lib/audio_feat.h>
+
+/* Band energy floor, -120 dB, so silence gives a level rather than -inf */
+#define ENERGY_FLOOR 1e-12f
+
+static float hz_to_mel(float hz)
+{
+	return 2595.0f * log10f(1.0f + hz / 700.0f);
+}
+
+static float mel_to_hz(float mel)
+{
+	return 700.0f * (powf(10.0f, mel / 2595.0f) - 1.0f);
+}
+
+/* Triangles from edge j - 1 through centre j to edge j + 1, neighbouring bands sharing the
+ * bins between their centres, so every bin needs one band index and one weight */
+static int design_bands(struct audio_feat *feat)
+{
+	const struct audio_feat_config *cfg = &feat->cfg;
+	const float mel_min = hz_to_mel(cfg->f_min_hz);
+	const float mel_step = (hz_to_mel(cfg->f_max_hz) - mel_min) / (cfg->n_bands + 1);
+	float total[CONFIG_AUDIO_FEAT_MAX_BANDS] = {0};
+	uint8_t j = 0;
+
+	feat->bin_lo = 0;
+	feat->bin_hi = 0;
+	for (uint16_t k = 1; k < cfg->fft_len / 2; k++) {
+		float f = (float)k * feat->fs_hz / cfg->fft_len;
+		float lo;
+		float hi;
+
+		if (f <= cfg->f_min_hz) {
+			continue;
+		}
+		if (f >= cfg->f_max_hz) {
+			break;
+		}
+		while (f >= mel_to_hz(mel_min + (j + 1) * mel_step)) {
+			j++;
+		}
+		lo = mel_to_hz(mel_min + j * mel_step);
+		hi = mel_to_hz(mel_min + (j + 1) * mel_step);
+
+		if (feat->bin_lo == 0) {
+			feat->bin_lo = k;
+		}
+		feat->bin_hi = k;
+		feat->bin_band[k] = j;
+		feat->bin_weight[k] = (hi - f) / (hi - lo);
+		if (j > 0) {
+			total[j - 1] += feat->bin_weight[k];
+		}
+		if (j < cfg->n_bands) {
+			total[j] += 1.0f - feat->bin_weight[k];
+		}
+	}
+
+	for (uint8_t b = 0; b < cfg->n_bands; b++) {
+		if (total[b] <= 0.0f) {
+			return -EINVAL;
+		}
+	}
+	return 0;
+}
+
+int audio_feat_init(struct audio_feat *feat, uint32_t fs_hz, uint32_t ts_hz, uint8_t n_channels,
+		    const struct audio_feat_config *cfg, audio_feat_sink_t sink, void *user_data)
+{
+	float window_sum = 0.0f;
+
+	if (n_channels == 0 || fs_hz == 0 || ts_hz == 0 ||
+	    cfg->fft_len > CONFIG_AUDIO_FEAT_MAX_FFT || cfg->hop == 0 || cfg->hop > cfg->fft_len ||
+	    cfg->n_bands == 0 || cfg->n_bands > CONFIG_AUDIO_FEAT_MAX_BANDS ||
+	    cfg->n_mfcc > MIN(cfg->n_bands, AUDIO_FEAT_MAX_MFCC) ||
+	    cfg->f_min_hz >= cfg->f_max_hz || cfg->f_max_hz > fs_hz / 2) {
+		return -EINVAL;
+	}
+
+	memset(feat, 0, sizeof(*feat));
+	if (arm_rfft_fast_init_f32(&feat->rfft, cfg->fft_len) != ARM_MATH_SUCCESS) {
+		return -EINVAL;
+	}
+	feat->cfg = *cfg;
+	feat->sink = sink;
+	feat->user_data = user_data;
+	feat->n_channels = n_channels;
+	feat->fs_hz = fs_hz;
+	feat->ts_hz = ts_hz;
+
+	for (uint16_t n = 0; n < cfg->fft_len; n++) {
+		feat->window[n] = 0.5f - 0.5f * cosf(2.0f * (float)M_PI * n / cfg->fft_len);
+		window_sum += feat->window[n];
+	}
+	/* A sine of amplitude 1 peaks at window_sum / 2 */
+	feat->norm = 4.0f / (window_sum * window_sum);
+
+	for (uint8_t k = 0; k < cfg->n_mfcc; k++) {
+		for (uint8_t b = 0; b < cfg->n_bands; b++) {
+			feat->dct[k][b] = cosf((float)M_PI * k * (b + 0.5f) / cfg->n_bands) /
+					  cfg->n_bands;
+		}
+	}
+
+	return design_bands(feat);
+}
+
+void audio_feat_reset(struct audio_feat *feat)
+{
+	feat->fill = 0;
+}
+
+static int16_t quantise(float db)
+{
+	return CLAMP(lrintf(db * BIT(AUDIO_FEAT_FRAC_BITS)), INT16_MIN, INT16_MAX);
+}
+
+static void emit(struct audio_feat *feat, uint64_t timestamp)
+{
+	const struct audio_feat_config *cfg = &feat->cfg;
+	const uint16_t n = cfg->fft_len;
+	/* Windowed samples in the first half, spectrum in the second. Then the power spectrum
+	 * goes in the first half and the band levels in the second. */
+	float *samples = feat->scratch;
+	float *spectrum = &feat->scratch[n];
+	float *power = feat->scratch;
+	float *bands = &feat->scratch[n];
+
+	arm_mult_f32(feat->history, feat->window, samples, n);
+	arm_rfft_fast_f32(&feat->rfft, samples, spectrum, 0);
+
+	/* DC and Nyquist come packed in the first pair and are never in a band */
+	arm_cmplx_mag_squared_f32(spectrum, power, n / 2);
+
+	memset(bands, 0, cfg->n_bands * sizeof(float));
+	for (uint16_t k = feat->bin_lo; k <= feat->bin_hi; k++) {
+		uint8_t j = feat->bin_band[k];
+		float w = feat->bin_weight[k];
+
+		if (j > 0) {
+			bands[j - 1] += w * power[k];
+		}
+		if (j < cfg->n_bands) {
+			bands[j] += (1.0f - w) * power[k];
+		}
+	}
+	for (uint8_t b = 0; b < cfg->n_bands; b++) {
+		bands[b] = 10.0f * log10f(bands[b] * feat->norm + ENERGY_FLOOR);
+	}
+
+	if (cfg->n_mfcc == 0) {
+		for (uint8_t b = 0; b < cfg->n_bands; b++) {
+			feat->out[b] = quantise(bands[b]);
+		}
+	} else {
+		for (uint8_t k = 0; k < cfg->n_mfcc; k++) {
+			float c = 0.0f;
+
+			for (uint8_t b = 0; b < cfg->n_bands; b++) {
+				c += feat->dct[k][b] * bands[b];
+			}
+			feat->out[k] = quantise(c);
+		}
+	}
+
+	feat->frames++;
+	feat->sink(feat->out, cfg->n_mfcc ? cfg->n_mfcc : cfg->n_bands, timestamp,
+		   feat->user_data);
+}
+
+void audio_feat_process(struct audio_feat *feat, const int16_t *pcm, size_t n_frames,
+			uint64_t timestamp)
+{
+	const uint16_t n = feat->cfg.fft_len;
+	const uint16_t hop = feat->cfg.hop;
+	const float scale = 1.0f / (32768.0f * feat->n_channels);
+
+	for (size_t i = 0; i < n_frames; i++, pcm += feat->n_channels) {
+		int32_t sum = 0;
+
+		for (uint8_t ch = 0; ch < feat->n_channels; ch++) {
+			sum += pcm[ch];
+		}
+		feat->history[feat->fill++] = sum * scale;
+
+		if (feat->fill == n) {
+			/* The window started n - 1 samples before this one, maybe in an earlier
+			 * block */
+			int64_t offset = (int64_t)i + 1 - n;
+
+			emit(feat, timestamp + offset * (int64_t)feat->ts_hz / (int64_t)feat->fs_hz);
+			memmove(feat->history, &feat->history[hop], (n - hop) * sizeof(float));
+			feat->fill -= hop;
+		}
+	}
+}
@@ -0,0 +1,94 @@
+#include <errno.h>
+#include <string.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+
+#include <app/lib/audio_health.h>
+
+/* Up to 1/1024 of a period a block, drift of up to 1000 ppm is absorbed */
+#define DRIFT_SHIFT 10
+
+void audio_health_init(struct audio_health *h, uint32_t block_us)
+{
+	memset(h, 0, sizeof(*h));
+	h->block_us = block_us;
+}
+
+void audio_health_start(struct audio_health *h, uint64_t now_us)
+{
+	h->anchor_us = now_us + h->block_us;
+	h->run_blocks = 0;
+}
+
+static uint8_t latency_bin(uint32_t latency_us)
+{
+	uint8_t bin = 0;
+
+	for (uint32_t edge = AUDIO_HEALTH_LATENCY_BIN0_US;
+	     latency_us >= edge && bin < AUDIO_HEALTH_LATENCY_BINS - 1; edge <<= 1) {
+		bin++;
+	}
+	return bin;
+}
+
+void audio_health_block(struct audio_health *h, uint64_t now_us, uint16_t slab_used,
+			uint16_t dma_queued)
+{
+	uint64_t completed = h->anchor_us + (uint64_t)h->run_blocks * h->block_us;
+	uint32_t latency_us = 0;
+
+	/* Sooner than predicted, the prediction was late. Later, creep towards it a little
+	 * so a sample clock slower than the timebase does not read as latency. */
+	if (now_us < completed) {
+		h->anchor_us -= completed - now_us;
+	} else {
+		latency_us = MIN(now_us - completed, UINT32_MAX);
+		h->anchor_us += MIN(latency_us, h->block_us >> DRIFT_SHIFT);
+	}
+
+	h->run_blocks++;
+	h->blocks++;
+	h->slab_used_max = MAX(h->slab_used_max, slab_used);
+	h->latency_max_us = MAX(h->latency_max_us, latency_us);
+	h->latency[latency_bin(latency_us)]++;
+	h->dma_queued[MIN(dma_queued, AUDIO_HEALTH_QUEUE_BINS - 1)]++;
+}
+
+void audio_health_error(struct audio_health *h, int err)
+{
+	if (err == -EIO) {
+		h->rx_overruns++;
+	} else {
+		h->rx_errors++;
+	}
+}
+
+int audio_health_encode(const struct audio_health *h, uint8_t *buf, size_t size)
+{
+	uint8_t *p = buf;
+
+	if (size < AUDIO_HEALTH_RECORD_BYTES) {
+		return -ENOMEM;
+	}
+
+	*p++ = AUDIO_HEALTH_VERSION;
+	*p++ = AUDIO_HEALTH_LATENCY_BINS;
+	*p++ = AUDIO_HEALTH_QUEUE_BINS;
+	*p++ = 0;
+	sys_put_le32(h->blocks, p);
+	sys_put_le32(h->rx_overruns, p + 4);
+	sys_put_le32(h->rx_errors, p + 8);
+	sys_put_le32(h->tx_underruns, p + 12);
+	sys_put_le32(h->restarts, p + 16);
+	sys_put_le16(h->slab_used_max, p + 20);
+	sys_put_le16(0, p + 22);
+	sys_put_le32(h->latency_max_us, p + 24);
+	p += 28;
+	for (int i = 0; i < AUDIO_HEALTH_LATENCY_BINS; i++, p += 4) {
+		sys_put_le32(h->latency[i], p);
+	}
+	for (int i = 0; i < AUDIO_HEALTH_QUEUE_BINS; i++, p += 4) {
+		sys_put_le32(h->dma_queued[i], p);
+	}
+	return p - buf;
+}
@@ -0,0 +1,142 @@
+#include <errno.h>
+#include <zephyr/kernel.h>
+#include <zephyr/spinlock.h>
+
+#include <app/lib/audio_pipe.h>
+
+void audio_pipe_register(struct audio_pipe *pipe, struct audio_pipe_consumer *consumer)
+{
+	k_spinlock_key_t key = k_spin_lock(&pipe->lock);
+
+	sys_slist_append(&pipe->consumers, &consumer->node);
+	k_spin_unlock(&pipe->lock, key);
+}
+
+void audio_pipe_unregister(struct audio_pipe *pipe, struct audio_pipe_consumer *consumer)
+{
+	struct audio_block *block;
+	k_spinlock_key_t key = k_spin_lock(&pipe->lock);
+
+	sys_slist_find_and_remove(&pipe->consumers, &consumer->node);
+	k_spin_unlock(&pipe->lock, key);
+
+	while (k_msgq_get(consumer->queue, &block, K_NO_WAIT) == 0) {
+		audio_pipe_release(block);
+	}
+}
+
+/* The consumer furthest behind gives up its oldest queued block. Other consumers have
+ * normally released that block already, so its descriptor comes free. */
+static bool reclaim(struct audio_pipe *pipe)
+{
+	struct audio_pipe_consumer *consumer;
+	struct audio_pipe_consumer *slowest;
+	struct audio_block *oldest;
+
+	do {
+		k_spinlock_key_t key = k_spin_lock(&pipe->lock);
+
+		slowest = NULL;
+		SYS_SLIST_FOR_EACH_CONTAINER(&pipe->consumers, consumer, node) {
+			if (k_msgq_num_used_get(consumer->queue) > 0 &&
+			    (slowest == NULL || k_msgq_num_used_get(consumer->queue) >
+							k_msgq_num_used_get(slowest->queue))) {
+				slowest = consumer;
+			}
+		}
+		if (slowest == NULL || k_msgq_get(slowest->queue, &oldest, K_NO_WAIT) != 0) {
+			k_spin_unlock(&pipe->lock, key);
+			return false;
+		}
+		atomic_inc(&slowest->dropped);
+		k_spin_unlock(&pipe->lock, key);
+
+		audio_pipe_release(oldest);
+	} while (k_mem_slab_num_free_get(pipe->descs) == 0);
+
+	return true;
+}
+
+static bool deliver(struct audio_pipe_consumer *consumer, struct audio_block *block)
+{
+	struct audio_block *oldest;
+
+	if (k_msgq_put(consumer->queue, &block, K_NO_WAIT) != 0) {
+		if (consumer->overrun != AUDIO_PIPE_DROP_OLDEST ||
+		    k_msgq_get(consumer->queue, &oldest, K_NO_WAIT) != 0) {
+			return false;
+		}
+		audio_pipe_release(oldest);
+		atomic_inc(&consumer->dropped);
+		if (k_msgq_put(consumer->queue, &block, K_NO_WAIT) != 0) {
+			return false;
+		}
+	}
+
+	uint32_t queued = k_msgq_num_used_get(consumer->queue);
+
+	if (queued > (uint32_t)atomic_get(&consumer->max_queued)) {
+		atomic_set(&consumer->max_queued, queued);
+	}
+	return true;
+}
+
+int audio_pipe_publish(struct audio_pipe *pipe, void *data, size_t size, uint64_t timestamp)
+{
+	struct audio_pipe_consumer *consumer;
+	struct audio_block *block;
+	bool taken = false;
+
+	while (k_mem_slab_alloc(pipe->descs, (void **)&block, K_NO_WAIT) != 0) {
+		if (!reclaim(pipe)) {
+			atomic_inc(&pipe->dropped);
+			k_mem_slab_free(pipe->slab, data);
+			return -ENOMEM;
+		}
+	}
+
+	block->data = data;
+	block->size = size;
+	block->timestamp = timestamp;
+	block->pipe = pipe;
+	/* The publisher's own reference keeps the block alive until every consumer has it */
+	atomic_set(&block->refs, 1);
+
+	k_spinlock_key_t key = k_spin_lock(&pipe->lock);
+
+	block->seq = pipe->seq++;
+	SYS_SLIST_FOR_EACH_CONTAINER(&pipe->consumers, consumer, node) {
+		atomic_inc(&block->refs);
+		if (deliver(consumer, block)) {
+			taken = true;
+		} else {
+			atomic_dec(&block->refs);
+			atomic_inc(&consumer->dropped);
+		}
+	}
+	k_spin_unlock(&pipe->lock, key);
+
+	audio_pipe_release(block);
+	return taken ? 0 : -ENODATA;
+}
+
+struct audio_block *audio_pipe_get(struct audio_pipe_consumer *consumer, k_timeout_t timeout)
+{
+	struct audio_block *block;
+
+	if (k_msgq_get(consumer->queue, &block, timeout) != 0) {
+		return NULL;
+	}
+	return block;
+}
+
+void audio_pipe_release(struct audio_block *block)
+{
+	struct audio_pipe *pipe = block->pipe;
+
+	/* atomic_dec returns the value before */
+	if (atomic_dec(&block->refs) == 1) {
+		k_mem_slab_free(pipe->slab, block->data);
+		k_mem_slab_free(pipe->descs, block);
+	}
+}
@@ -0,0 +1,146 @@
+#include <errno.h>
+#include <string.h>
+#include <zephyr/sys/util.h>
+
+#include <app/lib/audio_vad.h>
+
+/* 10^0.1 in Q16, one dB of energy */
+#define DB_Q16 82506
+
+/* ln(10) / 10 in Q16, energy grows by about this fraction per dB for the fractions of a dB
+ * the floor rises in a block */
+#define DB_FRACTION_Q16 15093
+
+/* Hiss is still active this far, 6 dB, above the threshold */
+#define HISS_MARGIN 4
+
+/* Whole blocks covering @p ms */
+static uint32_t ms_to_blocks(uint32_t ms, uint32_t fs_hz, uint16_t block_frames)
+{
+	return DIV_ROUND_UP((uint64_t)ms * fs_hz, (uint64_t)block_frames * 1000);
+}
+
+int audio_vad_init(struct audio_vad *vad, uint32_t fs_hz, uint8_t n_channels,
+		   uint16_t block_frames, const struct audio_vad_config *cfg, audio_vad_sink_t sink,
+		   void *user_data)
+{
+	uint64_t ratio = BIT(8);
+	uint32_t preroll_blocks;
+
+	if (fs_hz == 0 || n_channels == 0 || block_frames == 0 ||
+	    (size_t)n_channels * block_frames * sizeof(int16_t) > CONFIG_AUDIO_VAD_BLOCK_BYTES ||
+	    cfg->threshold_db > 30) {
+		return -EINVAL;
+	}
+	preroll_blocks = ms_to_blocks(cfg->preroll_ms, fs_hz, block_frames);
+	if (preroll_blocks > CONFIG_AUDIO_VAD_PREROLL_BLOCKS) {
+		return -EINVAL;
+	}
+
+	for (uint8_t db = 0; db < cfg->threshold_db; db++) {
+		ratio = (ratio * DB_Q16) >> 16;
+	}
+
+	memset(vad, 0, sizeof(*vad));
+	vad->cfg = *cfg;
+	vad->sink = sink;
+	vad->user_data = user_data;
+	vad->n_channels = n_channels;
+	vad->block_frames = block_frames;
+	vad->hangover_blocks = MIN(ms_to_blocks(cfg->hangover_ms, fs_hz, block_frames), UINT16_MAX);
+	vad->preroll_blocks = preroll_blocks;
+	vad->ratio = ratio;
+	vad->rise = (uint64_t)cfg->floor_rise_db * block_frames * DB_FRACTION_Q16 / fs_hz;
+	return 0;
+}
+
+/* Mean square over every channel, zero crossings per 1000 samples of the first */
+static void measure(const struct audio_vad *vad, const int16_t *pcm, uint32_t *energy,
+		    uint32_t *zcr)
+{
+	const size_t n = (size_t)vad->block_frames * vad->n_channels;
+	uint64_t sum = 0;
+	uint32_t crossings = 0;
+	bool negative = pcm[0] < 0;
+
+	for (size_t i = 0; i < n; i++) {
+		sum += (int32_t)pcm[i] * pcm[i];
+	}
+	for (size_t i = vad->n_channels; i < n; i += vad->n_channels) {
+		if ((pcm[i] < 0) != negative) {
+			negative = !negative;
+			crossings++;
+		}
+	}
+
+	*energy = sum / n;
+	*zcr = crossings * 1000 / vad->block_frames;
+}
+
+static bool classify(struct audio_vad *vad, const int16_t *pcm)
+{
+	uint32_t energy;
+	uint32_t zcr;
+	uint64_t threshold;
+
+	measure(vad, pcm, &energy, &zcr);
+
+	if (vad->blocks_in == 0) {
+		vad->floor = (uint64_t)energy << 8;
+	}
+	/* Threshold from the floor before this block, so a loud block cannot raise its own */
+	threshold = (MAX(vad->floor, BIT(8)) * vad->ratio) >> 16;
+
+	/* Follow quieter blocks at once, louder ones slowly, whatever the decision, so a
+	 * lasting rise in room noise is not active for ever */
+	vad->floor = MIN((uint64_t)energy << 8, vad->floor + ((vad->floor * vad->rise) >> 16) + 1);
+
+	if (energy <= threshold) {
+		return false;
+	}
+	return zcr <= vad->cfg.zcr_max || energy > HISS_MARGIN * threshold;
+}
+
+static void forward(struct audio_vad *vad, const int16_t *pcm, uint64_t timestamp)
+{
+	vad->sink(pcm, vad->block_frames, timestamp, vad->user_data);
+	vad->blocks_out++;
+}
+
+bool audio_vad_process(struct audio_vad *vad, const int16_t *pcm, uint64_t timestamp)
+{
+	const size_t size = (size_t)vad->block_frames * vad->n_channels * sizeof(int16_t);
+	bool active = classify(vad, pcm);
+
+	vad->blocks_in++;
+
+	if (active) {
+		/* Onset, the pre-roll first, oldest first */
+		for (; vad->count > 0; vad->count--) {
+			forward(vad, vad->preroll[vad->head], vad->preroll_ts[vad->head]);
+			vad->head = (vad->head + 1) % vad->preroll_blocks;
+		}
+		vad->hangover = vad->hangover_blocks;
+		forward(vad, pcm, timestamp);
+		return true;
+	}
+
+	if (vad->hangover > 0) {
+		vad->hangover--;
+		forward(vad, pcm, timestamp);
+		return true;
+	}
+
+	if (vad->preroll_blocks > 0) {
+		uint16_t tail = (vad->head + vad->count) % vad->preroll_blocks;
+
+		memcpy(vad->preroll[tail], pcm, size);
+		vad->preroll_ts[tail] = timestamp;
+		if (vad->count < vad->preroll_blocks) {
+			vad->count++;
+		} else {
+			vad->head = (vad->head + 1) % vad->preroll_blocks;
+		}
+	}
+	return false;
+}
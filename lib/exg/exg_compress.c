@@ -0,0 +1,381 @@
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+
+#include <app/lib/exg_compress.h>
+
+/* Per channel per block: 24 bit first sample when the block opens a packet, 2 bit predictor
+ * order, 5 bit Rice parameter, then one code per remaining sample. Codes are the zigzag
+ * mapped residual u as u >> k zeros, a one and the k low bits of u, or 24 bits of the sample
+ * itself when k is RICE_ESCAPE. */
+
+#define SAMPLE_BITS 24
+#define ORDER_BITS 2
+#define RICE_BITS 5
+#define RICE_ESCAPE 31
+#define MAX_ORDER 3
+#define PACKET_BITS (CONFIG_EXG_COMPRESS_PACKET_BYTES * 8)
+
+/* Worst case for a block of every channel: verbatim */
+#define BLOCK_MAX_BITS                                                                             \
+	(EXG_MAX_CHANNELS * (ORDER_BITS + RICE_BITS + SAMPLE_BITS * EXG_COMPRESS_BLOCK_FRAMES))
+
+BUILD_ASSERT(EXG_COMPRESS_HEADER_BYTES * 8 + BLOCK_MAX_BITS <= PACKET_BITS,
+	     "A block must always fit a packet");
+
+struct channel_plan {
+	uint8_t order;
+	uint8_t k;
+};
+
+static inline uint32_t zigzag(int32_t e)
+{
+	return ((uint32_t)e << 1) ^ (uint32_t)(e >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t u)
+{
+	return (int32_t)(u >> 1) ^ -(int32_t)(u & 1);
+}
+
+/* Fixed polynomial predictors, h[0] the most recent sample */
+static inline int32_t predict(uint8_t order, int32_t h0, int32_t h1, int32_t h2)
+{
+	switch (order) {
+	case 0:
+		return 0;
+	case 1:
+		return h0;
+	case 2:
+		return 2 * h0 - h1;
+	default:
+		return 3 * h0 - 3 * h1 + h2;
+	}
+}
+
+static void put_bits(struct exg_compress *c, uint32_t v, uint8_t n)
+{
+	c->acc = (c->acc << n) | (v & (uint32_t)BIT64_MASK(n));
+	c->acc_bits += n;
+	while (c->acc_bits >= 8) {
+		c->acc_bits -= 8;
+		c->packet[c->pos++] = (uint8_t)(c->acc >> c->acc_bits);
+	}
+}
+
+static void put_rice(struct exg_compress *c, uint32_t u, uint8_t k)
+{
+	uint32_t q = u >> k;
+
+	while (q >= 32) {
+		put_bits(c, 0, 32);
+		q -= 32;
+	}
+	put_bits(c, 1, q + 1);
+	if (k > 0) {
+		put_bits(c, u, k);
+	}
+}
+
+static uint32_t bits_used(const struct exg_compress *c)
+{
+	return c->pos * 8 + c->acc_bits;
+}
+
+static void open_packet(struct exg_compress *c)
+{
+	c->first_frame = c->next_frame;
+	c->n_frames = 0;
+	c->acc = 0;
+	c->acc_bits = 0;
+	c->pos = EXG_COMPRESS_HEADER_BYTES;
+}
+
+static void close_packet(struct exg_compress *c, uint8_t *out)
+{
+	if (c->acc_bits > 0) {
+		put_bits(c, 0, 8 - c->acc_bits);
+	}
+	memset(&c->packet[c->pos], 0, sizeof(c->packet) - c->pos);
+
+	sys_put_le32(c->first_frame, &c->packet[0]);
+	sys_put_le16(c->n_frames, &c->packet[4]);
+	c->packet[6] = c->n_channels;
+	c->packet[7] = EXG_COMPRESS_VERSION;
+
+	memcpy(out, c->packet, sizeof(c->packet));
+	open_packet(c);
+}
+
+/* Order with the smallest residual sum, then the cheapest Rice parameter around its mean.
+ * Returns the cost in bits, not counting a first sample. */
+static uint32_t plan_channel(const int32_t *x, uint32_t start, uint32_t len, const int32_t *hist,
+			     struct channel_plan *plan)
+{
+	uint32_t u[MAX_ORDER + 1][EXG_COMPRESS_BLOCK_FRAMES];
+	uint32_t sum[MAX_ORDER + 1] = {0};
+	int32_t h0 = hist[0];
+	int32_t h1 = hist[1];
+	int32_t h2 = hist[2];
+	uint32_t count = len - start;
+
+	/* 24 bit input keeps third order residuals under 2^27 and the sums under 2^31 */
+	for (uint32_t i = start; i < len; i++) {
+		int32_t d1 = x[i] - h0;
+		int32_t d2 = d1 - (h0 - h1);
+		int32_t d3 = d2 - (h0 - 2 * h1 + h2);
+
+		u[0][i] = zigzag(x[i]);
+		u[1][i] = zigzag(d1);
+		u[2][i] = zigzag(d2);
+		u[3][i] = zigzag(d3);
+		sum[0] += u[0][i];
+		sum[1] += u[1][i];
+		sum[2] += u[2][i];
+		sum[3] += u[3][i];
+		h2 = h1;
+		h1 = h0;
+		h0 = x[i];
+	}
+
+	plan->order = 0;
+	for (uint8_t o = 1; o <= MAX_ORDER; o++) {
+		if (sum[o] < sum[plan->order]) {
+			plan->order = o;
+		}
+	}
+
+	uint32_t best = count * SAMPLE_BITS;
+	uint32_t mean = count > 0 ? sum[plan->order] / count : 0;
+	int k0 = mean > 0 ? 31 - __builtin_clz(mean) : 0;
+
+	plan->k = RICE_ESCAPE;
+	for (int k = MAX(k0 - 1, 0); k <= MIN(k0 + 1, RICE_ESCAPE - 1); k++) {
+		uint32_t cost = count * (k + 1);
+
+		for (uint32_t i = start; i < len && cost < best; i++) {
+			cost += u[plan->order][i] >> k;
+		}
+		if (cost < best) {
+			best = cost;
+			plan->k = k;
+		}
+	}
+	return ORDER_BITS + RICE_BITS + best;
+}
+
+static uint32_t plan_block(const struct exg_compress *c, uint32_t len, struct channel_plan *plan)
+{
+	uint32_t start = c->n_frames == 0 ? 1 : 0;
+	uint32_t bits = 0;
+
+	for (uint8_t ch = 0; ch < c->n_channels; ch++) {
+		int32_t first[3];
+		const int32_t *hist = c->hist[ch];
+
+		if (start) {
+			first[0] = first[1] = first[2] = c->pending[ch][0];
+			hist = first;
+			bits += SAMPLE_BITS;
+		}
+		bits += plan_channel(c->pending[ch], start, len, hist, &plan[ch]);
+	}
+	return bits;
+}
+
+static void write_block(struct exg_compress *c, uint32_t len, const struct channel_plan *plan)
+{
+	uint32_t start = c->n_frames == 0 ? 1 : 0;
+
+	for (uint8_t ch = 0; ch < c->n_channels; ch++) {
+		const int32_t *x = c->pending[ch];
+		int32_t *h = c->hist[ch];
+
+		if (start) {
+			put_bits(c, (uint32_t)x[0], SAMPLE_BITS);
+			h[0] = h[1] = h[2] = x[0];
+		}
+		put_bits(c, plan[ch].order, ORDER_BITS);
+		put_bits(c, plan[ch].k, RICE_BITS);
+
+		for (uint32_t i = start; i < len; i++) {
+			if (plan[ch].k == RICE_ESCAPE) {
+				put_bits(c, (uint32_t)x[i], SAMPLE_BITS);
+			} else {
+				put_rice(c, zigzag(x[i] - predict(plan[ch].order, h[0], h[1], h[2])),
+					 plan[ch].k);
+			}
+			h[2] = h[1];
+			h[1] = h[0];
+			h[0] = x[i];
+		}
+	}
+
+	c->n_frames += len;
+	c->next_frame += len;
+}
+
+/* Returns packets closed, 0 or 1 */
+static int encode_block(struct exg_compress *c, uint32_t len, uint8_t *out)
+{
+	struct channel_plan plan[EXG_MAX_CHANNELS];
+	uint32_t bits = plan_block(c, len, plan);
+	int closed = 0;
+
+	if (c->n_frames > 0 &&
+	    (bits_used(c) + bits > PACKET_BITS || c->n_frames + len > UINT16_MAX)) {
+		close_packet(c, out);
+		closed = 1;
+		/* The first sample is sent whole in a new packet, the choice may differ */
+		plan_block(c, len, plan);
+	}
+
+	write_block(c, len, plan);
+	return closed;
+}
+
+int exg_compress_init(struct exg_compress *c, uint8_t n_channels)
+{
+	if (n_channels == 0 || n_channels > EXG_MAX_CHANNELS) {
+		return -EINVAL;
+	}
+
+	memset(c, 0, offsetof(struct exg_compress, packet));
+	c->n_channels = n_channels;
+	open_packet(c);
+	return 0;
+}
+
+int exg_compress_process(struct exg_compress *c, const int32_t *rows, uint32_t n, uint32_t stride,
+			 uint8_t *out, uint32_t max_packets)
+{
+	int n_packets = 0;
+
+	if (max_packets < EXG_COMPRESS_MAX_PACKETS(n)) {
+		return -ENOMEM;
+	}
+
+	for (uint32_t k = 0; k < n;) {
+		uint32_t take = MIN(EXG_COMPRESS_BLOCK_FRAMES - c->n_pending, n - k);
+
+		for (uint8_t ch = 0; ch < c->n_channels; ch++) {
+			memcpy(&c->pending[ch][c->n_pending], &rows[ch * stride + k],
+			       take * sizeof(int32_t));
+		}
+		c->n_pending += take;
+		k += take;
+
+		if (c->n_pending == EXG_COMPRESS_BLOCK_FRAMES) {
+			n_packets += encode_block(c, EXG_COMPRESS_BLOCK_FRAMES,
+						  &out[n_packets * CONFIG_EXG_COMPRESS_PACKET_BYTES]);
+			c->n_pending = 0;
+		}
+	}
+	return n_packets;
+}
+
+int exg_compress_flush(struct exg_compress *c, uint8_t *out)
+{
+	int n_packets = 0;
+
+	if (c->n_pending > 0) {
+		n_packets += encode_block(c, c->n_pending, out);
+		c->n_pending = 0;
+	}
+	if (c->n_frames > 0) {
+		close_packet(c, &out[n_packets * CONFIG_EXG_COMPRESS_PACKET_BYTES]);
+		n_packets++;
+	}
+	return n_packets;
+}
+
+struct bit_reader {
+	const uint8_t *buf;
+	uint32_t pos;
+	uint32_t end;
+	bool overrun;
+};
+
+static uint32_t get_bits(struct bit_reader *r, uint8_t n)
+{
+	uint32_t v = 0;
+
+	if (r->pos + n > r->end) {
+		r->overrun = true;
+		return 0;
+	}
+	for (uint8_t i = 0; i < n; i++, r->pos++) {
+		v = (v << 1) | ((r->buf[r->pos / 8] >> (7 - r->pos % 8)) & 1);
+	}
+	return v;
+}
+
+static uint32_t get_rice(struct bit_reader *r, uint8_t k)
+{
+	uint32_t q = 0;
+
+	while (!r->overrun && get_bits(r, 1) == 0) {
+		q++;
+	}
+	return (q << k) | get_bits(r, k);
+}
+
+int exg_compress_decode(const uint8_t *packet, struct exg_compress_info *info, int32_t *rows,
+			uint32_t stride)
+{
+	struct bit_reader r = {
+		.buf = packet,
+		.pos = EXG_COMPRESS_HEADER_BYTES * 8,
+		.end = PACKET_BITS,
+	};
+
+	info->first_frame = sys_get_le32(&packet[0]);
+	info->n_frames = sys_get_le16(&packet[4]);
+	info->n_channels = packet[6];
+
+	if (packet[7] != EXG_COMPRESS_VERSION || info->n_channels == 0 ||
+	    info->n_channels > EXG_MAX_CHANNELS) {
+		return -EINVAL;
+	}
+	if (info->n_frames > stride) {
+		return -ENOMEM;
+	}
+
+	int32_t hist[EXG_MAX_CHANNELS][3];
+
+	for (uint32_t f = 0; f < info->n_frames; f += EXG_COMPRESS_BLOCK_FRAMES) {
+		uint32_t len = MIN(EXG_COMPRESS_BLOCK_FRAMES, info->n_frames - f);
+		uint32_t start = f == 0 ? 1 : 0;
+
+		for (uint8_t ch = 0; ch < info->n_channels; ch++) {
+			int32_t *x = &rows[ch * stride + f];
+			int32_t *h = hist[ch];
+
+			if (start) {
+				x[0] = sign_extend(get_bits(&r, SAMPLE_BITS), SAMPLE_BITS - 1);
+				h[0] = h[1] = h[2] = x[0];
+			}
+			uint8_t order = get_bits(&r, ORDER_BITS);
+			uint8_t k = get_bits(&r, RICE_BITS);
+
+			for (uint32_t i = start; i < len; i++) {
+				if (k == RICE_ESCAPE) {
+					x[i] = sign_extend(get_bits(&r, SAMPLE_BITS), SAMPLE_BITS - 1);
+				} else {
+					x[i] = predict(order, h[0], h[1], h[2]) +
+					       unzigzag(get_rice(&r, k));
+				}
+				h[2] = h[1];
+				h[1] = h[0];
+				h[0] = x[i];
+			}
+			if (r.overrun) {
+				return -EINVAL;
+			}
+		}
+	}
+	return info->n_frames;
+}
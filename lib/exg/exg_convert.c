@@ -0,0 +1,101 @@
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/unaligned.h>
+#include <zephyr/sys/util.h>
+
+#include <app/drivers/ads1298.h>
+#include <app/lib/exg_convert.h>
+
+/* Samples are handled as x = counts << 8, the 24 bit value in the top of a 32 bit word, so
+ * sign extension comes for free and both output formats are out = x * mul >> 31 with one
+ * 32x32->64 multiply (SMULL on the M33).
+ *
+ * Unpacking reads four samples with three unaligned word loads and byte reverses (REV)
+ * instead of twelve byte loads. With the words reversed to b0b1b2b3 b4b5b6b7 b8b9b10b11:
+ *   x0 = b0 b1 b2 --   x1 = b3 b4 b5 --   x2 = b6 b7 b8 --   x3 = b9 b10 b11 --
+ */
+
+#define STATUS_BYTES 3
+
+BUILD_ASSERT(EXG_MAX_CHANNELS == 2 * ADS1298_DEVICE_CHANNELS);
+BUILD_ASSERT(ADS1298_DEVICE_CHANNELS == 8, "Unpacking assumes two groups of four samples");
+
+static inline uint32_t load_be32(const uint8_t *p)
+{
+	return sys_be32_to_cpu(UNALIGNED_GET((const uint32_t *)p));
+}
+
+static inline void unpack4(const uint8_t *p, int32_t *x)
+{
+	uint32_t w0 = load_be32(p);
+	uint32_t w1 = load_be32(p + 4);
+	uint32_t w2 = load_be32(p + 8);
+
+	x[0] = (int32_t)(w0 & 0xFFFFFF00);
+	x[1] = (int32_t)((w0 << 24) | ((w1 >> 8) & 0x00FFFF00));
+	x[2] = (int32_t)((w1 << 16) | ((w2 >> 16) & 0x0000FF00));
+	x[3] = (int32_t)(w2 << 8);
+}
+
+static inline int32_t scale(int32_t x, int32_t mul)
+{
+	return (int32_t)(((int64_t)x * mul) >> 31);
+}
+
+void exg_convert_init_uv(struct exg_convert *cv, uint8_t n_devices, const uint8_t *gain,
+			 uint32_t vref_uv)
+{
+	cv->n_devices = n_devices;
+
+	/* uV = counts * Vref / (gain * 2^23) = x * (Vref / gain) / 2^31 */
+	for (unsigned int ch = 0; ch < n_devices * ADS1298_DEVICE_CHANNELS; ch++) {
+		cv->mul[ch] = gain[ch] ? vref_uv / gain[ch] : 0;
+	}
+}
+
+void exg_convert_init_q31(struct exg_convert *cv, uint8_t n_devices, const uint8_t *gain,
+			  uint32_t vref_uv)
+{
+	cv->n_devices = n_devices;
+
+	/* q31 = V * 2^(31 - shift) = x * (Vref * 2^(31 - shift) / (gain * 1e6)) / 2^31 */
+	for (unsigned int ch = 0; ch < n_devices * ADS1298_DEVICE_CHANNELS; ch++) {
+		int64_t mul = gain[ch] ? ((int64_t)vref_uv << (31 - EXG_CONVERT_Q31_SHIFT)) /
+					 ((int64_t)gain[ch] * 1000000)
+				       : 0;
+
+		/* Only 4 V at gain 1 reaches 1.0, one LSB short is well below the noise */
+		cv->mul[ch] = MIN(mul, INT32_MAX);
+	}
+}
+
+void exg_convert_init_counts(struct exg_convert *cv, uint8_t n_devices)
+{
+	cv->n_devices = n_devices;
+
+	/* counts = x * 2^23 / 2^31 */
+	for (unsigned int ch = 0; ch < n_devices * ADS1298_DEVICE_CHANNELS; ch++) {
+		cv->mul[ch] = BIT(23);
+	}
+}
+
+void exg_convert_block(const struct exg_convert *cv, const uint8_t *frames, uint32_t n_frames,
+		       int32_t *out, uint32_t out_stride)
+{
+	const size_t frame_size = cv->n_devices * ADS1298_FRAME_SIZE;
+
+	for (uint32_t f = 0; f < n_frames; f++, frames += frame_size) {
+		for (uint8_t d = 0; d < cv->n_devices; d++) {
+			const uint8_t *samples = frames + d * ADS1298_FRAME_SIZE + STATUS_BYTES;
+			const int32_t *mul = &cv->mul[d * ADS1298_DEVICE_CHANNELS];
+			int32_t *o = &out[d * ADS1298_DEVICE_CHANNELS * out_stride + f];
+			int32_t x[ADS1298_DEVICE_CHANNELS];
+
+			unpack4(samples, &x[0]);
+			unpack4(samples + 12, &x[4]);
+
+			for (unsigned int ch = 0; ch < ADS1298_DEVICE_CHANNELS; ch++) {
+				o[ch * out_stride] = scale(x[ch], mul[ch]);
+			}
+		}
+	}
+}
@@ -0,0 +1,137 @@
+#include <errno.h>
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+#include <zephyr/sys/util.h>
+
+#include <app/lib/exg_decim.h>
+
+/* Every stage halves the rate. A stage keeps the band that survives the whole chain,
+ * 0.38 * fs_out, and must stop whatever would alias into it, from its own output rate less
+ * that band. For the final stage this is a transition of 0.24 * fs_out, which 47 Blackman
+ * windowed taps give with ~70 dB stopband. The stages before it have at least
+ * 3.2 * fs_out to play with and 15 taps are plenty.
+ *
+ * With the cut-off at a quarter of the input rate every other tap away from the centre is
+ * zero, only the odd samples are ever computed and each costs about taps / 2 multiplies. */
+
+static void design_halfband(q31_t *taps, int n_taps)
+{
+	const int mid = n_taps / 2;
+	double coeffs[EXG_DECIM_FINAL_TAPS];
+	double sum = 0.0;
+
+	for (int i = 0; i < n_taps; i++) {
+		int k = i - mid;
+		double sinc = (k == 0) ? 0.5 : sin(M_PI * k / 2.0) / (M_PI * k);
+		double window = 0.42 - 0.5 * cos(2.0 * M_PI * i / (n_taps - 1)) +
+				0.08 * cos(4.0 * M_PI * i / (n_taps - 1));
+
+		coeffs[i] = sinc * window;
+		sum += coeffs[i];
+	}
+
+	/* Unity gain at DC */
+	for (int i = 0; i < n_taps; i++) {
+		taps[i] = (q31_t)llround(coeffs[i] / sum * (double)(1U << 31));
+	}
+}
+
+int exg_decim_init(struct exg_decim *dec, uint8_t n_channels, uint32_t fs_in_hz,
+		   uint32_t fs_out_hz)
+{
+	if (n_channels > EXG_MAX_CHANNELS || fs_out_hz == 0 || fs_in_hz % fs_out_hz != 0) {
+		return -EINVAL;
+	}
+
+	uint32_t ratio = fs_in_hz / fs_out_hz;
+
+	if (!IS_POWER_OF_TWO(ratio) || __builtin_ctz(ratio) > CONFIG_EXG_DECIM_MAX_STAGES) {
+		return -EINVAL;
+	}
+
+	dec->n_channels = n_channels;
+	dec->n_stages = __builtin_ctz(ratio);
+	design_halfband(dec->taps, EXG_DECIM_TAPS);
+	design_halfband(dec->final_taps, EXG_DECIM_FINAL_TAPS);
+	exg_decim_reset(dec);
+	return 0;
+}
+
+void exg_decim_reset(struct exg_decim *dec)
+{
+	memset(dec->pos, 0, sizeof(dec->pos));
+	memset(dec->odd, 0, sizeof(dec->odd));
+	memset(dec->hist, 0, sizeof(dec->hist));
+	memset(dec->final_hist, 0, sizeof(dec->final_hist));
+}
+
+/* Symmetric taps so the order of the history does not matter. Only the centre and the
+ * taps an odd distance from it are non-zero. */
+static inline q31_t halfband(const q31_t *taps, const q31_t *x, int n_taps)
+{
+	const int mid = n_taps / 2;
+	int64_t acc = (int64_t)taps[mid] * x[mid];
+
+	for (int i = (mid & 1) ? 0 : 1; i < n_taps; i += 2) {
+		acc += (int64_t)taps[i] * x[i];
+	}
+	return (q31_t)(acc >> 31);
+}
+
+/* Push x into one stage, returns true with the stage output in *x every second sample */
+static inline bool stage_push(q31_t *hist, uint8_t *pos, uint8_t *odd, const q31_t *taps,
+			      int n_taps, q31_t *x)
+{
+	hist[*pos] = *x;
+	hist[*pos + n_taps] = *x;
+	*pos = (*pos + 1 == n_taps) ? 0 : *pos + 1;
+
+	*odd ^= 1;
+	if (*odd) {
+		return false;
+	}
+	*x = halfband(taps, &hist[*pos], n_taps);
+	return true;
+}
+
+uint32_t exg_decim_process(struct exg_decim *dec, int32_t *rows, uint32_t n_frames,
+			   uint32_t out_stride)
+{
+	const uint8_t last = dec->n_stages - 1;
+	uint8_t pos[CONFIG_EXG_DECIM_MAX_STAGES];
+	uint8_t odd[CONFIG_EXG_DECIM_MAX_STAGES];
+	uint32_t n_out = 0;
+
+	if (dec->n_stages == 0) {
+		return n_frames;
+	}
+
+	for (uint8_t ch = 0; ch < dec->n_channels; ch++) {
+		int32_t *row = &rows[ch * out_stride];
+
+		/* Every channel starts from the phase the block started with */
+		memcpy(pos, dec->pos, sizeof(pos));
+		memcpy(odd, dec->odd, sizeof(odd));
+		n_out = 0;
+
+		for (uint32_t i = 0; i < n_frames; i++) {
+			q31_t x = row[i];
+			uint8_t s = 0;
+
+			while (s < last && stage_push(dec->hist[ch][s], &pos[s], &odd[s], dec->taps,
+						      EXG_DECIM_TAPS, &x)) {
+				s++;
+			}
+			if (s == last && stage_push(dec->final_hist[ch], &pos[s], &odd[s],
+						    dec->final_taps, EXG_DECIM_FINAL_TAPS, &x)) {
+				/* n_out <= i, so this never overwrites unread input */
+				row[n_out++] = x;
+			}
+		}
+	}
+
+	memcpy(dec->pos, pos, sizeof(pos));
+	memcpy(dec->odd, odd, sizeof(odd));
+	return n_out;
+}
@@ -0,0 +1,113 @@
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+#include <zephyr/sys/util.h>
+
+#include <app/lib/exg_filter.h>
+
+/* The 32x64 cascade keeps 64 bit state. A 0.5 Hz high-pass at 32 kSPS has its poles within
+ * 1e-4 of the unit circle and the plain q31 DF1 cascade loses too much there. */
+
+#define NOTCH_Q 30.0
+#define HIGHPASS_HZ 0.5f
+
+int exg_filter_init(struct exg_filter *flt, uint8_t n_channels, const q31_t *coeffs,
+		    uint8_t n_stages, uint8_t post_shift)
+{
+	if (n_channels > EXG_MAX_CHANNELS || n_stages == 0 ||
+	    n_stages > CONFIG_EXG_FILTER_MAX_STAGES) {
+		return -EINVAL;
+	}
+
+	flt->n_channels = n_channels;
+	memcpy(flt->coeffs, coeffs, n_stages * EXG_FILTER_STAGE_COEFFS * sizeof(q31_t));
+
+	for (uint8_t ch = 0; ch < n_channels; ch++) {
+		arm_biquad_cas_df1_32x64_init_q31(&flt->inst[ch], n_stages, flt->coeffs,
+						  flt->state[ch], post_shift);
+	}
+	exg_filter_reset(flt);
+	return 0;
+}
+
+int exg_filter_init_default(struct exg_filter *flt, uint8_t n_channels, uint32_t fs_hz,
+			    uint32_t mains_hz)
+{
+	q31_t coeffs[2 * EXG_FILTER_STAGE_COEFFS];
+	int ret;
+
+	if (mains_hz != 50 && mains_hz != 60) {
+		return -EINVAL;
+	}
+
+	ret = exg_filter_design_notch(&coeffs[0], fs_hz, mains_hz, NOTCH_Q);
+	if (ret == 0) {
+		ret = exg_filter_design_highpass(&coeffs[EXG_FILTER_STAGE_COEFFS], fs_hz, HIGHPASS_HZ);
+	}
+	if (ret == 0) {
+		ret = exg_filter_init(flt, n_channels, coeffs, 2, EXG_FILTER_POST_SHIFT);
+	}
+	return ret;
+}
+
+void exg_filter_reset(struct exg_filter *flt)
+{
+	memset(flt->state, 0, sizeof(flt->state));
+}
+
+void exg_filter_process(struct exg_filter *flt, int32_t *rows, uint32_t n_frames,
+			uint32_t out_stride)
+{
+	for (uint8_t ch = 0; ch < flt->n_channels; ch++) {
+		q31_t *row = &rows[ch * out_stride];
+
+		arm_biquad_cas_df1_32x64_q31(&flt->inst[ch], row, row, n_frames);
+	}
+}
+
+static q31_t to_q31(double c)
+{
+	double scaled = c * (double)(1U << 31) / (1 << EXG_FILTER_POST_SHIFT);
+
+	return (q31_t)CLAMP(llround(scaled), INT32_MIN, INT32_MAX);
+}
+
+/* Normalises by a0 and stores in CMSIS order, which adds rather than subtracts the feedback */
+static void store_stage(q31_t *stage, double b0, double b1, double b2, double a0, double a1,
+			double a2)
+{
+	stage[0] = to_q31(b0 / a0);
+	stage[1] = to_q31(b1 / a0);
+	stage[2] = to_q31(b2 / a0);
+	stage[3] = to_q31(-a1 / a0);
+	stage[4] = to_q31(-a2 / a0);
+}
+
+int exg_filter_design_notch(q31_t *stage, uint32_t fs_hz, float f0_hz, float q)
+{
+	if (fs_hz == 0 || f0_hz <= 0.0f || f0_hz >= fs_hz / 2.0f || q <= 0.0f) {
+		return -EINVAL;
+	}
+
+	double w0 = 2.0 * M_PI * f0_hz / fs_hz;
+	double alpha = sin(w0) / (2.0 * q);
+	double cos_w0 = cos(w0);
+
+	store_stage(stage, 1.0, -2.0 * cos_w0, 1.0, 1.0 + alpha, -2.0 * cos_w0, 1.0 - alpha);
+	return 0;
+}
+
+int exg_filter_design_highpass(q31_t *stage, uint32_t fs_hz, float fc_hz)
+{
+	if (fs_hz == 0 || fc_hz <= 0.0f || fc_hz >= fs_hz / 2.0f) {
+		return -EINVAL;
+	}
+
+	double w0 = 2.0 * M_PI * fc_hz / fs_hz;
+	double alpha = sin(w0) / (2.0 * M_SQRT1_2);
+	double cos_w0 = cos(w0);
+
+	store_stage(stage, (1.0 + cos_w0) / 2.0, -(1.0 + cos_w0), (1.0 + cos_w0) / 2.0,
+		    1.0 + alpha, -2.0 * cos_w0, 1.0 - alpha);
+	return 0;
+}
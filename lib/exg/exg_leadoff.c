@@ -0,0 +1,217 @@
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+
+#include <app/lib/exg_leadoff.h>
+
+/* 9.4.4.2 Status word: 1100, LOFF_STATP[7:0], LOFF_STATN[7:0], GPIO[7:4] */
+#define FRAME_BYTES 27
+#define STATP_SHIFT 12
+#define STATN_SHIFT 4
+#define INPUTS_PER_DEVICE 16
+
+BUILD_ASSERT(EXG_LEADOFF_MAX_INPUTS <= 32, "Inputs must fit a 32 bit mask");
+
+#define IMPEDANCE_WINDOW_HZ 5
+
+void exg_leadoff_init(struct exg_leadoff *lo, uint16_t debounce)
+{
+	memset(lo, 0, sizeof(*lo));
+	lo->debounce = MAX(debounce, 1);
+}
+
+uint32_t exg_leadoff_status(const uint8_t *frame, uint8_t n_devices)
+{
+	uint32_t mask = 0;
+
+	for (uint8_t d = 0; d < n_devices; d++) {
+		uint32_t status = sys_get_be24(&frame[d * FRAME_BYTES]);
+		uint32_t statp = (status >> STATP_SHIFT) & 0xFF;
+		uint32_t statn = (status >> STATN_SHIFT) & 0xFF;
+
+		mask |= (statp | (statn << 8)) << (d * INPUTS_PER_DEVICE);
+	}
+	return mask;
+}
+
+uint32_t exg_leadoff_update(struct exg_leadoff *lo, uint32_t raw, uint32_t index,
+			    struct exg_leadoff_event *events, uint32_t max_events)
+{
+	uint32_t changed = raw ^ lo->state;
+	uint32_t settled = lo->pending & ~changed;
+	uint32_t n_events = 0;
+
+	/* Glitches shorter than the debounce start from zero next time */
+	while (settled != 0) {
+		lo->count[__builtin_ctz(settled)] = 0;
+		settled &= settled - 1;
+	}
+	lo->pending = changed;
+
+	while (changed != 0) {
+		uint8_t input = __builtin_ctz(changed);
+
+		changed &= changed - 1;
+		if (++lo->count[input] < lo->debounce) {
+			continue;
+		}
+		/* No room, the input stays pending and changes with the next update that has */
+		if (n_events == max_events) {
+			lo->count[input] = lo->debounce - 1;
+			continue;
+		}
+
+		lo->count[input] = 0;
+		lo->pending &= ~BIT(input);
+		lo->state ^= BIT(input);
+		events[n_events++] = (struct exg_leadoff_event){
+			.index = index,
+			.input = input,
+			.off = (lo->state & BIT(input)) != 0,
+		};
+	}
+	return n_events;
+}
+
+uint32_t exg_leadoff_process(struct exg_leadoff *lo, const uint8_t *frames, uint32_t n_frames,
+			     uint8_t n_devices, struct exg_leadoff_event *events,
+			     uint32_t max_events)
+{
+	const uint32_t frame_bytes = FRAME_BYTES * n_devices;
+	uint32_t n_events = 0;
+
+	for (uint32_t f = 0; f < n_frames; f++) {
+		uint32_t raw = exg_leadoff_status(&frames[f * frame_bytes], n_devices);
+
+		if (raw == lo->state && lo->pending == 0) {
+			continue;
+		}
+		n_events += exg_leadoff_update(lo, raw, f, &events[n_events], max_events - n_events);
+	}
+	return n_events;
+}
+
+int exg_impedance_init(struct exg_impedance *imp, uint8_t n_channels, uint32_t fs_hz,
+		       uint32_t current_na)
+{
+	/* Whole periods of the fs / 4 excitation in every window */
+	uint32_t window = (fs_hz / IMPEDANCE_WINDOW_HZ) & ~3U;
+
+	/* And of 50 and 60 Hz mains, which both fit 100 ms exactly. Every ADS1298 rate is a
+	 * multiple of 10 Hz, the window is then the fewest 100 ms steps that also hold whole
+	 * excitation periods, 400 ms at 250 SPS and 200 ms at the faster rates. */
+	if (window != 0 && fs_hz % 10 == 0) {
+		uint32_t step = fs_hz / 10;
+
+		while (step % 4 != 0) {
+			step += fs_hz / 10;
+		}
+		window = ROUND_UP(fs_hz / IMPEDANCE_WINDOW_HZ, step);
+	}
+
+	if (n_channels > EXG_MAX_CHANNELS || window == 0 || window > UINT16_MAX ||
+	    current_na == 0) {
+		return -EINVAL;
+	}
+
+	memset(imp, 0, sizeof(*imp));
+	imp->n_channels = n_channels;
+	imp->window = window;
+	imp->current_na = current_na;
+	return 0;
+}
+
+/* In-phase and quadrature sums at fs / 4, where the reference is 1, 0, -1, 0 and
+ * 0, 1, 0, -1, so every sample is a single add or subtract */
+static void demodulate(const int32_t *x, uint32_t n, uint32_t phase, int64_t *i, int64_t *q)
+{
+	int64_t si = 0;
+	int64_t sq = 0;
+	uint32_t k = 0;
+
+	for (; k < n && ((phase + k) & 3) != 0; k++) {
+		switch ((phase + k) & 3) {
+		case 1:
+			sq += x[k];
+			break;
+		case 2:
+			si -= x[k];
+			break;
+		default:
+			sq -= x[k];
+			break;
+		}
+	}
+	for (; k + 4 <= n; k += 4) {
+		si += (int64_t)x[k] - x[k + 2];
+		sq += (int64_t)x[k + 1] - x[k + 3];
+	}
+	for (uint32_t p = 0; k < n; k++, p++) {
+		if (p == 0) {
+			si += x[k];
+		} else if (p == 1) {
+			sq += x[k];
+		} else {
+			si -= x[k];
+		}
+	}
+
+	*i += si;
+	*q += sq;
+}
+
+static void finish_window(struct exg_impedance *imp)
+{
+	/* Volts per q31 count and amps per nA */
+	const double scale = 1e9 / ((double)BIT(31 - EXG_CONVERT_Q31_SHIFT) * imp->current_na);
+
+	for (uint8_t ch = 0; ch < imp->n_channels; ch++) {
+		/* Each sum is window / 2 times the amplitude projected onto its axis */
+		double ai = 2.0 * imp->i[ch] / imp->window;
+		double aq = 2.0 * imp->q[ch] / imp->window;
+		double ohms = sqrt(ai * ai + aq * aq) * scale;
+
+		imp->ohms[ch] = (uint32_t)MIN(ohms, (double)UINT32_MAX);
+		imp->i[ch] = 0;
+		imp->q[ch] = 0;
+	}
+}
+
+bool exg_impedance_process(struct exg_impedance *imp, const int32_t *rows, uint32_t n,
+			   uint32_t stride)
+{
+	bool updated = false;
+	uint32_t k = 0;
+
+	while (k < n) {
+		uint32_t run = MIN(n - k, (uint32_t)(imp->window - imp->pos));
+
+		for (uint8_t ch = 0; ch < imp->n_channels; ch++) {
+			demodulate(&rows[ch * stride + k], run, imp->pos & 3, &imp->i[ch],
+				   &imp->q[ch]);
+		}
+		imp->pos += run;
+		k += run;
+
+		if (imp->pos == imp->window) {
+			finish_window(imp);
+			imp->pos = 0;
+			updated = true;
+		}
+	}
+	return updated;
+}
+
+uint32_t exg_impedance_mask(const struct exg_impedance *imp, uint32_t max_ohms)
+{
+	uint32_t mask = 0;
+
+	for (uint8_t ch = 0; ch < imp->n_channels; ch++) {
+		if (imp->ohms[ch] > max_ohms) {
+			mask |= BIT(EXG_LEADOFF_P(ch)) | BIT(EXG_LEADOFF_N(ch));
+		}
+	}
+	return mask;
+}
@@ -0,0 +1,28 @@
+#include <zephyr/sys/util.h>
+
+#include <app/lib/exg_leads.h>
+
+/* Compiles to SSAT on Cortex-M */
+static inline int32_t sat32(int64_t x)
+{
+	return (int32_t)CLAMP(x, INT32_MIN, INT32_MAX);
+}
+
+void exg_leads_derive(const int32_t *lead_i, const int32_t *lead_ii, int32_t *out,
+		      uint32_t out_stride, uint32_t n)
+{
+	int32_t *restrict iii = &out[EXG_LEAD_III * out_stride];
+	int32_t *restrict avr = &out[EXG_LEAD_AVR * out_stride];
+	int32_t *restrict avl = &out[EXG_LEAD_AVL * out_stride];
+	int32_t *restrict avf = &out[EXG_LEAD_AVF * out_stride];
+
+	for (uint32_t k = 0; k < n; k++) {
+		int64_t a = lead_i[k];
+		int64_t b = lead_ii[k];
+
+		iii[k] = sat32(b - a);
+		avr[k] = sat32(-(a + b) >> 1);
+		avl[k] = sat32((2 * a - b) >> 1);
+		avf[k] = sat32((2 * b - a) >> 1);
+	}
+}
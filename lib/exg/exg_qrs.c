@@ -0,0 +1,268 @@
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr/sys/util.h>
+
+#include <app/lib/exg_qrs.h>
+
+/* Pan J, Tompkins WJ. A real-time QRS detection algorithm. IEEE Trans Biomed Eng 1985.
+ *
+ * The original integer filters only suit 200 SPS, here the 5-15 Hz band-pass is a pair of
+ * Butterworth biquads designed for the actual rate. Integrated peaks are found with 50%
+ * hysteresis rather than on every local maximum, which keeps ripple on the integrator
+ * output from being taken as separate peaks. The R-peak is the largest band-passed sample
+ * since the previous integrated peak, moved back by the band-pass delay. */
+
+#define BIQUAD_FRAC_BITS 28
+#define LEARN_MS 2000
+#define REFRACTORY_MS 200
+#define T_WAVE_MS 360
+#define WINDOW_MS 150
+/* Leaves headroom for the sum of a 150 sample window of squares, see exg_qrs_process() */
+#define SLOPE_SHIFT 7
+#define LEARN_SUM_SHIFT 11
+
+BUILD_ASSERT((EXG_QRS_MAX_FS_HZ * LEARN_MS / 1000) < BIT(LEARN_SUM_SHIFT));
+
+static void biquad_set(struct exg_qrs_biquad *bq, double b0, double b1, double b2, double a0,
+		       double a1, double a2)
+{
+	const double s = BIT(BIQUAD_FRAC_BITS);
+
+	memset(bq, 0, sizeof(*bq));
+	bq->b0 = (int32_t)lround(b0 / a0 * s);
+	bq->b1 = (int32_t)lround(b1 / a0 * s);
+	bq->b2 = (int32_t)lround(b2 / a0 * s);
+	bq->a1 = (int32_t)lround(a1 / a0 * s);
+	bq->a2 = (int32_t)lround(a2 / a0 * s);
+}
+
+/* abs() is undefined at INT32_MIN, which the biquad clamp can return */
+static inline int32_t abs_sat(int32_t x)
+{
+	return (x == INT32_MIN) ? INT32_MAX : abs(x);
+}
+
+static inline int32_t biquad(struct exg_qrs_biquad *bq, int32_t x)
+{
+	int64_t acc = (int64_t)bq->b0 * x + (int64_t)bq->b1 * bq->x1 + (int64_t)bq->b2 * bq->x2 -
+		      (int64_t)bq->a1 * bq->y1 - (int64_t)bq->a2 * bq->y2;
+	int32_t y = (int32_t)CLAMP(acc >> BIQUAD_FRAC_BITS, INT32_MIN, INT32_MAX);
+
+	bq->x2 = bq->x1;
+	bq->x1 = x;
+	bq->y2 = bq->y1;
+	bq->y1 = y;
+	return y;
+}
+
+/* A narrow R-wave comes out of the band-pass where its impulse response peaks, earlier than
+ * the group delay at the centre frequency would suggest */
+static uint32_t impulse_peak(const struct exg_qrs *qrs)
+{
+	struct exg_qrs_biquad lp = qrs->lp;
+	struct exg_qrs_biquad hp = qrs->hp;
+	uint32_t peak_n = 0;
+	int32_t peak = 0;
+
+	for (uint32_t i = 0; i < qrs->fs_hz / 5; i++) {
+		int32_t y = abs_sat(biquad(&hp, biquad(&lp, i == 0 ? BIT(24) : 0)));
+
+		if (y > peak) {
+			peak = y;
+			peak_n = i;
+		}
+	}
+	return peak_n;
+}
+
+int exg_qrs_init(struct exg_qrs *qrs, uint32_t fs_hz)
+{
+	if (fs_hz < 100 || fs_hz > EXG_QRS_MAX_FS_HZ) {
+		return -EINVAL;
+	}
+
+	memset(qrs, 0, sizeof(*qrs));
+	qrs->fs_hz = fs_hz;
+	qrs->window = fs_hz * WINDOW_MS / 1000;
+	qrs->learn_len = fs_hz * LEARN_MS / 1000;
+	qrs->refractory = fs_hz * REFRACTORY_MS / 1000;
+	qrs->t_wave_window = fs_hz * T_WAVE_MS / 1000;
+
+	double w = 2.0 * M_PI * 15.0 / fs_hz;
+	double alpha = sin(w) / (2.0 * M_SQRT1_2);
+	double c = cos(w);
+
+	biquad_set(&qrs->lp, (1.0 - c) / 2.0, 1.0 - c, (1.0 - c) / 2.0, 1.0 + alpha, -2.0 * c,
+		   1.0 - alpha);
+
+	w = 2.0 * M_PI * 5.0 / fs_hz;
+	alpha = sin(w) / (2.0 * M_SQRT1_2);
+	c = cos(w);
+	biquad_set(&qrs->hp, (1.0 + c) / 2.0, -(1.0 + c), (1.0 + c) / 2.0, 1.0 + alpha, -2.0 * c,
+		   1.0 - alpha);
+
+	qrs->bp_delay = impulse_peak(qrs);
+	return 0;
+}
+
+uint32_t exg_qrs_heart_rate_bpm(const struct exg_qrs *qrs)
+{
+	if (qrs->rr_count == 0 || qrs->rr_sum == 0) {
+		return 0;
+	}
+	return (60 * qrs->fs_hz * qrs->rr_count) / qrs->rr_sum;
+}
+
+static inline void update_thr(struct exg_qrs *qrs)
+{
+	qrs->thr1 = qrs->npki + (qrs->spki - qrs->npki) / 4;
+}
+
+static bool take_beat(struct exg_qrs *qrs, uint64_t peak_n, uint64_t r, int32_t slope,
+		      int64_t timestamp_ns, uint64_t block_n, struct exg_qrs_beat *beat)
+{
+	const int64_t period_ns = 1000000000LL / qrs->fs_hz;
+	uint32_t rr = 0;
+
+	if (qrs->have_beat) {
+		rr = (uint32_t)(r - qrs->last_r);
+		qrs->rr_sum += rr - qrs->rr[qrs->rr_pos];
+		qrs->rr[qrs->rr_pos] = rr;
+		qrs->rr_pos = (qrs->rr_pos + 1) % ARRAY_SIZE(qrs->rr);
+		qrs->rr_count = MIN(qrs->rr_count + 1, ARRAY_SIZE(qrs->rr));
+	}
+
+	qrs->have_beat = true;
+	qrs->last_peak_n = peak_n;
+	qrs->last_r = r;
+	qrs->last_slope = slope;
+	qrs->sb_valid = false;
+
+	if (beat != NULL) {
+		beat->timestamp_ns = timestamp_ns + ((int64_t)r - (int64_t)block_n) * period_ns;
+		beat->rr_ms = (uint32_t)(((uint64_t)rr * 1000) / qrs->fs_hz);
+	}
+	return beat != NULL;
+}
+
+/* A peak of the integrated signal, returns true if it was a beat */
+static bool classify_peak(struct exg_qrs *qrs, int64_t timestamp_ns, uint64_t block_n,
+			  struct exg_qrs_beat *beat)
+{
+	const int64_t peak = qrs->seg_peak;
+	const uint64_t peak_n = qrs->seg_peak_n;
+	const uint64_t r = qrs->seg_r > qrs->bp_delay ? qrs->seg_r - qrs->bp_delay : 0;
+	const int32_t slope = qrs->seg_slope;
+	const uint64_t since = peak_n - qrs->last_peak_n;
+
+	if (qrs->have_beat && since < qrs->refractory) {
+		return false;
+	}
+
+	if (peak > qrs->thr1) {
+		/* A T-wave soon after the beat has a much gentler slope */
+		if (!qrs->have_beat || since >= qrs->t_wave_window || slope >= qrs->last_slope / 2) {
+			qrs->spki = (peak + 7 * qrs->spki) / 8;
+			update_thr(qrs);
+			return take_beat(qrs, peak_n, r, slope, timestamp_ns, block_n, beat);
+		}
+	}
+
+	qrs->npki = (peak + 7 * qrs->npki) / 8;
+	update_thr(qrs);
+
+	if (peak > qrs->thr1 / 2 && (!qrs->sb_valid || peak > qrs->sb_peak)) {
+		qrs->sb_valid = true;
+		qrs->sb_peak = peak;
+		qrs->sb_peak_n = peak_n;
+		qrs->sb_r = r;
+		qrs->sb_slope = slope;
+	}
+	return false;
+}
+
+/* Nothing for 1.66 RR intervals, take the best peak over the lower threshold instead */
+static bool search_back(struct exg_qrs *qrs, int64_t timestamp_ns, uint64_t block_n,
+			struct exg_qrs_beat *beat)
+{
+	if (!qrs->sb_valid || qrs->rr_count == 0) {
+		return false;
+	}
+
+	uint32_t rr_avg = qrs->rr_sum / qrs->rr_count;
+
+	if (qrs->n - qrs->last_peak_n < rr_avg + (rr_avg * 2) / 3) {
+		return false;
+	}
+
+	qrs->spki = (qrs->sb_peak + 3 * qrs->spki) / 4;
+	update_thr(qrs);
+	return take_beat(qrs, qrs->sb_peak_n, qrs->sb_r, qrs->sb_slope, timestamp_ns, block_n,
+			 beat);
+}
+
+uint32_t exg_qrs_process(struct exg_qrs *qrs, const int32_t *samples, uint32_t n,
+			 int64_t timestamp_ns, struct exg_qrs_beat *beats, uint32_t max_beats)
+{
+	const uint64_t block_n = qrs->n;
+	uint32_t n_beats = 0;
+
+	for (uint32_t i = 0; i < n; i++, qrs->n++) {
+		int32_t bp = biquad(&qrs->hp, biquad(&qrs->lp, samples[i]));
+		int32_t *h = qrs->bp_hist;
+
+		/* Five point derivative, (2x[n] + x[n-1] - x[n-3] - 2x[n-4]) / 8, scaled down so
+		 * that 150 squares of even a full scale slope fit in 63 bits */
+		int32_t d = (int32_t)((2 * (int64_t)bp + h[0] - h[2] - 2 * (int64_t)h[3]) >> SLOPE_SHIFT);
+
+		h[3] = h[2];
+		h[2] = h[1];
+		h[1] = h[0];
+		h[0] = bp;
+
+		int64_t sq = (int64_t)d * d;
+
+		qrs->mwi += sq - qrs->sq[qrs->sq_pos];
+		qrs->sq[qrs->sq_pos] = sq;
+		qrs->sq_pos = (qrs->sq_pos + 1 == qrs->window) ? 0 : qrs->sq_pos + 1;
+
+		if (abs_sat(bp) > qrs->seg_bp_max) {
+			qrs->seg_bp_max = abs_sat(bp);
+			qrs->seg_r = qrs->n;
+		}
+		qrs->seg_slope = MAX(qrs->seg_slope, abs_sat(d));
+		if (qrs->mwi > qrs->seg_peak) {
+			qrs->seg_peak = qrs->mwi;
+			qrs->seg_peak_n = qrs->n;
+		}
+
+		if (qrs->n < qrs->learn_len) {
+			qrs->learn_max = MAX(qrs->learn_max, qrs->mwi);
+			qrs->learn_sum += qrs->mwi >> LEARN_SUM_SHIFT;
+			if (qrs->n + 1 == qrs->learn_len) {
+				qrs->spki = qrs->learn_max / 3;
+				qrs->npki = ((qrs->learn_sum << LEARN_SUM_SHIFT) / qrs->learn_len) / 2;
+				update_thr(qrs);
+			}
+			continue;
+		}
+
+		struct exg_qrs_beat *beat = n_beats < max_beats ? &beats[n_beats] : NULL;
+
+		/* The integrated peak is over once the signal has halved */
+		if (qrs->seg_peak > 0 && qrs->mwi < qrs->seg_peak / 2) {
+			if (classify_peak(qrs, timestamp_ns, block_n, beat)) {
+				n_beats++;
+			}
+			qrs->seg_peak = 0;
+			qrs->seg_bp_max = 0;
+			qrs->seg_slope = 0;
+		} else if (search_back(qrs, timestamp_ns, block_n, beat)) {
+			n_beats++;
+		}
+	}
+
+	return n_beats;
+}
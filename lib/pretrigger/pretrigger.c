@@ -0,0 +1,116 @@
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/spinlock.h>
+
+#include <app/lib/pretrigger.h>
+
+static sys_slist_t rings = SYS_SLIST_STATIC_INIT(&rings);
+static struct k_spinlock lock;
+
+void pretrigger_register(struct pretrigger_ring *ring)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	ring->end = 0;
+	ring->next_end = 0;
+	sys_slist_append(&rings, &ring->node);
+	k_spin_unlock(&lock, key);
+}
+
+void pretrigger_unregister(struct pretrigger_ring *ring)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	sys_slist_find_and_remove(&rings, &ring->node);
+	ring->end = 0;
+	ring->next_end = 0;
+	k_spin_unlock(&lock, key);
+}
+
+void pretrigger_fire(uint64_t timestamp, uint64_t pre, uint64_t post)
+{
+	struct pretrigger_ring *ring;
+	uint64_t start = timestamp > pre ? timestamp - pre : 0;
+	uint64_t end = timestamp + post;
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&rings, ring, node) {
+		/* Overlapping windows merge, records already sent are not sent again */
+		if (ring->end == 0) {
+			ring->start = start;
+			ring->end = end;
+		} else if (start <= ring->end && ring->next_end == 0) {
+			ring->start = MIN(ring->start, start);
+			ring->end = MAX(ring->end, end);
+		} else if (ring->next_end == 0) {
+			/* Later, the open window may still have records to come */
+			ring->next_start = start;
+			ring->next_end = end;
+		} else {
+			ring->next_start = MIN(ring->next_start, start);
+			ring->next_end = MAX(ring->next_end, end);
+		}
+	}
+	k_spin_unlock(&lock, key);
+}
+
+void pretrigger_write(struct pretrigger_ring *ring, const void *record, uint64_t timestamp)
+{
+	const uint32_t mask = ring->n_records - 1;
+	uint32_t oldest;
+	uint32_t i;
+	uint64_t start;
+	uint64_t end;
+	k_spinlock_key_t key;
+
+	memcpy(&ring->records[(ring->head & mask) * ring->record_size], record, ring->record_size);
+	ring->timestamps[ring->head & mask] = timestamp;
+	ring->head++;
+
+	key = k_spin_lock(&lock);
+	start = ring->start;
+	end = ring->end;
+	k_spin_unlock(&lock, key);
+
+	/* Nothing to store in the steady state */
+	while (end != 0) {
+		/* Anything older than the ring was overwritten unseen, differences keep this
+		 * right when head wraps */
+		if (ring->head - ring->sent > ring->n_records) {
+			oldest = ring->head - ring->n_records;
+			if (ring->timestamps[oldest & mask] > start) {
+				ring->short_windows++;
+			}
+			ring->sent = oldest;
+		}
+
+		for (i = ring->sent; i != ring->head; i++) {
+			uint64_t ts = ring->timestamps[i & mask];
+
+			if (ts > end) {
+				break;
+			}
+			if (ts >= start) {
+				ring->sink(&ring->records[(i & mask) * ring->record_size], ts,
+					   ring->user_data);
+			}
+		}
+		ring->sent = i;
+
+		if (timestamp <= end) {
+			return;
+		}
+
+		/* Past the end, close the window unless a trigger has moved it meanwhile, and
+		 * open any window waiting behind it on the records already written */
+		key = k_spin_lock(&lock);
+		if (ring->end == end) {
+			ring->start = ring->next_start;
+			ring->end = ring->next_end;
+			ring->next_end = 0;
+		}
+		start = ring->start;
+		end = ring->end;
+		k_spin_unlock(&lock, key);
+	}
+}
@@ -0,0 +1,286 @@
+/*
+ * @file test ADS1298 driver against the SPI emulator
+ *
+ * Runs the real driver, register shadow and RDATAC stream included, against
+ * the emulated part on native_sim. The benchmark streams at each data rate
+ * for a second and reports sustained frames/s, frames dropped by the driver,
+ * frames missing from the emulator's sequence numbers and the latency from
+ * nDRDY to the consumer.
+ *
+ * Without a CTIMER the timebase is the kernel cycle counter, the same clock
+ * the emulator records its nDRDY edges with.
+ */
+
+#include <zephyr/ztest.h>
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/emul.h>
+#include <zephyr/drivers/sensor.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+
+#include <app/drivers/ads1298.h>
+#include <app/drivers/emul_ads1298.h>
+#include <app/drivers/timebase.h>
+
+#define ADS1298_NODE DT_NODELABEL(ads1298)
+#define SEQ_CHANNEL 7
+#define BATCH 16
+
+/* Register addresses from the datasheet, the driver keeps its own copy private */
+#define REG_CONFIG1 0x01
+#define REG_CONFIG2 0x02
+#define REG_CONFIG3 0x03
+#define REG_LOFF 0x04
+#define REG_CH1SET 0x05
+#define REG_LOFF_SENSP 0x0F
+#define REG_LOFF_SENSN 0x10
+#define REG_CONFIG4 0x17
+#define REG_WCT1 0x18
+#define REG_WCT2 0x19
+
+static const struct device *const dev = DEVICE_DT_GET(ADS1298_NODE);
+static const struct emul *const emul = EMUL_DT_GET(ADS1298_NODE);
+
+static int32_t sample(const uint8_t *frame, unsigned int ch)
+{
+    return sign_extend(sys_get_be24(&frame[ads1298_sample_offset(ch)]), 23);
+}
+
+static int set_attr(enum sensor_attribute attr, int32_t value)
+{
+    struct sensor_value val = { .val1 = value };
+
+    return sensor_attr_set(dev, SENSOR_CHAN_ALL, attr, &val);
+}
+
+static void before(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    zassert_true(device_is_ready(dev), "ADS1298 not ready");
+    zassert_ok(set_attr((enum sensor_attribute)SENSOR_ATTR_ADS1298_MUX, ADS1298_MUX_NORMAL),
+               "Mux");
+}
+
+static void after(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    ads1298_stream_stop(dev);
+}
+
+ZTEST(exg_emul, test_init_config)
+{
+    /* 500 SPS high resolution, internal 4 V reference, gain 6 */
+    zassert_equal(ads1298_emul_reg_get(emul, REG_CONFIG1), 0x86, "CONFIG1");
+    zassert_equal(ads1298_emul_reg_get(emul, REG_CONFIG3), 0xC0, "CONFIG3");
+    zassert_equal(ads1298_emul_reg_get(emul, REG_CH1SET), 0x00, "CH1SET");
+}
+
+ZTEST(exg_emul, test_attr_reaches_device)
+{
+    zassert_ok(set_attr(SENSOR_ATTR_SAMPLING_FREQUENCY, 1000), "Rate");
+    zassert_equal(ads1298_emul_reg_get(emul, REG_CONFIG1), 0x85, "CONFIG1 for 1 kSPS");
+
+    zassert_ok(set_attr((enum sensor_attribute)SENSOR_ATTR_ADS1298_GAIN, 12), "Gain");
+    zassert_equal(ads1298_emul_reg_get(emul, REG_CH1SET), 0x60, "CH1SET for gain 12");
+
+    zassert_ok(set_attr((enum sensor_attribute)SENSOR_ATTR_ADS1298_GAIN, 6), "Gain");
+    zassert_ok(set_attr(SENSOR_ATTR_SAMPLING_FREQUENCY, 500), "Rate");
+}
+
+ZTEST(exg_emul, test_lead_off_attr)
+{
+    struct sensor_value val = { .val1 = ADS1298_LEAD_OFF_DC };
+
+    zassert_ok(sensor_attr_set(dev, (enum sensor_channel)(SENSOR_CHAN_ADS1298_CH1 + 2),
+                               (enum sensor_attribute)SENSOR_ATTR_ADS1298_LEAD_OFF, &val),
+               "Lead-off on channel 3");
+    zassert_equal(ads1298_emul_reg_get(emul, REG_LOFF_SENSP), BIT(2), "LOFF_SENSP");
+    zassert_equal(ads1298_emul_reg_get(emul, REG_LOFF_SENSN), BIT(2), "LOFF_SENSN");
+    zassert_equal(ads1298_emul_reg_get(emul, REG_CONFIG4) & BIT(1), BIT(1), "Comparators off");
+
+    zassert_ok(set_attr((enum sensor_attribute)SENSOR_ATTR_ADS1298_LEAD_OFF_CURRENT, 18),
+               "Current");
+    zassert_equal(ads1298_emul_reg_get(emul, REG_LOFF) & GENMASK(3, 2), 0x08, "ILEAD_OFF");
+
+    /* AC excitation leaves the comparators without a use */
+    zassert_ok(set_attr((enum sensor_attribute)SENSOR_ATTR_ADS1298_LEAD_OFF, ADS1298_LEAD_OFF_AC),
+               "AC lead-off");
+    zassert_equal(ads1298_emul_reg_get(emul, REG_LOFF) & GENMASK(1, 0), 0x01, "FLEAD_OFF");
+    zassert_equal(ads1298_emul_reg_get(emul, REG_LOFF_SENSP), 0xFF, "LOFF_SENSP");
+    zassert_equal(ads1298_emul_reg_get(emul, REG_CONFIG4) & BIT(1), 0, "Comparators on");
+
+    zassert_ok(set_attr((enum sensor_attribute)SENSOR_ATTR_ADS1298_LEAD_OFF, ADS1298_LEAD_OFF_NONE),
+               "Lead-off off");
+    zassert_ok(set_attr((enum sensor_attribute)SENSOR_ATTR_ADS1298_LEAD_OFF_CURRENT, 6), "Current");
+    zassert_equal(ads1298_emul_reg_get(emul, REG_LOFF_SENSP), 0, "LOFF_SENSP");
+    zassert_equal(ads1298_emul_reg_get(emul, REG_LOFF_SENSN), 0, "LOFF_SENSN");
+    zassert_equal(ads1298_emul_reg_get(emul, REG_LOFF) & GENMASK(3, 2), 0, "ILEAD_OFF");
+}
+
+ZTEST(exg_emul, test_test_mux_attr)
+{
+    struct sensor_value val = { .val1 = ADS1298_MUX_TEST };
+    const enum sensor_channel ch3 = (enum sensor_channel)(SENSOR_CHAN_ADS1298_CH1 + 2);
+    const enum sensor_channel ch5 = (enum sensor_channel)(SENSOR_CHAN_ADS1298_CH1 + 4);
+    const enum sensor_attribute mux = (enum sensor_attribute)SENSOR_ATTR_ADS1298_MUX;
+
+    zassert_ok(sensor_attr_set(dev, ch3, mux, &val), "Test signal on channel 3");
+    zassert_ok(sensor_attr_set(dev, ch5, mux, &val), "Test signal on channel 5");
+    zassert_equal(ads1298_emul_reg_get(emul, REG_CH1SET + 2) & GENMASK(2, 0), ADS1298_MUX_TEST,
+                  "CH3SET");
+    zassert_equal(ads1298_emul_reg_get(emul, REG_CONFIG2) & BIT(4), BIT(4), "INT_TEST");
+
+    /* The test signal stays on while any channel still uses it */
+    val.val1 = ADS1298_MUX_NORMAL;
+    zassert_ok(sensor_attr_set(dev, ch3, mux, &val), "Channel 3 back");
+    zassert_equal(ads1298_emul_reg_get(emul, REG_CONFIG2) & BIT(4), BIT(4), "INT_TEST");
+    zassert_ok(sensor_attr_set(dev, ch5, mux, &val), "Channel 5 back");
+    zassert_equal(ads1298_emul_reg_get(emul, REG_CONFIG2) & BIT(4), 0, "INT_TEST left on");
+}
+
+ZTEST(exg_emul, test_wct_attr)
+{
+    zassert_ok(set_attr((enum sensor_attribute)SENSOR_ATTR_ADS1298_WCT, 1), "WCT on");
+    /* The 12-lead settings from the datasheet, Table 31 and 32 */
+    zassert_equal(ads1298_emul_reg_get(emul, REG_WCT1), 0x0A, "WCT1");
+    zassert_equal(ads1298_emul_reg_get(emul, REG_WCT2), 0xE3, "WCT2");
+
+    zassert_ok(set_attr((enum sensor_attribute)SENSOR_ATTR_ADS1298_WCT, 0), "WCT off");
+    zassert_equal(ads1298_emul_reg_get(emul, REG_WCT1), 0x00, "WCT1");
+    zassert_equal(ads1298_emul_reg_get(emul, REG_WCT2), 0x00, "WCT2");
+}
+
+ZTEST(exg_emul, test_reg_check_repairs)
+{
+    ads1298_emul_reg_set(emul, REG_CONFIG3, 0x40);
+    k_msleep(2 * CONFIG_ADS1298_REG_CHECK_INTERVAL_MS + 100);
+    zassert_equal(ads1298_emul_reg_get(emul, REG_CONFIG3), 0xC0, "CONFIG3 not rewritten");
+}
+
+ZTEST(exg_emul, test_ecg_scaled)
+{
+    uint8_t gain[ADS1298_DEVICE_CHANNELS];
+    uint32_t vref_uv;
+    int64_t peak_uv = 0;
+    const uint8_t *f;
+
+    ads1298_get_scaling(dev, gain, &vref_uv);
+    zassert_ok(ads1298_stream_start(dev), "Stream start failed");
+
+    /* A whole beat at 500 SPS */
+    for (uint32_t got = 0; got < 600;) {
+        zassert_true(ads1298_stream_wait(dev, BATCH, K_MSEC(100)) > 0, "No frames");
+        uint32_t n = ads1298_stream_claim(dev, &f, UINT32_MAX);
+
+        for (uint32_t i = 0; i < n; i++) {
+            const uint8_t *frame = &f[i * ads1298_frame_size(dev)];
+            int64_t uv = ((int64_t)sample(frame, 0) * vref_uv) / ((int64_t)gain[0] << 23);
+
+            peak_uv = MAX(peak_uv, uv);
+        }
+        ads1298_stream_release(dev, n);
+        got += n;
+    }
+
+    /* The synthetic R-wave is 1 mV */
+    zassert_within(peak_uv, 1000, 20, "R-wave is %d uV", (int)peak_uv);
+}
+
+ZTEST(exg_emul, test_frame_timestamps)
+{
+    const uint32_t period_ns = NSEC_PER_SEC / 500;
+    uint64_t prev_ns = 0;
+    uint32_t prev_frames = 0;
+    const uint8_t *f;
+
+    zassert_ok(ads1298_stream_start(dev), "Stream start failed");
+
+    for (int batch = 0; batch < 20; batch++) {
+        zassert_true(ads1298_stream_wait(dev, BATCH, K_MSEC(100)) > 0, "No frames");
+
+        uint64_t ts = ads1298_stream_timestamp(dev);
+        uint64_t ts_ns = timebase_ticks_to_ns(ts);
+        uint32_t n = ads1298_stream_claim(dev, &f, UINT32_MAX);
+        uint32_t seq = sample(f, SEQ_CHANNEL) & GENMASK(23, 0);
+
+        /* Stamped at the edge, not when the consumer got round to it */
+        zassert_equal((uint32_t)ts, ads1298_emul_drdy_cycles(emul, seq),
+                      "Batch %d not stamped at nDRDY", batch);
+        if (batch > 0) {
+            zassert_within(ts_ns - prev_ns, (uint64_t)prev_frames * period_ns, 10000,
+                           "Batch %d is %u ns after the last", batch, (uint32_t)(ts_ns - prev_ns));
+        }
+        prev_ns = ts_ns;
+        prev_frames = n;
+        ads1298_stream_release(dev, n);
+    }
+}
+
+ZTEST(exg_emul, test_benchmark)
+{
+    const uint32_t rates[] = {500, 1000, 2000, 4000, 8000, 16000};
+    const uint8_t *f;
+
+    TC_PRINT("   SPS  frames/s  dropped  lost  unread  latency mean/max us\n");
+
+    for (int r = 0; r < ARRAY_SIZE(rates); r++) {
+        struct ads1298_emul_stats before_stats, after_stats;
+        uint64_t latency_sum = 0;
+        uint32_t latency_max = 0;
+        uint32_t frames = 0;
+        uint32_t lost = 0;
+        uint32_t last_seq = 0;
+
+        zassert_ok(set_attr(SENSOR_ATTR_SAMPLING_FREQUENCY, rates[r]), "Rate %u", rates[r]);
+        ads1298_emul_get_stats(emul, &before_stats);
+        zassert_ok(ads1298_stream_start(dev), "Stream start failed");
+
+        int64_t start = k_uptime_get();
+        while (k_uptime_get() - start < MSEC_PER_SEC) {
+            if (ads1298_stream_wait(dev, BATCH, K_MSEC(100)) < 0) {
+                continue;
+            }
+
+            uint32_t n;
+            while ((n = ads1298_stream_claim(dev, &f, UINT32_MAX)) > 0) {
+                for (uint32_t i = 0; i < n; i++) {
+                    uint32_t seq = sample(&f[i * ads1298_frame_size(dev)], SEQ_CHANNEL) &
+                                   GENMASK(23, 0);
+                    uint32_t latency = k_cyc_to_us_floor32(k_cycle_get_32() -
+                                                           ads1298_emul_drdy_cycles(emul, seq));
+
+                    if (frames > 0) {
+                        lost += (seq - last_seq - 1) & GENMASK(23, 0);
+                    }
+                    last_seq = seq;
+                    latency_sum += latency;
+                    latency_max = MAX(latency_max, latency);
+                    frames++;
+                }
+                ads1298_stream_release(dev, n);
+            }
+        }
+        int64_t elapsed_ms = k_uptime_get() - start;
+        uint32_t dropped = ads1298_stream_dropped(dev);
+
+        zassert_ok(ads1298_stream_stop(dev), "Stream stop failed");
+        ads1298_emul_get_stats(emul, &after_stats);
+
+        uint32_t fps = (uint32_t)((frames * (uint64_t)MSEC_PER_SEC) / elapsed_ms);
+
+        TC_PRINT("%6u  %8u  %7u  %4u  %6u  %u/%u\n", rates[r], fps, dropped, lost,
+                 after_stats.unread - before_stats.unread,
+                 frames ? (uint32_t)(latency_sum / frames) : 0, latency_max);
+
+        zassert_true(frames > 0, "Nothing streamed at %u SPS", rates[r]);
+        zassert_equal(dropped, 0, "Driver dropped frames at %u SPS", rates[r]);
+        zassert_equal(lost, 0, "Frames missing at %u SPS", rates[r]);
+        /* Tick rounding of the emulated nDRDY period stays well inside this */
+        zassert_within(fps, rates[r], rates[r] / 20, "%u frames/s at %u SPS", fps, rates[r]);
+    }
+
+    zassert_ok(set_attr(SENSOR_ATTR_SAMPLING_FREQUENCY, 500), "Rate");
+}
+
+ZTEST_SUITE(exg_emul, NULL, NULL, before, after, NULL);
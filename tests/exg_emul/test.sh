@@ -0,0 +1,7 @@
+#!/bin/bash
+
+export ZEPHYR_SDK_INSTALL_DIR=../../../toolchain/tc/
+
+# The ADS1298 is emulated, so this only runs on native_sim
+west build -b native_sim
+west build -t run
@@ -0,0 +1,106 @@
+#include <errno.h>
+#include <limits.h>
+#include <zephyr/ztest.h>
+#include <ads1298_utils.h>
+#include "stdbool.h"
+
+ZTEST(exg_sensor, test_counts_zero)
+{
+    uint8_t s[3] = {0x00, 0x00, 0x00};
+    zassert_equal(ads1298_sample_counts(s), 0, "Zero sample decoded wrong");
+}
+
+ZTEST(exg_sensor, test_counts_positive_full_scale)
+{
+    uint8_t s[3] = {0x7F, 0xFF, 0xFF};
+    zassert_equal(ads1298_sample_counts(s), 8388607, "+FS decoded wrong");
+}
+
+ZTEST(exg_sensor, test_counts_negative_full_scale)
+{
+    uint8_t s[3] = {0x80, 0x00, 0x00};
+    zassert_equal(ads1298_sample_counts(s), -8388608, "-FS decoded wrong");
+}
+
+ZTEST(exg_sensor, test_counts_minus_one)
+{
+    uint8_t s[3] = {0xFF, 0xFF, 0xFF};
+    zassert_equal(ads1298_sample_counts(s), -1, "-1 decoded wrong");
+}
+
+/* Table 14 */
+ZTEST(exg_sensor, test_pga_gain)
+{
+    zassert_equal(ads1298_pga_gain(0x01), 6, "Reset gain should be 6");
+    zassert_equal(ads1298_pga_gain(0x10), 1, "Gain code 1");
+    zassert_equal(ads1298_pga_gain(0x50), 8, "Gain code 5");
+    zassert_equal(ads1298_pga_gain(0x60), 12, "Gain code 6");
+    zassert_equal(ads1298_pga_gain(0xE0), 12, "PD bit should not affect gain");
+}
+
+/* Table 10 */
+ZTEST(exg_sensor, test_data_rate)
+{
+    zassert_equal(ads1298_data_rate_hz(0x06), 250, "LP reset rate");
+    zassert_equal(ads1298_data_rate_hz(0x86), 500, "HR DR=110 as set in init");
+    zassert_equal(ads1298_data_rate_hz(0x80), 32000, "HR max rate");
+    zassert_equal(ads1298_data_rate_hz(0x07), 0, "Reserved code");
+}
+
+ZTEST(exg_sensor, test_pga_gain_code)
+{
+    zassert_equal(ads1298_pga_gain_code(6), 0, "Gain 6 is code 0");
+    zassert_equal(ads1298_pga_gain_code(12), 6, "Gain 12 is code 6");
+    zassert_equal(ads1298_pga_gain_code(5), -EINVAL, "No gain of 5");
+    zassert_equal(ads1298_pga_gain_code(0), -EINVAL, "Reserved code is not a gain");
+}
+
+ZTEST(exg_sensor, test_data_rate_config1)
+{
+    zassert_equal(ads1298_data_rate_config1(250), 0x06, "250 SPS needs LP mode");
+    zassert_equal(ads1298_data_rate_config1(8000), 0x82, "8 kSPS should use HR");
+    zassert_equal(ads1298_data_rate_config1(32000), 0x80, "HR max rate");
+    zassert_equal(ads1298_data_rate_config1(300), -EINVAL, "Not a device rate");
+    zassert_equal(ads1298_data_rate_config1(0), -EINVAL, "Zero rate");
+}
+
+ZTEST(exg_sensor, test_vref)
+{
+    zassert_equal(ads1298_vref_uv(0xC0), 2400000, "Init CONFIG3 is 2.4V");
+    zassert_equal(ads1298_vref_uv(0xE0), 4000000, "VREF_4V set");
+}
+
+ZTEST(exg_sensor, test_uv_full_scale)
+{
+    int64_t uv = ads1298_counts_to_uv(8388607, 1, 2400000);
+    zassert_equal(uv, 2399999, "Expected just under Vref, got %lld", uv);
+}
+
+ZTEST(exg_sensor, test_uv_gain)
+{
+    /* 1 mV at gain 6 is 1e-3 * 6 * 2^23 / 2.4 counts */
+    int64_t uv = ads1298_counts_to_uv(20972, 6, 2400000);
+    zassert_equal(uv, 1000, "Expected 1000uV, got %lld", uv);
+}
+
+ZTEST(exg_sensor, test_q31_half_volt)
+{
+    /* 0.5 V at gain 1 and 2.4 V ref, q31 with shift 2 is 0.5 * 2^29 */
+    q31_t q = ads1298_counts_to_q31(1747627, 1, 2400000);
+    zassert_within(q, 1 << 28, 256, "Expected 2^28, got %d", q);
+}
+
+ZTEST(exg_sensor, test_q31_extremes)
+{
+    q31_t q = ads1298_counts_to_q31(8388607, 1, 4000000);
+    zassert_true(q > 0, "+FS at 4V ref must not wrap, got %d", q);
+    q = ads1298_counts_to_q31(-8388608, 1, 4000000);
+    zassert_equal(q, INT32_MIN, "-FS at 4V ref should be -4V, got %d", q);
+}
+
+ZTEST(exg_sensor, test_reserved_gain)
+{
+    zassert_equal(ads1298_counts_to_uv(1000, ads1298_pga_gain(0x70), 2400000), 0, "Reserved gain");
+}
+
+ZTEST_SUITE(exg_sensor, NULL, NULL, NULL, NULL, NULL);
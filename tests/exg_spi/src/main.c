@@ -0,0 +1,81 @@
+#include <zephyr/ztest.h>
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/spi.h>
+#include <zephyr/drivers/sensor.h>
+
+#include <app/drivers/ads1298.h>
+
+/* Measures how many 27 byte frames per second the bus can move with the command
+ * timing (4MHz SCLK, needed for multibyte opcodes) and the data timing (full SCLK, DMA)
+ * used for RDATAC. Run with the device in SDATAC mode so frame reads are just noise. */
+
+#define ADS1298_NODE DT_NODELABEL(ads1298)
+#define CMD_SCLK_HZ 4000000
+#define N_FRAMES 2000
+
+static const struct spi_dt_spec bus =
+    SPI_DT_SPEC_GET(ADS1298_NODE, SPI_WORD_SET(8) | SPI_TRANSFER_MSB | SPI_MODE_CPHA, 0);
+
+static uint8_t frame[ADS1298_FRAME_SIZE];
+
+static uint32_t frames_per_second(const struct spi_config *config)
+{
+    const struct spi_buf buf = { .buf = frame, .len = sizeof(frame) };
+    const struct spi_buf_set rx = { .buffers = &buf, .count = 1 };
+
+    uint32_t start = k_cycle_get_32();
+    for (int i = 0; i < N_FRAMES; i++) {
+        zassert_ok(spi_read(bus.bus, config, &rx), "Frame read %d failed", i);
+    }
+    uint32_t cycles = k_cycle_get_32() - start;
+
+    return (uint32_t)(((uint64_t)N_FRAMES * sys_clock_hw_cycles_per_sec()) / cycles);
+}
+
+ZTEST(exg_spi, test_frame_throughput)
+{
+    struct spi_config cmd_cfg = bus.config;
+    cmd_cfg.frequency = MIN(bus.config.frequency, CMD_SCLK_HZ);
+
+    uint32_t cmd_fps = frames_per_second(&cmd_cfg);
+    uint32_t data_fps = frames_per_second(&bus.config);
+
+    TC_PRINT("Command config (%u Hz): %u frames/s\n", cmd_cfg.frequency, cmd_fps);
+    TC_PRINT("Data config (%u Hz): %u frames/s\n", bus.config.frequency, data_fps);
+
+    /* 8 kSPS is the highest rate we capture at */
+    zassert_true(data_fps >= 8000, "Only %u frames/s, cannot sustain 8 kSPS", data_fps);
+}
+
+ZTEST(exg_spi, test_stream_rate)
+{
+    const struct device *const dev = DEVICE_DT_GET(ADS1298_NODE);
+    uint32_t frames = 0;
+    const uint8_t *f;
+
+    zassert_true(device_is_ready(dev), "ADS1298 not ready");
+
+    int ret = ads1298_stream_start(dev);
+    if (ret == -ENOTSUP) {
+        ztest_test_skip();
+    }
+    zassert_ok(ret, "Stream start failed");
+
+    int64_t end = k_uptime_get() + MSEC_PER_SEC;
+    while (k_uptime_get() < end) {
+        if (ads1298_stream_wait(dev, 16, K_MSEC(100)) < 0) {
+            continue;
+        }
+        uint32_t n = ads1298_stream_claim(dev, &f, UINT32_MAX);
+        ads1298_stream_release(dev, n);
+        frames += n;
+    }
+    uint32_t dropped = ads1298_stream_dropped(dev);
+    zassert_ok(ads1298_stream_stop(dev), "Stream stop failed");
+
+    TC_PRINT("Streamed %u frames/s, %u dropped\n", frames, dropped);
+    zassert_equal(dropped, 0, "Frames dropped at the configured data rate");
+}
+
+ZTEST_SUITE(exg_spi, NULL, NULL, NULL, NULL, NULL);
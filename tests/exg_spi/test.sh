@@ -0,0 +1,8 @@
+#!/bin/bash
+
+# Needs the ADS1298 so only runs on the board
+
+export ZEPHYR_SDK_INSTALL_DIR=../../../toolchain/tc/
+
+west build -b db1/mcxn947/cpu0
+west flash --runner=jlink
@@ -0,0 +1,252 @@
+/*
+ * @file test audio_cls library
+ *
+ * Half a minute of a bedroom through audio_feat with its default config:
+ * room noise, snores every 4 s, a few coughs, speech and a door, in 4 ms
+ * stereo blocks stamped in microseconds. Checks that every cough and snore
+ * is reported once near its onset and nothing else is, and measures the
+ * cycles an inference takes with and without batching.
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <zephyr/ztest.h>
+#include <zephyr/kernel.h>
+
+#include <app/lib/audio_cls.h>
+#include <app/lib/audio_feat.h>
+
+#define FS_HZ 8000
+#define TS_HZ 1000000
+#define SECONDS 30
+#define CHANNELS 2
+#define BLOCK_FRAMES 32
+#define ROOM_NOISE 30
+/* An event is on time within two segments of its onset */
+#define ONSET_US 160000
+
+struct event {
+    float start;
+    float length;
+    enum { SNORE, COUGH, VOICE, THUD } kind;
+};
+
+static const struct event events[] = {
+    {2.0f, 1.2f, SNORE},  {6.0f, 1.2f, SNORE},  {8.5f, 0.3f, COUGH},  {10.0f, 1.2f, SNORE},
+    {13.0f, 1.5f, VOICE}, {16.2f, 0.3f, COUGH}, {16.8f, 0.3f, COUGH}, {20.0f, 1.2f, SNORE},
+    {22.1f, 0.1f, THUD},  {24.0f, 1.2f, SNORE}, {27.3f, 0.3f, COUGH},
+};
+
+static struct audio_feat feat;
+static struct audio_cls cls;
+static int16_t block[BLOCK_FRAMES * CHANNELS];
+
+static struct {
+    uint32_t count;
+    uint64_t timestamp[32];
+    enum audio_cls_class cls[32];
+} rx;
+
+static float noise(void)
+{
+    return 2.0f * rand() / RAND_MAX - 1.0f;
+}
+
+static float sound(const struct event *e, float t)
+{
+    float u = t - e->start;
+    float s = 0;
+
+    switch (e->kind) {
+    case SNORE:
+        /* Soft palate flutter at 90 Hz, harmonics falling off, over an inhale */
+        for (int k = 1; k <= 6; k++) {
+            s += sinf(2 * (float)M_PI * 90 * k * t) / k;
+        }
+        return 3000 * sinf((float)M_PI * u / e->length) * s;
+    case COUGH:
+        return 8000 * expf(-u / 0.08f) * noise();
+    case VOICE:
+        return 3000 * sinf((float)M_PI * 3 * u) * sinf((float)M_PI * 3 * u) *
+               (sinf(2 * (float)M_PI * 120 * t) + 0.8f * sinf(2 * (float)M_PI * 720 * t));
+    default:
+        return 6000 * expf(-u / 0.02f) * sinf(2 * (float)M_PI * 60 * t);
+    }
+}
+
+static void make_block(uint32_t n)
+{
+    for (int i = 0; i < BLOCK_FRAMES; i++) {
+        float t = (float)(n * BLOCK_FRAMES + i) / FS_HZ;
+        float x = ROOM_NOISE * noise();
+
+        for (int e = 0; e < ARRAY_SIZE(events); e++) {
+            if (t >= events[e].start && t < events[e].start + events[e].length) {
+                x += sound(&events[e], t);
+            }
+        }
+        block[i * CHANNELS] = CLAMP(lrintf(x), INT16_MIN, INT16_MAX);
+        block[i * CHANNELS + 1] = CLAMP(lrintf(x + ROOM_NOISE * noise()), INT16_MIN, INT16_MAX);
+    }
+}
+
+static void event_sink(enum audio_cls_class c, uint64_t timestamp, int32_t score,
+                       void *user_data)
+{
+    ARG_UNUSED(score);
+    ARG_UNUSED(user_data);
+    if (rx.count < ARRAY_SIZE(rx.timestamp)) {
+        rx.timestamp[rx.count] = timestamp;
+        rx.cls[rx.count] = c;
+    }
+    rx.count++;
+}
+
+/* As the analytics thread would, run the batch as soon as it is ready */
+static void feat_sink(const int16_t *f, uint8_t n_feat, uint64_t timestamp, void *user_data)
+{
+    ARG_UNUSED(user_data);
+    if (audio_cls_push(&cls, f, n_feat, timestamp)) {
+        audio_cls_run(&cls);
+    }
+}
+
+static void setup(uint8_t batch)
+{
+    struct audio_feat_config cfg = AUDIO_FEAT_CONFIG_DEFAULT;
+
+    srand(1);
+    memset(&rx, 0, sizeof(rx));
+    zassert_ok(audio_feat_init(&feat, FS_HZ, TS_HZ, CHANNELS, &cfg, feat_sink, NULL), "Feat");
+    zassert_ok(audio_cls_init(&cls, &audio_cls_default_model, batch, event_sink, NULL), "Init");
+}
+
+static void run(void)
+{
+    for (uint32_t n = 0; n < SECONDS * FS_HZ / BLOCK_FRAMES; n++) {
+        make_block(n);
+        audio_feat_process(&feat, block, BLOCK_FRAMES,
+                           (uint64_t)n * BLOCK_FRAMES * TS_HZ / FS_HZ);
+    }
+}
+
+static void check_events(void)
+{
+    uint32_t expected = 0;
+
+    for (int e = 0; e < ARRAY_SIZE(events); e++) {
+        uint64_t onset = events[e].start * TS_HZ;
+        enum audio_cls_class c = events[e].kind == SNORE ? AUDIO_CLS_SNORE : AUDIO_CLS_COUGH;
+        uint32_t found = 0;
+
+        if (events[e].kind != SNORE && events[e].kind != COUGH) {
+            continue;
+        }
+        expected++;
+        for (uint32_t i = 0; i < MIN(rx.count, ARRAY_SIZE(rx.timestamp)); i++) {
+            if (rx.timestamp[i] + ONSET_US >= onset && rx.timestamp[i] <= onset + ONSET_US) {
+                zassert_equal(rx.cls[i], c, "Event at %.1f s misclassified",
+                              (double)events[e].start);
+                found++;
+            }
+        }
+        zassert_equal(found, 1, "Event at %.1f s reported %u times", (double)events[e].start,
+                      found);
+    }
+    zassert_equal(rx.count, expected, "%u events for %u", rx.count, expected);
+}
+
+ZTEST(audio_cls, test_events)
+{
+    setup(1);
+    run();
+    check_events();
+    zassert_equal(cls.skipped, 0, "Skipped");
+}
+
+ZTEST(audio_cls, test_batched)
+{
+    /* The same events with the same stamps, up to 320 ms later */
+    setup(4);
+    run();
+    check_events();
+
+    /* Every segment with a full context, once the last part batch is run */
+    audio_cls_run(&cls);
+    zassert_equal(cls.inferences, cls.segments - 3, "%u inferences", cls.inferences);
+}
+
+ZTEST(audio_cls, test_reset)
+{
+    int16_t frame[16] = {0};
+
+    zassert_ok(audio_cls_init(&cls, &audio_cls_default_model, 1, event_sink, NULL), "Init");
+
+    /* Half a segment before a gap is dropped, the next segment starts after it */
+    for (uint32_t n = 0; n < 4; n++) {
+        audio_cls_push(&cls, frame, ARRAY_SIZE(frame), n);
+    }
+    audio_cls_reset(&cls);
+    for (uint32_t n = 100; n < 108; n++) {
+        audio_cls_push(&cls, frame, ARRAY_SIZE(frame), n);
+    }
+    zassert_equal(cls.segments, 1, "%u segments", cls.segments);
+    zassert_equal(cls.level_ts[0], 100, "Segment at %u", (uint32_t)cls.level_ts[0]);
+}
+
+ZTEST(audio_cls, test_invalid)
+{
+    static const struct audio_cls_node loop[] = {
+        {.feature = 0, .value = 0, .below = 0, .above = 1},
+        {.feature = AUDIO_CLS_LEAF, .value = 1},
+    };
+    static const struct audio_cls_tree tree = {.root = 0, .cls = AUDIO_CLS_COUGH};
+    struct audio_cls_model model = {
+        .n_bands = 16,
+        .segment_frames = 8,
+        .n_segments = 4,
+        .n_trees = 1,
+        .n_nodes = ARRAY_SIZE(loop),
+        .trees = &tree,
+        .nodes = loop,
+    };
+
+    zassert_equal(audio_cls_init(&cls, &model, 1, event_sink, NULL), -EINVAL, "Loop");
+    zassert_equal(audio_cls_init(&cls, &audio_cls_default_model, 0, event_sink, NULL), -EINVAL,
+                  "No batch");
+    zassert_equal(audio_cls_init(&cls, &audio_cls_default_model, CONFIG_AUDIO_CLS_MAX_SEGMENTS,
+                                 event_sink, NULL),
+                  -EINVAL, "Batch past the ring");
+}
+
+static void benchmark(uint8_t batch)
+{
+    const uint32_t segments = 256;
+    int16_t frame[16];
+    uint32_t cycles = 0;
+
+    zassert_ok(audio_cls_init(&cls, &audio_cls_default_model, batch, event_sink, NULL), "Init");
+    for (uint32_t n = 0; n < segments * 8; n++) {
+        for (int b = 0; b < ARRAY_SIZE(frame); b++) {
+            frame[b] = rand() % 4000 - 9000;
+        }
+        uint32_t start = k_cycle_get_32();
+
+        if (audio_cls_push(&cls, frame, ARRAY_SIZE(frame), n)) {
+            audio_cls_run(&cls);
+        }
+        cycles += k_cycle_get_32() - start;
+    }
+
+    TC_PRINT("batch %u: %u cycles per inference, including 8 frames pushed\n", batch,
+             cycles / cls.inferences);
+}
+
+ZTEST(audio_cls, test_benchmark)
+{
+    benchmark(1);
+    benchmark(4);
+}
+
+ZTEST_SUITE(audio_cls, NULL, NULL, NULL, NULL, NULL);
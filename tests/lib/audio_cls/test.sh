@@ -0,0 +1,5 @@
+#!/bin/bash
+
+# On db1 compare the cycles per inference at batch 1 and batch 4, batching
+# only pays if the second is clearly lower
+exec "$(dirname "$0")/../test.sh" "$@"
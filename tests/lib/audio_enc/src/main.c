@@ -0,0 +1,177 @@
+/*
+ * @file test audio_enc library
+ *
+ * Encodes a synthetic voice, a pitched vowel with formant like harmonics,
+ * syllable envelope and room noise, in audio.c's 4 ms blocks of 32 stereo
+ * frames, decodes every block on its own and reports SNR, ratio and cycles
+ * per block.
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <zephyr/ztest.h>
+#include <zephyr/kernel.h>
+
+#include <app/lib/audio_enc.h>
+
+#define FS_HZ 8000
+#define SECONDS 2
+#define N_FRAMES (FS_HZ * SECONDS)
+#define CHANNELS 2
+#define SAMPLE_NO 32 /* Frames per 128 byte block in audio.c */
+#define N_BLOCKS (N_FRAMES / SAMPLE_NO)
+#define MAX_BLOCK_BYTES (SAMPLE_NO * CHANNELS * sizeof(int16_t))
+
+static int16_t pcm[N_FRAMES * CHANNELS];
+static int16_t decoded[N_FRAMES * CHANNELS];
+static uint8_t encoded[N_BLOCKS][MAX_BLOCK_BYTES];
+static struct audio_enc enc;
+
+static float noise(void)
+{
+    return 2.0f * rand() / RAND_MAX - 1.0f;
+}
+
+/* 120 Hz voice with harmonics peaking near 700 Hz and 1200 Hz over the usual falling
+ * spectrum, 4 syllables a second */
+static void make_voice(void)
+{
+    srand(1);
+    for (int i = 0; i < N_FRAMES; i++) {
+        float t = (float)i / FS_HZ;
+        float envelope = 0.5f - 0.5f * cosf(2 * (float)M_PI * 4 * t);
+        float v = 0;
+
+        for (int h = 1; h <= 25; h++) {
+            float f = 120.0f * h;
+            float gain = expf(-powf((f - 700) / 250, 2)) + 0.5f * expf(-powf((f - 1200) / 300, 2)) +
+                         0.2f / h;
+
+            v += gain * sinf(2 * (float)M_PI * f * t + h);
+        }
+        v = 6000 * envelope * v + 100 * noise();
+        pcm[i * CHANNELS] = (int16_t)CLAMP(lrintf(v), INT16_MIN, INT16_MAX);
+        /* The second microphone further away */
+        pcm[i * CHANNELS + 1] = (int16_t)CLAMP(lrintf(0.3f * v), INT16_MIN, INT16_MAX);
+    }
+}
+
+/* Encodes in blocks, returns bytes */
+static size_t encode_all(enum audio_enc_format format)
+{
+    size_t total = 0;
+
+    zassert_ok(audio_enc_init(&enc, format, CHANNELS), "Init failed");
+    for (int b = 0; b < N_BLOCKS; b++) {
+        int ret = audio_enc_encode(&enc, &pcm[b * SAMPLE_NO * CHANNELS], SAMPLE_NO, encoded[b]);
+
+        zassert_equal(ret, audio_enc_block_bytes(format, CHANNELS, SAMPLE_NO), "Block %d", b);
+        total += ret;
+    }
+    return total;
+}
+
+/* Decodes every block on its own, in reverse to be sure, returns SNR of channel ch in dB */
+static float decode_snr(enum audio_enc_format format, size_t block_bytes, int ch)
+{
+    double signal = 0;
+    double error = 0;
+
+    for (int b = N_BLOCKS - 1; b >= 0; b--) {
+        zassert_equal(audio_enc_decode(format, CHANNELS, encoded[b], block_bytes,
+                                       &decoded[b * SAMPLE_NO * CHANNELS]),
+                      SAMPLE_NO, "Block %d", b);
+    }
+    for (int i = ch; i < N_FRAMES * CHANNELS; i += CHANNELS) {
+        double e = decoded[i] - pcm[i];
+
+        signal += (double)pcm[i] * pcm[i];
+        error += e * e;
+    }
+    return 10 * log10f(signal / error);
+}
+
+ZTEST(audio_enc, test_ima_adpcm)
+{
+    make_voice();
+
+    size_t total = encode_all(AUDIO_ENC_IMA_ADPCM);
+    size_t block_bytes = total / N_BLOCKS;
+    float snr0 = decode_snr(AUDIO_ENC_IMA_ADPCM, block_bytes, 0);
+    float snr1 = decode_snr(AUDIO_ENC_IMA_ADPCM, block_bytes, 1);
+
+    TC_PRINT("IMA-ADPCM: %u bytes per block, %.2f:1, SNR %.1f dB near, %.1f dB far\n",
+             (unsigned)block_bytes, (double)sizeof(pcm) / total, (double)snr0, (double)snr1);
+    zassert_equal(block_bytes, CHANNELS * (AUDIO_ENC_IMA_HEADER_BYTES + SAMPLE_NO / 2), "Size");
+    /* IMA loses about 6 dB an octave, this voice's formants sit near 1 kHz */
+    zassert_true(snr0 > 15 && snr1 > 15, "SNR %d %d dB", (int)snr0, (int)snr1);
+}
+
+ZTEST(audio_enc, test_ima_adpcm_full_scale)
+{
+    /* Rail to rail square wave, the predictor must clamp rather than wrap */
+    for (int i = 0; i < N_FRAMES * CHANNELS; i++) {
+        pcm[i] = ((i / CHANNELS / 20) & 1) ? INT16_MAX : INT16_MIN;
+    }
+
+    size_t total = encode_all(AUDIO_ENC_IMA_ADPCM);
+    float snr = decode_snr(AUDIO_ENC_IMA_ADPCM, total / N_BLOCKS, 0);
+
+    zassert_true(snr > 5, "SNR %d dB", (int)snr);
+}
+
+ZTEST(audio_enc, test_mulaw)
+{
+    static const int16_t silence[CHANNELS] = {0, 0};
+    uint8_t code[CHANNELS];
+
+    zassert_ok(audio_enc_init(&enc, AUDIO_ENC_MULAW, CHANNELS), "Init failed");
+    zassert_equal(audio_enc_encode(&enc, silence, 1, code), CHANNELS, "Size");
+    zassert_equal(code[0], 0xFF, "Silence is 0x%02x", code[0]);
+
+    make_voice();
+
+    size_t total = encode_all(AUDIO_ENC_MULAW);
+    float snr = decode_snr(AUDIO_ENC_MULAW, total / N_BLOCKS, 1);
+
+    TC_PRINT("mu-law: %.2f:1, SNR %.1f dB far\n", (double)sizeof(pcm) / total, (double)snr);
+    zassert_equal(total * 2, sizeof(pcm), "Size");
+    zassert_true(snr > 30, "SNR %d dB", (int)snr);
+}
+
+ZTEST(audio_enc, test_invalid)
+{
+    zassert_equal(audio_enc_init(&enc, AUDIO_ENC_FORMATS, CHANNELS), -EINVAL, "Format");
+    zassert_equal(audio_enc_init(&enc, AUDIO_ENC_MULAW, 0), -EINVAL, "No channels");
+    zassert_equal(audio_enc_init(&enc, AUDIO_ENC_MULAW, AUDIO_ENC_MAX_CHANNELS + 1), -EINVAL,
+                  "Too many channels");
+
+    zassert_ok(audio_enc_init(&enc, AUDIO_ENC_IMA_ADPCM, CHANNELS), "Init failed");
+    zassert_equal(audio_enc_encode(&enc, pcm, SAMPLE_NO - 1, encoded[0]), -EINVAL, "Odd frames");
+    zassert_equal(audio_enc_decode(AUDIO_ENC_IMA_ADPCM, CHANNELS, encoded[0],
+                                   CHANNELS * AUDIO_ENC_IMA_HEADER_BYTES, decoded),
+                  -EINVAL, "Header only");
+    zassert_equal(audio_enc_decode(AUDIO_ENC_MULAW, CHANNELS, encoded[0], 3, decoded), -EINVAL,
+                  "Part frame");
+}
+
+ZTEST(audio_enc, test_benchmark)
+{
+    static const char *const names[] = {"IMA-ADPCM", "mu-law"};
+
+    make_voice();
+
+    for (int format = 0; format < AUDIO_ENC_FORMATS; format++) {
+        uint32_t start = k_cycle_get_32();
+        size_t total = encode_all(format);
+        uint32_t cycles = k_cycle_get_32() - start;
+
+        /* A block every 4 ms at 8 kHz */
+        TC_PRINT("%s: %u cycles per %d frame block, %.2f:1, %u%% of the core\n", names[format],
+                 cycles / N_BLOCKS, SAMPLE_NO, (double)sizeof(pcm) / total,
+                 (uint32_t)((uint64_t)cycles * 100 / SECONDS / sys_clock_hw_cycles_per_sec()));
+    }
+}
+
+ZTEST_SUITE(audio_enc, NULL, NULL, NULL, NULL, NULL);
@@ -0,0 +1,188 @@
+/*
+ * @file test audio_feat library
+ *
+ * Feeds tones and noise in audio.c's 4 ms stereo blocks at 8 kHz, stamped
+ * in microseconds, and checks the frame rate and stamps, the band a tone
+ * lands in and its level, and that the cepstrum is the transform of the
+ * band levels.
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <zephyr/ztest.h>
+#include <zephyr/kernel.h>
+
+#include <app/lib/audio_feat.h>
+
+#define FS_HZ 8000
+#define TS_HZ 1000000
+#define CHANNELS 2
+#define BLOCK_FRAMES 32
+#define DB(q) ((float)(q) / BIT(AUDIO_FEAT_FRAC_BITS))
+
+static struct audio_feat feat;
+static int16_t block[BLOCK_FRAMES * CHANNELS];
+
+static struct {
+    uint32_t count;
+    uint64_t first;
+    uint64_t last;
+    uint32_t uneven;
+    uint8_t n_feat;
+    int16_t feat[CONFIG_AUDIO_FEAT_MAX_BANDS];
+} rx;
+
+static void sink(const int16_t *f, uint8_t n_feat, uint64_t timestamp, void *user_data)
+{
+    ARG_UNUSED(user_data);
+    if (rx.count == 0) {
+        rx.first = timestamp;
+    } else if (timestamp - rx.last != 10000) {
+        rx.uneven++;
+    }
+    rx.last = timestamp;
+    rx.count++;
+    rx.n_feat = n_feat;
+    memcpy(rx.feat, f, n_feat * sizeof(int16_t));
+}
+
+/* @p seconds of a tone of @p amplitude at @p hz over noise of @p noise, both channels */
+static void run(float seconds, float hz, float amplitude, float noise)
+{
+    uint32_t n_blocks = seconds * FS_HZ / BLOCK_FRAMES;
+
+    for (uint32_t n = 0; n < n_blocks; n++) {
+        for (int i = 0; i < BLOCK_FRAMES; i++) {
+            uint32_t t = n * BLOCK_FRAMES + i;
+            float x = amplitude * sinf(2 * (float)M_PI * hz * t / FS_HZ) +
+                      noise * (2.0f * rand() / RAND_MAX - 1.0f);
+
+            block[i * CHANNELS] = CLAMP(lrintf(x * 32767), INT16_MIN, INT16_MAX);
+            block[i * CHANNELS + 1] = block[i * CHANNELS];
+        }
+        audio_feat_process(&feat, block, BLOCK_FRAMES,
+                           (uint64_t)n * BLOCK_FRAMES * TS_HZ / FS_HZ);
+    }
+}
+
+static void setup(uint8_t n_mfcc)
+{
+    struct audio_feat_config cfg = AUDIO_FEAT_CONFIG_DEFAULT;
+
+    cfg.n_mfcc = n_mfcc;
+    memset(&rx, 0, sizeof(rx));
+    zassert_ok(audio_feat_init(&feat, FS_HZ, TS_HZ, CHANNELS, &cfg, sink, NULL), "Init");
+}
+
+ZTEST(audio_feat, test_frames)
+{
+    setup(0);
+    run(1.0f, 1000, 0.1f, 0);
+
+    /* A 32 ms window every 10 ms, stamped at its first sample */
+    zassert_equal(rx.count, (FS_HZ - 256) / 80 + 1, "%u frames", rx.count);
+    zassert_equal(rx.first, 0, "First at %u us", (uint32_t)rx.first);
+    zassert_equal(rx.uneven, 0, "Uneven stamps");
+    zassert_equal(rx.n_feat, 16, "Bands");
+}
+
+ZTEST(audio_feat, test_tone)
+{
+    static const float tones[] = {300, 1000, 2500};
+
+    for (int t = 0; t < ARRAY_SIZE(tones); t++) {
+        int loudest = 0;
+
+        setup(0);
+        run(0.5f, tones[t], 0.5f, 0);
+
+        for (int b = 1; b < rx.n_feat; b++) {
+            if (rx.feat[b] > rx.feat[loudest]) {
+                loudest = b;
+            }
+        }
+        /* Half scale is -6 dB, the band either side of the tone picks up some of it */
+        zassert_within(DB(rx.feat[loudest]), -6, 2, "%.0f Hz at %.1f dB", (double)tones[t],
+                       (double)DB(rx.feat[loudest]));
+        for (int b = 0; b < rx.n_feat; b++) {
+            if (abs(b - loudest) > 1) {
+                zassert_true(DB(rx.feat[b]) < -40, "%.0f Hz leaks %.1f dB into band %d",
+                             (double)tones[t], (double)DB(rx.feat[b]), b);
+            }
+        }
+    }
+}
+
+ZTEST(audio_feat, test_mfcc)
+{
+    int16_t bands[CONFIG_AUDIO_FEAT_MAX_BANDS];
+    const uint8_t n_bands = 16;
+    const uint8_t n_mfcc = 13;
+
+    /* The same noise twice, as band levels and as cepstrum */
+    srand(1);
+    setup(0);
+    run(0.5f, 440, 0.2f, 0.05f);
+    memcpy(bands, rx.feat, sizeof(bands));
+
+    srand(1);
+    setup(n_mfcc);
+    run(0.5f, 440, 0.2f, 0.05f);
+    zassert_equal(rx.n_feat, n_mfcc, "Coefficients");
+
+    for (int k = 0; k < n_mfcc; k++) {
+        float c = 0;
+
+        for (int b = 0; b < n_bands; b++) {
+            c += DB(bands[b]) * cosf((float)M_PI * k * (b + 0.5f) / n_bands) / n_bands;
+        }
+        zassert_within(rx.feat[k], lrintf(c * BIT(AUDIO_FEAT_FRAC_BITS)), 2, "Coefficient %d",
+                       k);
+    }
+}
+
+ZTEST(audio_feat, test_invalid)
+{
+    struct audio_feat_config cfg = AUDIO_FEAT_CONFIG_DEFAULT;
+
+    cfg.fft_len = 200;
+    zassert_equal(audio_feat_init(&feat, FS_HZ, TS_HZ, CHANNELS, &cfg, sink, NULL), -EINVAL,
+                  "Not a power of two");
+
+    cfg = (struct audio_feat_config)AUDIO_FEAT_CONFIG_DEFAULT;
+    cfg.hop = 300;
+    zassert_equal(audio_feat_init(&feat, FS_HZ, TS_HZ, CHANNELS, &cfg, sink, NULL), -EINVAL,
+                  "Hop past the window");
+
+    /* 31 Hz bins cannot resolve 24 bands between 20 and 400 Hz */
+    cfg = (struct audio_feat_config)AUDIO_FEAT_CONFIG_DEFAULT;
+    cfg.n_bands = 24;
+    cfg.f_min_hz = 20;
+    cfg.f_max_hz = 400;
+    zassert_equal(audio_feat_init(&feat, FS_HZ, TS_HZ, CHANNELS, &cfg, sink, NULL), -EINVAL,
+                  "Empty band");
+}
+
+ZTEST(audio_feat, test_benchmark)
+{
+    const uint32_t n_blocks = 2 * FS_HZ / BLOCK_FRAMES;
+    uint32_t cycles = 0;
+
+    setup(13);
+    for (int i = 0; i < ARRAY_SIZE(block); i++) {
+        block[i] = rand() % 2000 - 1000;
+    }
+    for (uint32_t n = 0; n < n_blocks; n++) {
+        uint32_t start = k_cycle_get_32();
+
+        audio_feat_process(&feat, block, BLOCK_FRAMES, n * BLOCK_FRAMES * TS_HZ / FS_HZ);
+        cycles += k_cycle_get_32() - start;
+    }
+
+    TC_PRINT("%u cycles per frame, %u bytes/s of features for %u bytes/s of audio\n",
+             cycles / rx.count, rx.count / 2 * rx.n_feat * (uint32_t)sizeof(int16_t),
+             FS_HZ * CHANNELS * (uint32_t)sizeof(int16_t));
+}
+
+ZTEST_SUITE(audio_feat, NULL, NULL, NULL, NULL, NULL);
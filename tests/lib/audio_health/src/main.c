@@ -0,0 +1,109 @@
+/*
+ * @file test audio_health library
+ *
+ * Feeds read times as audio.c's capture thread would see them for its 4 ms
+ * blocks of 32 stereo frames, with scheduling jitter, a stall and a
+ * restart, and checks the latency histogram, counters and the binary
+ * record.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <zephyr/ztest.h>
+#include <zephyr/sys/byteorder.h>
+
+#include <app/lib/audio_health.h>
+
+#define BLOCK_US 4000
+#define START_US 1000000
+
+static struct audio_health h;
+
+static void before(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    audio_health_init(&h, BLOCK_US);
+    audio_health_start(&h, START_US);
+}
+
+ZTEST(audio_health, test_latency)
+{
+    /* The trigger is 300 us before the DMA starts, reads come 100 to 400 us after each
+     * completion, and block 50 waits behind something for 5 ms */
+    for (uint32_t n = 0; n < 100; n++) {
+        uint64_t completed = START_US + 300 + (n + 1) * BLOCK_US;
+        uint32_t delay = (n == 50) ? 5000 : 100 + (n % 4) * 100;
+
+        audio_health_block(&h, completed + delay, 4, 3);
+    }
+
+    zassert_equal(h.blocks, 100, "Blocks");
+    /* The jitter stays below 1 ms, the stall lands in the 4 to 8 ms bin */
+    zassert_equal(h.latency[0] + h.latency[1] + h.latency[2], 99, "Jitter");
+    zassert_equal(h.latency[5], 1, "Stall");
+    zassert_within(h.latency_max_us, 5000, 400, "Max %u", h.latency_max_us);
+    zassert_equal(h.dma_queued[3], 100, "Queue");
+    zassert_equal(h.slab_used_max, 4, "Slab");
+}
+
+/* The sample clock @p ppm fast against the timebase for a minute, reads 100 us late */
+static void run_drift(int32_t ppm)
+{
+    for (uint32_t n = 0; n < 15000; n++) {
+        uint64_t completed = START_US + (uint64_t)(n + 1) * BLOCK_US * (1000000 - ppm) / 1000000;
+
+        audio_health_block(&h, completed + 100, 2, 2);
+    }
+}
+
+ZTEST(audio_health, test_drift)
+{
+    run_drift(100);
+    zassert_true(h.latency_max_us < 250, "Fast clock built up %u us", h.latency_max_us);
+
+    audio_health_init(&h, BLOCK_US);
+    audio_health_start(&h, START_US);
+    run_drift(-100);
+    zassert_true(h.latency_max_us < 250, "Slow clock built up %u us", h.latency_max_us);
+}
+
+ZTEST(audio_health, test_errors_and_restart)
+{
+    audio_health_block(&h, START_US + BLOCK_US, 2, 2);
+    audio_health_error(&h, -EIO);
+    audio_health_error(&h, -EAGAIN);
+    h.restarts++;
+
+    /* A second run, a long time later */
+    audio_health_start(&h, 10 * START_US);
+    audio_health_block(&h, 10 * START_US + BLOCK_US + 50, 2, 2);
+
+    zassert_equal(h.rx_overruns, 1, "Overruns");
+    zassert_equal(h.rx_errors, 1, "Errors");
+    zassert_true(h.latency_max_us < 250, "Restart not re-anchored, %u us", h.latency_max_us);
+}
+
+ZTEST(audio_health, test_record)
+{
+    uint8_t record[AUDIO_HEALTH_RECORD_BYTES];
+
+    audio_health_block(&h, START_US + BLOCK_US + 20000, 21, 9);
+    h.tx_underruns = 3;
+
+    zassert_equal(audio_health_encode(&h, record, sizeof(record) - 1), -ENOMEM, "Short buffer");
+    zassert_equal(audio_health_encode(&h, record, sizeof(record)), AUDIO_HEALTH_RECORD_BYTES,
+                  "Size");
+
+    zassert_equal(record[0], AUDIO_HEALTH_VERSION, "Version");
+    zassert_equal(record[1], AUDIO_HEALTH_LATENCY_BINS, "Latency bins");
+    zassert_equal(record[2], AUDIO_HEALTH_QUEUE_BINS, "Queue bins");
+    zassert_equal(sys_get_le32(&record[4]), 1, "Blocks");
+    zassert_equal(sys_get_le32(&record[16]), 3, "Underruns");
+    zassert_equal(sys_get_le16(&record[24]), 21, "Slab");
+    zassert_equal(sys_get_le32(&record[28]), 20000, "Max latency");
+    /* Over 16 ms lands in the open bin, over 7 queued in the last */
+    zassert_equal(sys_get_le32(&record[32 + 4 * (AUDIO_HEALTH_LATENCY_BINS - 1)]), 1, "Latency");
+    zassert_equal(sys_get_le32(&record[AUDIO_HEALTH_RECORD_BYTES - 4]), 1, "Queue");
+}
+
+ZTEST_SUITE(audio_health, NULL, NULL, before, NULL, NULL);
@@ -0,0 +1,4 @@
+#!/bin/bash
+
+# No benchmark, the accounting is checked the same on native_sim
+exec "$(dirname "$0")/../test.sh" "$@"
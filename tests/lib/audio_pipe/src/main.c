@@ -0,0 +1,317 @@
+/*
+ * @file test audio_pipe library
+ *
+ * Publishes blocks from a slab standing in for the I2S RX slab and checks
+ * that every consumer sees the same block, not a copy, in order, and that
+ * the block returns to the slab only with the last release.
+ */
+
+#include <errno.h>
+#include <zephyr/ztest.h>
+#include <zephyr/kernel.h>
+
+#include <app/lib/audio_pipe.h>
+
+#define N_BLOCKS 12
+#define BLOCK_SIZE 128
+#define DEPTH 4
+
+K_MEM_SLAB_DEFINE_STATIC(rx_slab, BLOCK_SIZE, N_BLOCKS, 4);
+AUDIO_PIPE_DEFINE(pipe, rx_slab, N_BLOCKS);
+AUDIO_PIPE_DEFINE(small_pipe, rx_slab, 2);
+AUDIO_PIPE_CONSUMER_DEFINE(encoder, DEPTH);
+AUDIO_PIPE_CONSUMER_DEFINE(vad, DEPTH);
+AUDIO_PIPE_CONSUMER_DEFINE(storage, DEPTH);
+AUDIO_PIPE_CONSUMER_DEFINE_OVERRUN(live, DEPTH, AUDIO_PIPE_DROP_OLDEST);
+
+static struct audio_pipe_consumer *const consumers[] = {&encoder, &vad, &storage};
+
+/* A block as the DMA would fill it, samples are the block number */
+static void *capture(uint32_t n)
+{
+    int16_t *data;
+
+    zassert_ok(k_mem_slab_alloc(&rx_slab, (void **)&data, K_NO_WAIT), "Slab empty");
+    for (int i = 0; i < BLOCK_SIZE / sizeof(int16_t); i++) {
+        data[i] = (int16_t)n;
+    }
+    return data;
+}
+
+static void after(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    for (int c = 0; c < ARRAY_SIZE(consumers); c++) {
+        audio_pipe_unregister(&pipe, consumers[c]);
+        audio_pipe_unregister(&small_pipe, consumers[c]);
+        atomic_clear(&consumers[c]->dropped);
+        atomic_clear(&consumers[c]->max_queued);
+    }
+    atomic_clear(&small_pipe.dropped);
+    zassert_equal(k_mem_slab_num_used_get(&rx_slab), 0, "Blocks leaked");
+}
+
+ZTEST(audio_pipe, test_fan_out_zero_copy)
+{
+    void *published[DEPTH];
+
+    for (int c = 0; c < ARRAY_SIZE(consumers); c++) {
+        audio_pipe_register(&pipe, consumers[c]);
+    }
+
+    for (uint32_t n = 0; n < DEPTH; n++) {
+        published[n] = capture(n);
+        zassert_ok(audio_pipe_publish(&pipe, published[n], BLOCK_SIZE, 1000 * n), "Publish");
+    }
+    zassert_equal(k_mem_slab_num_used_get(&rx_slab), DEPTH, "Blocks copied or freed");
+
+    uint32_t first_seq = 0;
+    for (uint32_t n = 0; n < DEPTH; n++) {
+        for (int c = 0; c < ARRAY_SIZE(consumers); c++) {
+            struct audio_block *block = audio_pipe_get(consumers[c], K_NO_WAIT);
+
+            zassert_not_null(block, "Consumer %d block %u missing", c, n);
+            zassert_equal_ptr(block->data, published[n], "Not the DMA block");
+            zassert_equal(block->size, BLOCK_SIZE, "Size");
+            zassert_equal(block->timestamp, 1000 * n, "Timestamp");
+            if (n == 0) {
+                first_seq = block->seq;
+            }
+            zassert_equal(block->seq, first_seq + n, "Sequence");
+            audio_pipe_release(block);
+
+            /* Still held by the consumers that have not got to it */
+            zassert_equal(k_mem_slab_num_used_get(&rx_slab),
+                          DEPTH - n - (c == ARRAY_SIZE(consumers) - 1), "Freed early");
+        }
+    }
+}
+
+ZTEST(audio_pipe, test_no_consumers)
+{
+    zassert_equal(audio_pipe_publish(&pipe, capture(0), BLOCK_SIZE, 0), -ENODATA, "Taken");
+    zassert_equal(k_mem_slab_num_used_get(&rx_slab), 0, "Not freed");
+}
+
+ZTEST(audio_pipe, test_full_queue_drops)
+{
+    struct audio_block *block;
+
+    audio_pipe_register(&pipe, &encoder);
+    audio_pipe_register(&pipe, &vad);
+
+    /* The encoder keeps up, VAD never reads */
+    for (uint32_t n = 0; n < 2 * DEPTH; n++) {
+        zassert_ok(audio_pipe_publish(&pipe, capture(n), BLOCK_SIZE, 0), "Publish");
+        block = audio_pipe_get(&encoder, K_NO_WAIT);
+        zassert_not_null(block, "Encoder missed block %u", n);
+        audio_pipe_release(block);
+    }
+
+    zassert_equal(atomic_get(&encoder.dropped), 0, "Encoder dropped");
+    zassert_equal(atomic_get(&vad.dropped), DEPTH, "VAD dropped %d", (int)atomic_get(&vad.dropped));
+    /* Only what VAD holds */
+    zassert_equal(k_mem_slab_num_used_get(&rx_slab), DEPTH, "Held blocks");
+
+    audio_pipe_unregister(&pipe, &encoder);
+    zassert_equal(audio_pipe_publish(&pipe, capture(0), BLOCK_SIZE, 0), -ENODATA,
+                  "Full queue took the block");
+}
+
+ZTEST(audio_pipe, test_hold)
+{
+    struct audio_block *block;
+
+    audio_pipe_register(&pipe, &storage);
+    zassert_ok(audio_pipe_publish(&pipe, capture(7), BLOCK_SIZE, 0), "Publish");
+
+    block = audio_pipe_get(&storage, K_NO_WAIT);
+    audio_pipe_hold(block);
+    audio_pipe_release(block);
+    zassert_equal(k_mem_slab_num_used_get(&rx_slab), 1, "Freed while held");
+    audio_pipe_release(block);
+}
+
+ZTEST(audio_pipe, test_drop_oldest)
+{
+    struct audio_block *block;
+
+    audio_pipe_register(&pipe, &live);
+    for (uint32_t n = 0; n < 2 * DEPTH; n++) {
+        zassert_ok(audio_pipe_publish(&pipe, capture(n), BLOCK_SIZE, 0), "Publish");
+    }
+
+    zassert_equal(atomic_get(&live.dropped), DEPTH, "Dropped");
+    zassert_equal(atomic_get(&live.max_queued), DEPTH, "Lag");
+    zassert_equal(k_mem_slab_num_used_get(&rx_slab), DEPTH, "Old blocks not freed");
+
+    /* The freshest blocks are queued */
+    for (uint32_t n = DEPTH; n < 2 * DEPTH; n++) {
+        block = audio_pipe_get(&live, K_NO_WAIT);
+        zassert_equal(*(int16_t *)block->data, n, "Block %u", n);
+        audio_pipe_release(block);
+    }
+    audio_pipe_unregister(&pipe, &live);
+    atomic_clear(&live.dropped);
+    atomic_clear(&live.max_queued);
+}
+
+ZTEST(audio_pipe, test_slow_consumer_reclaimed)
+{
+    struct audio_block *block;
+
+    audio_pipe_register(&small_pipe, &encoder);
+    audio_pipe_register(&small_pipe, &storage);
+
+    /* Storage never reads, its queue comes to hold every descriptor */
+    for (uint32_t n = 0; n < 2 * DEPTH; n++) {
+        zassert_ok(audio_pipe_publish(&small_pipe, capture(n), BLOCK_SIZE, 0), "Publish %u", n);
+        block = audio_pipe_get(&encoder, K_NO_WAIT);
+        zassert_not_null(block, "Encoder missed block %u", n);
+        zassert_equal(*(int16_t *)block->data, n, "Block %u", n);
+        audio_pipe_release(block);
+    }
+
+    zassert_equal(atomic_get(&encoder.dropped), 0, "Encoder paid for storage");
+    zassert_equal(atomic_get(&storage.dropped), 2 * DEPTH - 2, "Storage dropped");
+    zassert_equal(atomic_get(&small_pipe.dropped), 0, "Pipe dropped");
+    zassert_equal(k_mem_slab_num_used_get(&rx_slab), 2, "More than max_blocks held");
+}
+
+ZTEST(audio_pipe, test_descriptors_exhausted)
+{
+    struct audio_block *held[2];
+
+    audio_pipe_register(&small_pipe, &storage);
+
+    /* Taken out of the queue, nothing left to reclaim */
+    for (uint32_t n = 0; n < ARRAY_SIZE(held); n++) {
+        zassert_ok(audio_pipe_publish(&small_pipe, capture(n), BLOCK_SIZE, 0), "Publish");
+        held[n] = audio_pipe_get(&storage, K_NO_WAIT);
+    }
+    zassert_equal(audio_pipe_publish(&small_pipe, capture(2), BLOCK_SIZE, 0), -ENOMEM,
+                  "Third block with two descriptors");
+    zassert_equal(atomic_get(&small_pipe.dropped), 1, "Dropped");
+    zassert_equal(k_mem_slab_num_used_get(&rx_slab), 2, "Dropped block not freed");
+
+    audio_pipe_release(held[0]);
+    audio_pipe_release(held[1]);
+}
+
+/* Consumers in their own threads, slower than capture and at different priorities */
+#define THREAD_BLOCKS 200
+#define STACK_SIZE 1024
+
+K_THREAD_STACK_ARRAY_DEFINE(stacks, ARRAY_SIZE(consumers), STACK_SIZE);
+static struct k_thread threads[ARRAY_SIZE(consumers)];
+static uint32_t received[ARRAY_SIZE(consumers)];
+static uint32_t out_of_order[ARRAY_SIZE(consumers)];
+
+static void consumer_thread(void *p1, void *p2, void *p3)
+{
+    int c = POINTER_TO_INT(p1);
+    struct audio_block *block;
+    int32_t last = -1;
+
+    while ((block = audio_pipe_get(consumers[c], K_MSEC(100))) != NULL) {
+        const int16_t *samples = block->data;
+
+        if (samples[0] <= last) {
+            out_of_order[c]++;
+        }
+        last = samples[0];
+        received[c]++;
+        k_busy_wait(100 * (c + 1));
+        audio_pipe_release(block);
+    }
+}
+
+ZTEST(audio_pipe, test_threads)
+{
+    for (int c = 0; c < ARRAY_SIZE(consumers); c++) {
+        received[c] = 0;
+        out_of_order[c] = 0;
+        audio_pipe_register(&pipe, consumers[c]);
+        k_thread_create(&threads[c], stacks[c], STACK_SIZE, consumer_thread, INT_TO_POINTER(c),
+                        NULL, NULL, K_PRIO_PREEMPT(2 + c), 0, K_NO_WAIT);
+    }
+
+    for (uint32_t n = 0; n < THREAD_BLOCKS; n++) {
+        void *data;
+
+        /* As the DMA would, wait for a free block */
+        zassert_ok(k_mem_slab_alloc(&rx_slab, &data, K_MSEC(100)), "Slab exhausted");
+        *(int16_t *)data = (int16_t)n;
+        audio_pipe_publish(&pipe, data, BLOCK_SIZE, 0);
+        k_msleep(1);
+    }
+
+    for (int c = 0; c < ARRAY_SIZE(consumers); c++) {
+        k_thread_join(&threads[c], K_SECONDS(1));
+        TC_PRINT("consumer %d: %u received, %d dropped\n", c, received[c],
+                 (int)atomic_get(&consumers[c]->dropped));
+        zassert_equal(received[c] + atomic_get(&consumers[c]->dropped), THREAD_BLOCKS,
+                      "Consumer %d lost blocks", c);
+        zassert_equal(out_of_order[c], 0, "Consumer %d out of order", c);
+    }
+}
+
+ZTEST(audio_pipe, test_benchmark)
+{
+    const uint32_t rounds = 1000;
+    uint32_t cycles = 0;
+
+    for (int c = 0; c < ARRAY_SIZE(consumers); c++) {
+        audio_pipe_register(&pipe, consumers[c]);
+    }
+
+    for (uint32_t n = 0; n < rounds; n++) {
+        void *data = capture(n);
+        uint32_t start = k_cycle_get_32();
+
+        audio_pipe_publish(&pipe, data, BLOCK_SIZE, 0);
+        for (int c = 0; c < ARRAY_SIZE(consumers); c++) {
+            audio_pipe_release(audio_pipe_get(consumers[c], K_NO_WAIT));
+        }
+        cycles += k_cycle_get_32() - start;
+    }
+
+    TC_PRINT("%u cycles per block to %d consumers and back\n", cycles / rounds,
+             (int)ARRAY_SIZE(consumers));
+}
+
+/* The block length profiles in audio.c, the pipe's cost is per block whatever its length */
+ZTEST(audio_pipe, test_profiles)
+{
+    static const struct {
+        const char *name;
+        uint32_t block_ms;
+    } profiles[] = {{"live", 1}, {"balanced", 4}, {"logging", 32}};
+    const uint32_t rounds = 1000;
+    uint32_t cycles = 0;
+
+    for (int c = 0; c < ARRAY_SIZE(consumers); c++) {
+        audio_pipe_register(&pipe, consumers[c]);
+    }
+    for (uint32_t n = 0; n < rounds; n++) {
+        void *data = capture(n);
+        uint32_t start = k_cycle_get_32();
+
+        audio_pipe_publish(&pipe, data, BLOCK_SIZE, 0);
+        for (int c = 0; c < ARRAY_SIZE(consumers); c++) {
+            audio_pipe_release(audio_pipe_get(consumers[c], K_NO_WAIT));
+        }
+        cycles += k_cycle_get_32() - start;
+    }
+
+    for (int p = 0; p < ARRAY_SIZE(profiles); p++) {
+        uint32_t blocks_per_s = MSEC_PER_SEC / profiles[p].block_ms;
+
+        /* The capture thread and every consumer thread wake for each block */
+        TC_PRINT("%-8s %2u ms: %5u wakeups/s, %u cycles/s in the pipe\n", profiles[p].name,
+                 profiles[p].block_ms, blocks_per_s * (1 + ARRAY_SIZE(consumers)),
+                 cycles / rounds * blocks_per_s);
+    }
+}
+
+ZTEST_SUITE(audio_pipe, NULL, NULL, NULL, after, NULL);
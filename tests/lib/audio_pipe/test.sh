@@ -0,0 +1,5 @@
+#!/bin/bash
+
+# The block profile table gives wakeups and pipe cycles a second for 1, 4
+# and 32 ms blocks, only db1's cycles count
+exec "$(dirname "$0")/../test.sh" "$@"
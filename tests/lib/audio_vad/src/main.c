@@ -0,0 +1,213 @@
+/*
+ * @file test audio_vad library
+ *
+ * A night in a quiet bedroom compressed to a minute: room noise with a few
+ * spoken phrases, coughs and a door, in audio.c's 4 ms blocks of 32 stereo
+ * frames.
+ * Checks that at least 80% of the blocks are dropped, that no event onset is
+ * lost and that the forwarded blocks stay in capture order.
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <zephyr/ztest.h>
+#include <zephyr/kernel.h>
+
+#include <app/lib/audio_vad.h>
+
+#define FS_HZ 8000
+#define SECONDS 60
+#define CHANNELS 2
+#define SAMPLE_NO 32
+#define N_BLOCKS (FS_HZ * SECONDS / SAMPLE_NO)
+#define ROOM_NOISE 30
+
+struct event {
+    float start;
+    float length;
+    enum { VOICE, COUGH, THUD } kind;
+};
+
+static const struct event events[] = {
+    {5.0f, 1.5f, VOICE},  {12.3f, 0.3f, COUGH}, {12.9f, 0.3f, COUGH}, {25.0f, 2.0f, VOICE},
+    {40.1f, 0.1f, THUD},  {52.0f, 0.4f, COUGH},
+};
+
+static int16_t block[SAMPLE_NO * CHANNELS];
+static struct audio_vad vad;
+static uint32_t forwarded[N_BLOCKS];
+static uint32_t n_forwarded;
+
+static float noise(void)
+{
+    return 2.0f * rand() / RAND_MAX - 1.0f;
+}
+
+static float sound(const struct event *e, float t)
+{
+    float u = t - e->start;
+
+    switch (e->kind) {
+    case VOICE:
+        /* Syllables of a 120 Hz voice with a formant near 700 Hz */
+        return 3000 * sinf((float)M_PI * 3 * u) * sinf((float)M_PI * 3 * u) *
+               (sinf(2 * (float)M_PI * 120 * t) + 0.8f * sinf(2 * (float)M_PI * 720 * t));
+    case COUGH:
+        /* Broadband burst, decaying */
+        return 8000 * expf(-u / 0.08f) * noise();
+    default:
+        return 6000 * expf(-u / 0.02f) * sinf(2 * (float)M_PI * 60 * t);
+    }
+}
+
+/* Block b of the night, channel 1 a quieter copy of channel 0 */
+static void make_block(uint32_t b, float room_noise, bool with_events)
+{
+    for (int i = 0; i < SAMPLE_NO; i++) {
+        float t = (float)(b * SAMPLE_NO + i) / FS_HZ;
+        float v = room_noise * noise();
+
+        for (int e = 0; with_events && e < ARRAY_SIZE(events); e++) {
+            if (t >= events[e].start && t < events[e].start + events[e].length) {
+                v += sound(&events[e], t);
+            }
+        }
+        block[i * CHANNELS] = (int16_t)CLAMP(lrintf(v), INT16_MIN, INT16_MAX);
+        block[i * CHANNELS + 1] = (int16_t)CLAMP(lrintf(0.5f * v), INT16_MIN, INT16_MAX);
+    }
+}
+
+/* Timestamps are block numbers */
+static void sink(const int16_t *pcm, size_t n_frames, uint64_t timestamp, void *user_data)
+{
+    ARG_UNUSED(pcm);
+    ARG_UNUSED(user_data);
+    zassert_equal(n_frames, SAMPLE_NO, "Frames");
+    if (n_forwarded > 0) {
+        zassert_true(timestamp > forwarded[n_forwarded - 1], "Block %u after %u",
+                     (uint32_t)timestamp, forwarded[n_forwarded - 1]);
+    }
+    forwarded[n_forwarded++] = timestamp;
+}
+
+static bool was_forwarded(uint32_t b)
+{
+    for (uint32_t i = 0; i < n_forwarded; i++) {
+        if (forwarded[i] == b) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void before(void *fixture)
+{
+    const struct audio_vad_config cfg = AUDIO_VAD_CONFIG_DEFAULT;
+
+    ARG_UNUSED(fixture);
+    srand(1);
+    n_forwarded = 0;
+    zassert_ok(audio_vad_init(&vad, FS_HZ, CHANNELS, SAMPLE_NO, &cfg, sink, NULL), "Init failed");
+}
+
+ZTEST(audio_vad, test_quiet_night)
+{
+    for (uint32_t b = 0; b < N_BLOCKS; b++) {
+        make_block(b, ROOM_NOISE, true);
+        audio_vad_process(&vad, block, b);
+    }
+
+    TC_PRINT("%u of %u blocks forwarded, %u%% dropped\n", vad.blocks_out, vad.blocks_in,
+             100 - vad.blocks_out * 100 / vad.blocks_in);
+    zassert_equal(vad.blocks_out, n_forwarded, "Count");
+    zassert_true(vad.blocks_out * 5 < vad.blocks_in, "Less than 80%% dropped");
+
+    /* Every onset and the pre-roll ahead of it */
+    for (int e = 0; e < ARRAY_SIZE(events); e++) {
+        uint32_t onset = events[e].start * FS_HZ / SAMPLE_NO;
+
+        for (uint32_t b = onset - 8; b <= onset + 2; b++) {
+            zassert_true(was_forwarded(b), "Event %d block %u lost", e, b);
+        }
+    }
+}
+
+ZTEST(audio_vad, test_silence)
+{
+    for (uint32_t b = 0; b < N_BLOCKS / 4; b++) {
+        make_block(b, ROOM_NOISE, false);
+        zassert_false(audio_vad_process(&vad, block, b), "Room noise at block %u", b);
+    }
+}
+
+ZTEST(audio_vad, test_noise_rise)
+{
+    /* The fan comes on, 12 dB louder, and stays on */
+    for (uint32_t b = 0; b < N_BLOCKS / 4; b++) {
+        make_block(b, b < 250 ? ROOM_NOISE : 4 * ROOM_NOISE, false);
+        audio_vad_process(&vad, block, b);
+    }
+
+    zassert_true(n_forwarded > 0, "Step not detected");
+    TC_PRINT("Louder room ignored after %u ms\n",
+             (forwarded[n_forwarded - 1] - 250) * SAMPLE_NO * 1000 / FS_HZ);
+    zassert_true(forwarded[n_forwarded - 1] < 250 + 10 * FS_HZ / SAMPLE_NO,
+                 "Still active after 10 s");
+}
+
+ZTEST(audio_vad, test_invalid)
+{
+    struct audio_vad_config cfg = AUDIO_VAD_CONFIG_DEFAULT;
+
+    zassert_equal(
+        audio_vad_init(&vad, FS_HZ, CHANNELS, CONFIG_AUDIO_VAD_BLOCK_BYTES, &cfg, sink, NULL),
+        -EINVAL, "Block too large");
+    zassert_equal(audio_vad_init(&vad, FS_HZ, 0, SAMPLE_NO, &cfg, sink, NULL), -EINVAL,
+                  "No channels");
+    zassert_equal(audio_vad_init(&vad, 0, CHANNELS, SAMPLE_NO, &cfg, sink, NULL), -EINVAL,
+                  "No rate");
+    cfg.preroll_ms = (CONFIG_AUDIO_VAD_PREROLL_BLOCKS + 1) * SAMPLE_NO * 1000 / FS_HZ;
+    zassert_equal(audio_vad_init(&vad, FS_HZ, CHANNELS, SAMPLE_NO, &cfg, sink, NULL), -EINVAL,
+                  "Pre-roll too long");
+}
+
+ZTEST(audio_vad, test_block_length)
+{
+    struct audio_vad_config cfg = AUDIO_VAD_CONFIG_DEFAULT;
+    uint32_t rise;
+
+    zassert_equal(vad.hangover_blocks, 80, "Hangover %u", vad.hangover_blocks);
+    zassert_equal(vad.preroll_blocks, 64, "Pre-roll %u", vad.preroll_blocks);
+    rise = vad.rise;
+
+    /* The same times in 2 ms blocks, with a pre-roll that fits */
+    cfg.preroll_ms = 100;
+    zassert_ok(audio_vad_init(&vad, FS_HZ, CHANNELS, SAMPLE_NO / 2, &cfg, sink, NULL), "Init");
+    zassert_equal(vad.hangover_blocks, 160, "Hangover %u", vad.hangover_blocks);
+    zassert_equal(vad.preroll_blocks, 50, "Pre-roll %u", vad.preroll_blocks);
+    zassert_within(vad.rise * 2, rise, 1, "Rise %u for %u", vad.rise, rise);
+
+    /* Part blocks round up */
+    zassert_ok(audio_vad_init(&vad, FS_HZ, CHANNELS, 30, &cfg, sink, NULL), "Init");
+    zassert_equal(vad.preroll_blocks, 27, "Pre-roll %u", vad.preroll_blocks);
+}
+
+ZTEST(audio_vad, test_benchmark)
+{
+    uint32_t cycles = 0;
+
+    for (uint32_t b = 0; b < N_BLOCKS / 4; b++) {
+        make_block(b, ROOM_NOISE, true);
+
+        uint32_t start = k_cycle_get_32();
+
+        audio_vad_process(&vad, block, b);
+        cycles += k_cycle_get_32() - start;
+    }
+
+    /* A block every 4 ms */
+    TC_PRINT("%u cycles per %d frame block\n", cycles / (N_BLOCKS / 4), SAMPLE_NO);
+}
+
+ZTEST_SUITE(audio_vad, NULL, NULL, before, NULL, NULL);
@@ -0,0 +1,223 @@
+/*
+ * @file test exg_compress library
+ *
+ * Compresses synthetic 8 channel ECG in ADC counts, with electrode offsets,
+ * baseline wander, mains and amplifier noise at the ADS1298's level, checks
+ * that every packet decodes back bit exact and reports the ratio against the
+ * raw frames the driver stores today. Full scale noise checks the verbatim
+ * escape.
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr/ztest.h>
+#include <zephyr/kernel.h>
+
+#include <app/lib/exg_compress.h>
+
+#define FS_HZ 1000
+#define SECONDS 4
+#define N_FRAMES (FS_HZ * SECONDS)
+#define CHANNELS 8
+#define BLOCK 37 /* Deliberately not a divisor of anything */
+#define RAW_FRAME_BYTES 27
+#define MAX_PACKETS 64
+#define DECODE_STRIDE 2048
+
+/* Gain 6 with the 2.4 V reference */
+#define COUNTS_PER_UV (8388608.0f * 6 / 2400000)
+
+static int32_t rows[CHANNELS][N_FRAMES];
+static int32_t decoded[CHANNELS][DECODE_STRIDE];
+static uint8_t packets[MAX_PACKETS][CONFIG_EXG_COMPRESS_PACKET_BYTES];
+static struct exg_compress enc;
+
+static float gauss(float t, float centre, float width)
+{
+    float x = (t - centre) / width;
+
+    return expf(-0.5f * x * x);
+}
+
+static float noise(void)
+{
+    float u1 = (rand() + 1.0f) / (RAND_MAX + 2.0f);
+    float u2 = (rand() + 1.0f) / (RAND_MAX + 2.0f);
+
+    return sqrtf(-2 * logf(u1)) * cosf(2 * (float)M_PI * u2);
+}
+
+/* 72 bpm, every channel a differently scaled lead with its own offset, 1.5 uV rms noise */
+static void make_ecg(void)
+{
+    srand(1);
+    for (int ch = 0; ch < CHANNELS; ch++) {
+        float scale = 0.4f + 0.2f * ch;
+        float offset_uv = 20000.0f * (ch - 3);
+
+        for (int i = 0; i < N_FRAMES; i++) {
+            float t = (float)i / FS_HZ;
+            float r_t = 0.5f + (int)((t - 0.5f) / 0.833f + 0.5f) * 0.833f;
+            float uv = offset_uv + 300 * sinf(2 * (float)M_PI * 0.3f * t + ch) +
+                       20 * sinf(2 * (float)M_PI * 50 * t) +
+                       scale * (150 * gauss(t, r_t - 0.16f, 0.02f) -
+                                100 * gauss(t, r_t - 0.02f, 0.006f) +
+                                1000 * gauss(t, r_t, 0.008f) -
+                                200 * gauss(t, r_t + 0.025f, 0.008f) +
+                                300 * gauss(t, r_t + 0.25f, 0.05f)) +
+                       1.5f * noise();
+
+            rows[ch][i] = (int32_t)lrintf(uv * COUNTS_PER_UV);
+        }
+    }
+}
+
+/* Feeds the record in odd sized blocks, returns packets */
+static int compress_all(uint8_t n_channels, uint32_t n_frames)
+{
+    int n_packets = 0;
+
+    zassert_ok(exg_compress_init(&enc, n_channels), "Init failed");
+
+    for (uint32_t i = 0; i < n_frames; i += BLOCK) {
+        uint32_t n = MIN(BLOCK, n_frames - i);
+        int ret = exg_compress_process(&enc, &rows[0][i], n, N_FRAMES, packets[n_packets],
+                                       MAX_PACKETS - n_packets);
+
+        zassert_true(ret >= 0, "Process failed %d", ret);
+        n_packets += ret;
+    }
+    n_packets += exg_compress_flush(&enc, packets[n_packets]);
+    return n_packets;
+}
+
+/* Every packet decodes on its own, in order and without gaps */
+static void check_round_trip(int n_packets, uint8_t n_channels, uint32_t n_frames)
+{
+    struct exg_compress_info info;
+    uint32_t next = 0;
+
+    for (int p = 0; p < n_packets; p++) {
+        int n = exg_compress_decode(packets[p], &info, &decoded[0][0], DECODE_STRIDE);
+
+        zassert_true(n > 0, "Packet %d failed %d", p, n);
+        zassert_equal(info.first_frame, next, "Packet %d starts at %u", p, info.first_frame);
+        zassert_equal(info.n_channels, n_channels, "Channels");
+        for (int ch = 0; ch < n_channels; ch++) {
+            zassert_mem_equal(decoded[ch], &rows[ch][next], n * sizeof(int32_t),
+                              "Packet %d channel %d differs", p, ch);
+        }
+        next += n;
+    }
+    zassert_equal(next, n_frames, "%u frames decoded", next);
+}
+
+ZTEST(exg_compress, test_ecg_ratio)
+{
+    make_ecg();
+
+    int n_packets = compress_all(CHANNELS, N_FRAMES);
+    float ratio = (float)(N_FRAMES * RAW_FRAME_BYTES) /
+                  (n_packets * CONFIG_EXG_COMPRESS_PACKET_BYTES);
+
+    TC_PRINT("%d packets, %.2f:1 against raw frames, %.2f bits per sample\n", n_packets,
+             (double)ratio,
+             (double)(n_packets * CONFIG_EXG_COMPRESS_PACKET_BYTES * 8.0f / (N_FRAMES * CHANNELS)));
+
+    check_round_trip(n_packets, CHANNELS, N_FRAMES);
+    zassert_true(ratio >= 2.5f, "Ratio %d/100", (int)(ratio * 100));
+}
+
+ZTEST(exg_compress, test_full_scale_noise)
+{
+    const uint32_t n_frames = 1000;
+
+    srand(2);
+    for (int ch = 0; ch < CHANNELS; ch++) {
+        for (int i = 0; i < n_frames; i++) {
+            rows[ch][i] = sign_extend(rand() & 0xFFFFFF, 23);
+        }
+    }
+    rows[0][0] = -8388608;
+    rows[1][0] = 8388607;
+
+    int n_packets = compress_all(CHANNELS, n_frames);
+
+    /* Verbatim blocks, two to a 1 KiB packet, stay within a quarter of the raw frames */
+    zassert_true(n_packets * CONFIG_EXG_COMPRESS_PACKET_BYTES <= n_frames * RAW_FRAME_BYTES * 5 / 4,
+                 "%d packets", n_packets);
+    check_round_trip(n_packets, CHANNELS, n_frames);
+}
+
+ZTEST(exg_compress, test_steps_and_flat)
+{
+    /* Flat lines with rare rail to rail steps, as a channel saturating on lead-off */
+    for (int ch = 0; ch < CHANNELS; ch++) {
+        for (int i = 0; i < N_FRAMES; i++) {
+            rows[ch][i] = ((i / (97 + ch)) & 1) ? 8388607 : -8388608;
+        }
+    }
+
+    check_round_trip(compress_all(CHANNELS, N_FRAMES), CHANNELS, N_FRAMES);
+}
+
+ZTEST(exg_compress, test_single_channel)
+{
+    make_ecg();
+    check_round_trip(compress_all(1, N_FRAMES), 1, N_FRAMES);
+}
+
+ZTEST(exg_compress, test_invalid)
+{
+    uint8_t packet[CONFIG_EXG_COMPRESS_PACKET_BYTES];
+    struct exg_compress_info info;
+
+    zassert_equal(exg_compress_init(&enc, 0), -EINVAL, "No channels");
+    zassert_equal(exg_compress_init(&enc, EXG_MAX_CHANNELS + 1), -EINVAL, "Too many channels");
+
+    zassert_ok(exg_compress_init(&enc, CHANNELS), "Init failed");
+    zassert_equal(exg_compress_process(&enc, &rows[0][0], 100, N_FRAMES, packets[0], 1), -ENOMEM,
+                  "Room for too few packets");
+
+    make_ecg();
+    exg_compress_process(&enc, &rows[0][0], 100, N_FRAMES, packets[0], MAX_PACKETS);
+    zassert_equal(exg_compress_flush(&enc, packets[0]), 1, "Flush");
+
+    zassert_equal(exg_compress_decode(packets[0], &info, &decoded[0][0], 99), -ENOMEM,
+                  "Short stride");
+
+    memcpy(packet, packets[0], sizeof(packet));
+    packet[7]++;
+    zassert_equal(exg_compress_decode(packet, &info, &decoded[0][0], DECODE_STRIDE), -EINVAL,
+                  "Version");
+
+    /* Claims more frames than the bits hold */
+    memcpy(packet, packets[0], sizeof(packet));
+    packet[4] = 0xF0;
+    zassert_equal(exg_compress_decode(packet, &info, &decoded[0][0], DECODE_STRIDE), -EINVAL,
+                  "Overrun");
+}
+
+ZTEST(exg_compress, test_benchmark)
+{
+    make_ecg();
+
+    uint32_t start = k_cycle_get_32();
+    int n_packets = compress_all(CHANNELS, N_FRAMES);
+    uint32_t cycles = k_cycle_get_32() - start;
+
+    /* Share of the core at FS_HZ */
+    TC_PRINT("%u cycles per frame of %d channels, %u%% of the core at %d SPS\n",
+             cycles / N_FRAMES, CHANNELS,
+             (uint32_t)((uint64_t)cycles * 100 / SECONDS / sys_clock_hw_cycles_per_sec()),
+             FS_HZ);
+
+    start = k_cycle_get_32();
+    check_round_trip(n_packets, CHANNELS, N_FRAMES);
+    cycles = k_cycle_get_32() - start;
+    TC_PRINT("%u cycles per frame to decode\n", cycles / N_FRAMES);
+}
+
+ZTEST_SUITE(exg_compress, NULL, NULL, NULL, NULL, NULL);
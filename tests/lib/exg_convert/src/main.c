@@ -0,0 +1,184 @@
+/*
+ * @file test exg_convert library
+ *
+ * Checks the block kernel against the driver's per-sample conversion, which is
+ * also the scalar reference for the benchmark.
+ */
+
+#include <stdlib.h>
+#include <zephyr/ztest.h>
+#include <zephyr/kernel.h>
+
+#include <app/drivers/ads1298.h>
+#include <app/lib/exg_convert.h>
+#include <ads1298_utils.h>
+
+#define N_FRAMES 256
+#define MAX_FRAME_SIZE (2 * ADS1298_FRAME_SIZE)
+
+static uint8_t frames[N_FRAMES * MAX_FRAME_SIZE];
+static int32_t out[EXG_MAX_CHANNELS * N_FRAMES];
+static int32_t ref[EXG_MAX_CHANNELS * N_FRAMES];
+
+static const uint8_t gains[EXG_MAX_CHANNELS] = {1, 2, 3, 4, 6, 8, 12, 0, 6, 6, 6, 6, 1, 1, 12, 12};
+
+static uint32_t lcg_state = 1;
+
+static uint8_t lcg_byte(void)
+{
+    lcg_state = lcg_state * 1664525 + 1013904223;
+    return lcg_state >> 24;
+}
+
+static void fill_frames(uint8_t n_devices)
+{
+    for (size_t i = 0; i < N_FRAMES * n_devices * ADS1298_FRAME_SIZE; i++) {
+        frames[i] = lcg_byte();
+    }
+}
+
+/* What a consumer would write without the kernel, one sys_get_be24 and a divide per sample */
+static void scalar_q31(uint8_t n_devices, uint32_t vref_uv, int32_t *dst)
+{
+    const size_t frame_size = n_devices * ADS1298_FRAME_SIZE;
+    const unsigned int n_channels = n_devices * ADS1298_DEVICE_CHANNELS;
+
+    for (uint32_t f = 0; f < N_FRAMES; f++) {
+        for (unsigned int ch = 0; ch < n_channels; ch++) {
+            int32_t counts = ads1298_sample_counts(&frames[f * frame_size + ads1298_sample_offset(ch)]);
+
+            dst[ch * N_FRAMES + f] = ads1298_counts_to_q31(counts, gains[ch], vref_uv);
+        }
+    }
+}
+
+static void scalar_uv(uint8_t n_devices, uint32_t vref_uv, int32_t *dst)
+{
+    const size_t frame_size = n_devices * ADS1298_FRAME_SIZE;
+    const unsigned int n_channels = n_devices * ADS1298_DEVICE_CHANNELS;
+
+    for (uint32_t f = 0; f < N_FRAMES; f++) {
+        for (unsigned int ch = 0; ch < n_channels; ch++) {
+            int32_t counts = ads1298_sample_counts(&frames[f * frame_size + ads1298_sample_offset(ch)]);
+
+            dst[ch * N_FRAMES + f] = ads1298_counts_to_uv(counts, gains[ch], vref_uv);
+        }
+    }
+}
+
+static void assert_close(uint8_t n_devices, int32_t tolerance)
+{
+    for (unsigned int i = 0; i < n_devices * ADS1298_DEVICE_CHANNELS * N_FRAMES; i++) {
+        zassert_within(out[i], ref[i], tolerance, "Sample %u: got %d, expected %d", i, out[i],
+                       ref[i]);
+    }
+}
+
+ZTEST(exg_convert, test_q31_matches_scalar)
+{
+    struct exg_convert cv;
+
+    for (uint8_t n_devices = 1; n_devices <= 2; n_devices++) {
+        fill_frames(n_devices);
+        exg_convert_init_q31(&cv, n_devices, gains, 2400000);
+        exg_convert_block(&cv, frames, N_FRAMES, out, N_FRAMES);
+        scalar_q31(n_devices, 2400000, ref);
+        /* The kernel rounds the scale once, the reference divides every sample */
+        assert_close(n_devices, 2);
+    }
+}
+
+ZTEST(exg_convert, test_uv_matches_scalar)
+{
+    struct exg_convert cv;
+
+    for (uint8_t n_devices = 1; n_devices <= 2; n_devices++) {
+        fill_frames(n_devices);
+        exg_convert_init_uv(&cv, n_devices, gains, 4000000);
+        exg_convert_block(&cv, frames, N_FRAMES, out, N_FRAMES);
+        scalar_uv(n_devices, 4000000, ref);
+        /* Floor against truncation towards zero */
+        assert_close(n_devices, 1);
+    }
+}
+
+ZTEST(exg_convert, test_full_scale)
+{
+    const uint8_t unity[EXG_MAX_CHANNELS] = {1, 1, 1, 1, 1, 1, 1, 1};
+    uint8_t frame[ADS1298_FRAME_SIZE] = {0};
+    struct exg_convert cv;
+
+    /* +FS on channel 0, -FS on channel 1, -1 on channel 7 */
+    frame[3] = 0x7F; frame[4] = 0xFF; frame[5] = 0xFF;
+    frame[6] = 0x80;
+    frame[24] = 0xFF; frame[25] = 0xFF; frame[26] = 0xFF;
+
+    exg_convert_init_q31(&cv, 1, unity, 4000000);
+    exg_convert_block(&cv, frame, 1, out, 1);
+    zassert_true(out[0] > INT32_MAX - 1024, "+FS at 4 V should be close to 1.0, got %d", out[0]);
+    zassert_true(out[1] < INT32_MIN + 1024, "-FS at 4 V should be close to -1.0, got %d", out[1]);
+    zassert_true(out[7] < 0 && out[7] > -1024, "-1 count should stay small and negative, got %d", out[7]);
+    zassert_equal(out[2], 0, "Zero sample");
+}
+
+ZTEST(exg_convert, test_counts_exact)
+{
+    struct exg_convert cv;
+
+    fill_frames(2);
+    exg_convert_init_counts(&cv, 2);
+    exg_convert_block(&cv, frames, N_FRAMES, out, N_FRAMES);
+
+    for (uint32_t f = 0; f < N_FRAMES; f++) {
+        for (unsigned int ch = 0; ch < EXG_MAX_CHANNELS; ch++) {
+            int32_t counts = ads1298_sample_counts(
+                &frames[f * MAX_FRAME_SIZE + ads1298_sample_offset(ch)]);
+
+            zassert_equal(out[ch * N_FRAMES + f], counts, "Frame %u channel %u", f, ch);
+        }
+    }
+}
+
+ZTEST(exg_convert, test_wrapped_run)
+{
+    struct exg_convert cv;
+    int32_t split[EXG_MAX_CHANNELS * N_FRAMES];
+
+    fill_frames(1);
+    exg_convert_init_uv(&cv, 1, gains, 2400000);
+    exg_convert_block(&cv, frames, N_FRAMES, out, N_FRAMES);
+
+    /* As for a run either side of the ring wrap, into the same rows */
+    exg_convert_block(&cv, frames, 100, split, N_FRAMES);
+    exg_convert_block(&cv, &frames[100 * ADS1298_FRAME_SIZE], N_FRAMES - 100, &split[100], N_FRAMES);
+
+    zassert_mem_equal(split, out, ADS1298_DEVICE_CHANNELS * N_FRAMES * sizeof(int32_t),
+                      "Split conversion differs");
+}
+
+ZTEST(exg_convert, test_benchmark)
+{
+    struct exg_convert cv;
+    uint32_t start;
+
+    fill_frames(1);
+    exg_convert_init_q31(&cv, 1, gains, 2400000);
+
+    start = k_cycle_get_32();
+    scalar_q31(1, 2400000, ref);
+    uint32_t scalar_cycles = k_cycle_get_32() - start;
+
+    start = k_cycle_get_32();
+    exg_convert_block(&cv, frames, N_FRAMES, out, N_FRAMES);
+    uint32_t block_cycles = k_cycle_get_32() - start;
+
+    TC_PRINT("Scalar: %u cycles/frame\n", scalar_cycles / N_FRAMES);
+    TC_PRINT("Block:  %u cycles/frame\n", block_cycles / N_FRAMES);
+
+    /* native_sim time does not advance while code runs, only compare on target */
+    if (scalar_cycles != 0) {
+        zassert_true(block_cycles < scalar_cycles, "Block kernel slower than scalar reference");
+    }
+}
+
+ZTEST_SUITE(exg_convert, NULL, NULL, NULL, NULL, NULL);
@@ -0,0 +1,5 @@
+#!/bin/bash
+
+# On db1 the scalar and block cycles per frame show what the block kernel
+# saves over the driver's per-sample conversion
+exec "$(dirname "$0")/../test.sh" "$@"
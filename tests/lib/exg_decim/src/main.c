@@ -0,0 +1,149 @@
+/*
+ * @file test exg_decim library
+ *
+ * Checks the decimator's passband, alias rejection and block handling, and
+ * reports the cost per input sample.
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr/ztest.h>
+#include <zephyr/kernel.h>
+
+#include <app/lib/exg_decim.h>
+
+#define FS_IN_HZ 8000
+#define FS_OUT_HZ 250
+#define N_FRAMES 8000 /* 1 s */
+#define N_CHANNELS 8
+#define AMPLITUDE (1 << 26)
+
+static int32_t rows[N_CHANNELS * N_FRAMES];
+static struct exg_decim dec;
+
+static void fill_sine(int32_t *row, float freq_hz)
+{
+    for (int i = 0; i < N_FRAMES; i++) {
+        row[i] = (int32_t)(AMPLITUDE * sinf(2.0f * (float)M_PI * freq_hz * i / FS_IN_HZ));
+    }
+}
+
+/* Peak of the output of the second of two blocks, after the filters' delay */
+static int32_t output_peak(float freq_hz)
+{
+    uint32_t n_out = 0;
+    int32_t peak = 0;
+
+    for (int b = 0; b < 2; b++) {
+        fill_sine(rows, freq_hz);
+        n_out = exg_decim_process(&dec, rows, N_FRAMES, N_FRAMES);
+    }
+    for (uint32_t i = 0; i < n_out; i++) {
+        peak = MAX(peak, abs(rows[i]));
+    }
+    return peak;
+}
+
+static void before(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    zassert_ok(exg_decim_init(&dec, N_CHANNELS, FS_IN_HZ, FS_OUT_HZ), "Init failed");
+}
+
+ZTEST(exg_decim, test_dc_gain)
+{
+    uint32_t n_out = 0;
+
+    for (int b = 0; b < 2; b++) {
+        for (int i = 0; i < N_FRAMES; i++) {
+            rows[i] = AMPLITUDE;
+        }
+        n_out = exg_decim_process(&dec, rows, N_FRAMES, N_FRAMES);
+    }
+    zassert_within(rows[n_out - 1], AMPLITUDE, AMPLITUDE / 1000, "DC gain off, got %d",
+                   rows[n_out - 1]);
+}
+
+ZTEST(exg_decim, test_passband)
+{
+    /* 0.3 of the output rate */
+    int32_t peak = output_peak(75.0f);
+    zassert_within(peak, AMPLITUDE, AMPLITUDE / 50, "75 Hz changed to %d", peak);
+}
+
+ZTEST(exg_decim, test_aliases_rejected)
+{
+    /* Would alias to 10 Hz, 50 Hz and 1000 Hz at the intermediate rates */
+    const float tones[] = {260.0f, 200.0f, 3000.0f};
+
+    for (int t = 0; t < ARRAY_SIZE(tones); t++) {
+        before(NULL);
+        /* At least 50 dB */
+        int32_t peak = output_peak(tones[t]);
+        zassert_true(peak < AMPLITUDE / 316, "%d Hz leaks through at %d", (int)tones[t], peak);
+    }
+}
+
+ZTEST(exg_decim, test_blocks_split)
+{
+    static int32_t whole[N_FRAMES];
+    uint32_t n_whole;
+    uint32_t n_split;
+
+    fill_sine(rows, 20.0f);
+    n_whole = exg_decim_process(&dec, rows, N_FRAMES, N_FRAMES);
+    memcpy(whole, rows, n_whole * sizeof(int32_t));
+
+    /* Uneven blocks, the phase carries over */
+    before(NULL);
+    fill_sine(rows, 20.0f);
+    n_split = exg_decim_process(&dec, rows, 333, N_FRAMES);
+    n_split += exg_decim_process(&dec, &rows[333], N_FRAMES - 333, N_FRAMES);
+
+    zassert_equal(n_whole, N_FRAMES / (FS_IN_HZ / FS_OUT_HZ), "Got %u outputs", n_whole);
+    zassert_equal(n_split, n_whole, "Split blocks gave %u outputs", n_split);
+
+    /* The second call wrote its outputs from rows[333] */
+    uint32_t first = 333 / (FS_IN_HZ / FS_OUT_HZ);
+    zassert_mem_equal(rows, whole, first * sizeof(int32_t), "First block differs");
+    zassert_mem_equal(&rows[333], &whole[first], (n_whole - first) * sizeof(int32_t),
+                      "Second block differs");
+}
+
+ZTEST(exg_decim, test_rate_change)
+{
+    zassert_ok(exg_decim_init(&dec, N_CHANNELS, FS_IN_HZ, 1000), "Init failed");
+    fill_sine(rows, 20.0f);
+    zassert_equal(exg_decim_process(&dec, rows, N_FRAMES, N_FRAMES), N_FRAMES / 8, "1000 SPS");
+
+    zassert_ok(exg_decim_init(&dec, N_CHANNELS, FS_IN_HZ, FS_IN_HZ), "Init failed");
+    zassert_equal(exg_decim_process(&dec, rows, N_FRAMES, N_FRAMES), N_FRAMES, "Ratio 1");
+}
+
+ZTEST(exg_decim, test_invalid_rates)
+{
+    zassert_equal(exg_decim_init(&dec, N_CHANNELS, FS_IN_HZ, 300), -EINVAL, "Not a divisor");
+    zassert_equal(exg_decim_init(&dec, N_CHANNELS, 24000, 1000), -EINVAL, "Not a power of two");
+    zassert_ok(exg_decim_init(&dec, N_CHANNELS, 32000, 250), "128x");
+    zassert_equal(exg_decim_init(&dec, N_CHANNELS, 32000, 125), -EINVAL, "256x");
+    zassert_equal(exg_decim_init(&dec, EXG_MAX_CHANNELS + 1, FS_IN_HZ, FS_OUT_HZ), -EINVAL,
+                  "Too many channels");
+}
+
+ZTEST(exg_decim, test_benchmark)
+{
+    for (int ch = 0; ch < N_CHANNELS; ch++) {
+        fill_sine(&rows[ch * N_FRAMES], 20.0f);
+    }
+
+    uint32_t start = k_cycle_get_32();
+    exg_decim_process(&dec, rows, N_FRAMES, N_FRAMES);
+    uint32_t cycles = k_cycle_get_32() - start;
+
+    TC_PRINT("%u cycles per input sample, %u cycles/s for %d channels at %d SPS\n",
+             cycles / (N_CHANNELS * N_FRAMES), cycles, N_CHANNELS, FS_IN_HZ);
+}
+
+ZTEST_SUITE(exg_decim, NULL, NULL, before, NULL, NULL);
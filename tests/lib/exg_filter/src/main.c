@@ -0,0 +1,131 @@
+/*
+ * @file test exg_filter library
+ *
+ * Checks the default notch and high-pass response on sine inputs and reports
+ * the CPU load of 8 channels at 2 kSPS.
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <zephyr/ztest.h>
+#include <zephyr/kernel.h>
+
+#include <app/lib/exg_filter.h>
+
+#define FS_HZ 2000
+#define N_FRAMES 2000 /* 1 s */
+#define N_CHANNELS 8
+#define AMPLITUDE (1 << 26)
+
+static int32_t rows[N_CHANNELS * N_FRAMES];
+static struct exg_filter flt;
+
+static void fill_sine(int32_t *row, float freq_hz)
+{
+    for (int i = 0; i < N_FRAMES; i++) {
+        row[i] = (int32_t)(AMPLITUDE * sinf(2.0f * (float)M_PI * freq_hz * i / FS_HZ));
+    }
+}
+
+/* The notch (Q 30) and the high-pass both take a couple of seconds to settle. Every test
+ * frequency is a whole number of cycles per block so repeating the block is continuous. */
+#define SETTLE_BLOCKS 3
+
+static int32_t settled_peak(float freq_hz)
+{
+    int32_t peak = 0;
+
+    for (int b = 0; b < SETTLE_BLOCKS; b++) {
+        fill_sine(rows, freq_hz);
+        exg_filter_process(&flt, rows, N_FRAMES, N_FRAMES);
+    }
+    for (int i = 0; i < N_FRAMES; i++) {
+        peak = MAX(peak, abs(rows[i]));
+    }
+    return peak;
+}
+
+static void before(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    zassert_ok(exg_filter_init_default(&flt, N_CHANNELS, FS_HZ, 50), "Init failed");
+}
+
+ZTEST(exg_filter, test_notch_rejects_mains)
+{
+    /* At least 40 dB */
+    int32_t peak = settled_peak(50.0f);
+    zassert_true(peak < AMPLITUDE / 100, "50 Hz only attenuated to %d", peak);
+}
+
+ZTEST(exg_filter, test_passband)
+{
+    /* Within 0.5 dB */
+    int32_t peak = settled_peak(10.0f);
+    zassert_within(peak, AMPLITUDE, AMPLITUDE / 16, "10 Hz changed to %d", peak);
+}
+
+ZTEST(exg_filter, test_highpass_removes_offset)
+{
+    /* 0.5 Hz needs a few seconds to settle */
+    for (int s = 0; s < 10; s++) {
+        for (int i = 0; i < N_FRAMES; i++) {
+            rows[i] = AMPLITUDE;
+        }
+        exg_filter_process(&flt, rows, N_FRAMES, N_FRAMES);
+    }
+
+    zassert_true(abs(rows[N_FRAMES - 1]) < AMPLITUDE / 1000, "Offset left at %d", rows[N_FRAMES - 1]);
+}
+
+ZTEST(exg_filter, test_channels_independent_and_blocks_split)
+{
+    static int32_t single[N_FRAMES];
+
+    /* Channel 0 sees 50 Hz, channel 1 10 Hz, processed in two uneven blocks */
+    fill_sine(&rows[0], 50.0f);
+    fill_sine(&rows[N_FRAMES], 10.0f);
+    fill_sine(single, 10.0f);
+
+    exg_filter_process(&flt, rows, 300, N_FRAMES);
+    exg_filter_process(&flt, &rows[300], N_FRAMES - 300, N_FRAMES);
+
+    struct exg_filter ref;
+    zassert_ok(exg_filter_init_default(&ref, 1, FS_HZ, 50), "Init failed");
+    exg_filter_process(&ref, single, N_FRAMES, N_FRAMES);
+
+    zassert_mem_equal(&rows[N_FRAMES], single, sizeof(single), "Channel 1 depends on channel 0");
+}
+
+ZTEST(exg_filter, test_invalid_config)
+{
+    q31_t coeffs[EXG_FILTER_STAGE_COEFFS * (CONFIG_EXG_FILTER_MAX_STAGES + 1)] = {0};
+
+    zassert_equal(exg_filter_init_default(&flt, N_CHANNELS, FS_HZ, 55), -EINVAL, "Mains 55 Hz");
+    zassert_equal(exg_filter_init(&flt, EXG_MAX_CHANNELS + 1, coeffs, 1, 0), -EINVAL,
+                  "Too many channels");
+    zassert_equal(exg_filter_init(&flt, 1, coeffs, CONFIG_EXG_FILTER_MAX_STAGES + 1, 0), -EINVAL,
+                  "Too many stages");
+    zassert_equal(exg_filter_design_notch(coeffs, 100, 50.0f, 30.0f), -EINVAL, "Notch at Nyquist");
+}
+
+ZTEST(exg_filter, test_cpu_load)
+{
+    for (int ch = 0; ch < N_CHANNELS; ch++) {
+        fill_sine(&rows[ch * N_FRAMES], 10.0f);
+    }
+
+    uint32_t start = k_cycle_get_32();
+    exg_filter_process(&flt, rows, N_FRAMES, N_FRAMES);
+    uint32_t cycles = k_cycle_get_32() - start;
+
+    /* N_FRAMES is one second of data */
+    uint32_t permille = (uint32_t)(((uint64_t)cycles * 1000) / sys_clock_hw_cycles_per_sec());
+
+    TC_PRINT("%d channels at %d SPS: %u cycles/s, %u.%u%% CPU\n", N_CHANNELS, FS_HZ, cycles,
+             permille / 10, permille % 10);
+    zassert_true(permille < 100, "Filter needs %u.%u%% CPU", permille / 10, permille % 10);
+}
+
+ZTEST_SUITE(exg_filter, NULL, NULL, before, NULL, NULL);
@@ -0,0 +1,4 @@
+#!/bin/bash
+
+# On db1 the CPU share of the notch and high-pass for 8 channels at 2 kSPS
+exec "$(dirname "$0")/../test.sh" "$@"
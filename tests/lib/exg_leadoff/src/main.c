@@ -0,0 +1,227 @@
+/*
+ * @file test exg_leadoff library
+ *
+ * Feeds frames with lead-off bits set in their status words through the
+ * debouncer, and a synthetic fs / 4 excitation tone through the impedance
+ * estimator, and compares the events and resistances with what was put in.
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+#include <zephyr/ztest.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+
+#include <app/lib/exg_leadoff.h>
+
+#define FRAME_BYTES 27
+#define DEVICES 2
+#define N_FRAMES 1000
+#define MAX_EVENTS 8
+#define FS_HZ 500
+#define SECONDS 2
+#define BLOCK 37 /* Deliberately not a divisor of anything */
+
+/* 1 V in q31 volts with shift 2 */
+#define VOLT (1 << 29)
+
+static uint8_t frames[N_FRAMES][DEVICES * FRAME_BYTES];
+static int32_t rows[EXG_MAX_CHANNELS][FS_HZ * SECONDS];
+static struct exg_leadoff lo;
+static struct exg_impedance imp;
+static struct exg_leadoff_event events[MAX_EVENTS];
+
+static void set_status(uint8_t *frame, uint8_t device, uint8_t statp, uint8_t statn)
+{
+    sys_put_be24(0xC00000 | (statp << 12) | (statn << 4), &frame[device * FRAME_BYTES]);
+}
+
+ZTEST(exg_leadoff, test_status_word)
+{
+    uint8_t frame[DEVICES * FRAME_BYTES] = {0};
+
+    set_status(frame, 0, 0x81, 0x02);
+    set_status(frame, 1, 0x00, 0x40);
+
+    uint32_t mask = exg_leadoff_status(frame, DEVICES);
+
+    zassert_equal(mask, BIT(EXG_LEADOFF_P(0)) | BIT(EXG_LEADOFF_P(7)) | BIT(EXG_LEADOFF_N(1)) |
+                            BIT(EXG_LEADOFF_N(14)),
+                  "Mask 0x%08x", mask);
+    zassert_equal(exg_leadoff_status(frame, 1), 0x0281, "Second device read");
+}
+
+ZTEST(exg_leadoff, test_glitch_ignored)
+{
+    const uint32_t off = BIT(EXG_LEADOFF_P(3));
+
+    exg_leadoff_init(&lo, 10);
+
+    /* Twice just short of the debounce, the count must start again in between */
+    for (int round = 0; round < 2; round++) {
+        for (int i = 0; i < 9; i++) {
+            zassert_equal(exg_leadoff_update(&lo, off, i, events, MAX_EVENTS), 0, "Event");
+        }
+        zassert_equal(exg_leadoff_update(&lo, 0, 9, events, MAX_EVENTS), 0, "Event");
+    }
+    zassert_equal(exg_leadoff_state(&lo), 0, "State changed");
+
+    for (int i = 0; i < 9; i++) {
+        exg_leadoff_update(&lo, off, i, events, MAX_EVENTS);
+    }
+    zassert_equal(exg_leadoff_update(&lo, off, 42, events, MAX_EVENTS), 1, "No event");
+    zassert_equal(events[0].index, 42, "Index");
+    zassert_equal(events[0].input, EXG_LEADOFF_P(3), "Input");
+    zassert_true(events[0].off, "Not off");
+    zassert_equal(exg_leadoff_state(&lo), off, "State");
+}
+
+ZTEST(exg_leadoff, test_events_full)
+{
+    const uint32_t off = BIT(EXG_LEADOFF_P(1)) | BIT(EXG_LEADOFF_N(5));
+
+    exg_leadoff_init(&lo, 1);
+
+    /* Room for one of the two, the other must not change state unreported */
+    zassert_equal(exg_leadoff_update(&lo, off, 0, events, 1), 1, "Events");
+    zassert_equal(events[0].input, EXG_LEADOFF_P(1), "Input");
+    zassert_equal(exg_leadoff_state(&lo), BIT(EXG_LEADOFF_P(1)), "State 0x%08x",
+                  exg_leadoff_state(&lo));
+    zassert_equal(exg_leadoff_update(&lo, off, 1, events, 0), 0, "Events");
+
+    zassert_equal(exg_leadoff_update(&lo, off, 2, events, MAX_EVENTS), 1, "Events");
+    zassert_equal(events[0].input, EXG_LEADOFF_N(5), "Input");
+    zassert_equal(events[0].index, 2, "Index");
+    zassert_equal(exg_leadoff_state(&lo), off, "State");
+}
+
+ZTEST(exg_leadoff, test_process_frames)
+{
+    const uint16_t debounce = 50;
+    const uint8_t input = EXG_LEADOFF_N(10);
+    uint32_t n;
+
+    /* Channel 11, the third of the second device, loses its N electrode from frame 100 to
+     * 399 with a short bounce at 200 */
+    memset(frames, 0, sizeof(frames));
+    for (int f = 0; f < N_FRAMES; f++) {
+        set_status(frames[f], 0, 0, 0);
+        set_status(frames[f], 1, 0, f >= 100 && f < 400 && (f < 200 || f > 205) ? BIT(2) : 0);
+    }
+
+    exg_leadoff_init(&lo, debounce);
+
+    /* Split into blocks, indexes are relative to each block */
+    uint32_t found = 0;
+    uint32_t index[2];
+    for (uint32_t f = 0; f < N_FRAMES; f += BLOCK) {
+        uint32_t len = MIN(BLOCK, N_FRAMES - f);
+
+        n = exg_leadoff_process(&lo, frames[f], len, DEVICES, events, MAX_EVENTS);
+        for (uint32_t e = 0; e < n; e++) {
+            zassert_true(found < 2, "Too many events");
+            zassert_equal(events[e].input, input, "Input %u", events[e].input);
+            zassert_equal(events[e].off, found == 0, "Direction");
+            index[found++] = f + events[e].index;
+        }
+    }
+
+    zassert_equal(found, 2, "%u events", found);
+    zassert_equal(index[0], 100 + debounce - 1, "Off at %u", index[0]);
+    zassert_equal(index[1], 400 + debounce - 1, "On at %u", index[1]);
+    zassert_equal(exg_leadoff_state(&lo), 0, "Still off");
+}
+
+ZTEST(exg_leadoff, test_impedance)
+{
+    const uint32_t current_na = 6;
+    const uint32_t n = FS_HZ * SECONDS;
+
+    zassert_ok(exg_impedance_init(&imp, EXG_MAX_CHANNELS, FS_HZ, current_na), "Init failed");
+
+    /* Channel ch has (ch + 1) * 100 kOhm, an arbitrary phase, an offset and 50 Hz on top */
+    for (int ch = 0; ch < EXG_MAX_CHANNELS; ch++) {
+        float amp_v = (ch + 1) * 100e3f * current_na * 1e-9f;
+
+        for (uint32_t k = 0; k < n; k++) {
+            float v = amp_v * sinf((float)M_PI / 2 * k + 0.3f * ch) + 0.1f +
+                      1e-3f * sinf(2 * (float)M_PI * 50 * k / FS_HZ);
+
+            rows[ch][k] = (int32_t)(v * VOLT);
+        }
+    }
+
+    uint32_t windows = 0;
+    for (uint32_t k = 0; k < n; k += BLOCK) {
+        int32_t block[EXG_MAX_CHANNELS][BLOCK];
+        uint32_t len = MIN(BLOCK, n - k);
+
+        for (int ch = 0; ch < EXG_MAX_CHANNELS; ch++) {
+            memcpy(block[ch], &rows[ch][k], len * sizeof(int32_t));
+        }
+        windows += exg_impedance_process(&imp, &block[0][0], len, BLOCK);
+    }
+    zassert_true(windows >= SECONDS * 5 - 1, "%u windows", windows);
+
+    for (int ch = 0; ch < EXG_MAX_CHANNELS; ch++) {
+        uint32_t expect = (ch + 1) * 100000;
+
+        zassert_within(exg_impedance_ohms(&imp, ch), expect, expect / 100, "Channel %d %u ohms",
+                       ch, exg_impedance_ohms(&imp, ch));
+    }
+
+    uint32_t mask = exg_impedance_mask(&imp, 1450000);
+    zassert_equal(mask, BIT(EXG_LEADOFF_P(14)) | BIT(EXG_LEADOFF_N(14)) |
+                            BIT(EXG_LEADOFF_P(15)) | BIT(EXG_LEADOFF_N(15)),
+                  "Mask 0x%08x", mask);
+}
+
+ZTEST(exg_leadoff, test_impedance_window)
+{
+    static const uint32_t rates[] = {250, 500, 1000, 2000, 4000, 8000};
+
+    /* Whole periods of the excitation and of 50 and 60 Hz mains at every ADS1298 rate */
+    for (int i = 0; i < ARRAY_SIZE(rates); i++) {
+        zassert_ok(exg_impedance_init(&imp, 8, rates[i], 6), "Init failed");
+        zassert_equal(imp.window % 4, 0, "%u SPS", rates[i]);
+        zassert_equal(imp.window * 50 % rates[i], 0, "%u SPS 50 Hz", rates[i]);
+        zassert_equal(imp.window * 60 % rates[i], 0, "%u SPS 60 Hz", rates[i]);
+        zassert_true(imp.window * 5 >= rates[i], "%u SPS window %u", rates[i], imp.window);
+    }
+    zassert_ok(exg_impedance_init(&imp, 8, 250, 6), "Init failed");
+    zassert_equal(imp.window, 100, "Window %u", imp.window);
+}
+
+ZTEST(exg_leadoff, test_impedance_invalid)
+{
+    zassert_equal(exg_impedance_init(&imp, EXG_MAX_CHANNELS + 1, FS_HZ, 6), -EINVAL, "Channels");
+    zassert_equal(exg_impedance_init(&imp, 8, 10, 6), -EINVAL, "Rate");
+    zassert_equal(exg_impedance_init(&imp, 8, FS_HZ, 0), -EINVAL, "Current");
+}
+
+ZTEST(exg_leadoff, test_benchmark)
+{
+    memset(frames, 0, sizeof(frames));
+    for (int f = 0; f < N_FRAMES; f++) {
+        set_status(frames[f], 0, 0, 0);
+        set_status(frames[f], 1, 0, 0);
+    }
+    exg_leadoff_init(&lo, 50);
+
+    uint32_t start = k_cycle_get_32();
+    exg_leadoff_process(&lo, frames[0], N_FRAMES, DEVICES, events, MAX_EVENTS);
+    uint32_t cycles = k_cycle_get_32() - start;
+
+    TC_PRINT("lead-off: %u cycles per frame\n", cycles / N_FRAMES);
+
+    exg_impedance_init(&imp, EXG_MAX_CHANNELS, FS_HZ, 6);
+    start = k_cycle_get_32();
+    exg_impedance_process(&imp, &rows[0][0], FS_HZ * SECONDS, FS_HZ * SECONDS);
+    cycles = k_cycle_get_32() - start;
+
+    TC_PRINT("impedance: %u cycles per sample\n",
+             cycles / (FS_HZ * SECONDS * EXG_MAX_CHANNELS));
+}
+
+ZTEST_SUITE(exg_leadoff, NULL, NULL, NULL, NULL, NULL);
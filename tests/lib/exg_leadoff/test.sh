@@ -0,0 +1,5 @@
+#!/bin/bash
+
+# On db1 the debouncer's cycles per frame and the impedance estimator's
+# cycles per sample
+exec "$(dirname "$0")/../test.sh" "$@"
@@ -0,0 +1,79 @@
+/*
+ * @file test exg_leads library
+ *
+ * Derives the limb leads from random leads I and II and checks Einthoven's
+ * law and the Goldberger relations on the output, then saturation at the
+ * ends of the range.
+ */
+
+#include <stdlib.h>
+#include <zephyr/ztest.h>
+#include <zephyr/kernel.h>
+
+#include <app/lib/exg_leads.h>
+
+#define N 500
+#define STRIDE 512
+
+/* Acquired channels followed by the derived leads, as a consumer would lay them out */
+static int32_t rows[8 + EXG_LEADS_DERIVED][STRIDE];
+
+static int32_t *derived(enum exg_leads_derived lead)
+{
+    return rows[8 + lead];
+}
+
+ZTEST(exg_leads, test_relations)
+{
+    srand(1);
+    for (int k = 0; k < N; k++) {
+        /* About +-10 mV in q31 volts */
+        rows[EXG_LEADS_I_CHANNEL][k] = (rand() % 10000000) - 5000000;
+        rows[EXG_LEADS_II_CHANNEL][k] = (rand() % 10000000) - 5000000;
+    }
+
+    exg_leads_derive(rows[EXG_LEADS_I_CHANNEL], rows[EXG_LEADS_II_CHANNEL], rows[8], STRIDE, N);
+
+    for (int k = 0; k < N; k++) {
+        int32_t i = rows[EXG_LEADS_I_CHANNEL][k];
+        int32_t ii = rows[EXG_LEADS_II_CHANNEL][k];
+
+        zassert_equal(i + derived(EXG_LEAD_III)[k], ii, "I + III != II at %d", k);
+        zassert_within(derived(EXG_LEAD_AVR)[k], -(i + ii) / 2, 1, "aVR at %d", k);
+        zassert_within(derived(EXG_LEAD_AVL)[k], i - ii / 2, 1, "aVL at %d", k);
+        zassert_within(derived(EXG_LEAD_AVF)[k], ii - i / 2, 1, "aVF at %d", k);
+        /* The augmented leads sum to zero */
+        zassert_within(derived(EXG_LEAD_AVR)[k] + derived(EXG_LEAD_AVL)[k] +
+                           derived(EXG_LEAD_AVF)[k],
+                       0, 2, "aVR + aVL + aVF at %d", k);
+    }
+    /* Nothing past n written */
+    zassert_equal(derived(EXG_LEAD_III)[N], 0, "Overrun");
+}
+
+ZTEST(exg_leads, test_saturation)
+{
+    const int32_t i[] = {INT32_MAX, INT32_MIN, INT32_MIN, INT32_MAX};
+    const int32_t ii[] = {INT32_MIN, INT32_MAX, INT32_MIN, INT32_MAX};
+    int32_t out[EXG_LEADS_DERIVED][ARRAY_SIZE(i)];
+
+    exg_leads_derive(i, ii, &out[0][0], ARRAY_SIZE(i), ARRAY_SIZE(i));
+
+    zassert_equal(out[EXG_LEAD_III][0], INT32_MIN, "III");
+    zassert_equal(out[EXG_LEAD_III][1], INT32_MAX, "III");
+    zassert_equal(out[EXG_LEAD_AVR][2], INT32_MAX, "aVR");
+    zassert_equal(out[EXG_LEAD_AVL][0], INT32_MAX, "aVL");
+    zassert_equal(out[EXG_LEAD_AVF][1], INT32_MAX, "aVF");
+    zassert_equal(out[EXG_LEAD_AVF][0], INT32_MIN, "aVF");
+}
+
+ZTEST(exg_leads, test_benchmark)
+{
+    uint32_t start = k_cycle_get_32();
+    exg_leads_derive(rows[EXG_LEADS_I_CHANNEL], rows[EXG_LEADS_II_CHANNEL], rows[8], STRIDE, N);
+    uint32_t cycles = k_cycle_get_32() - start;
+
+    TC_PRINT("%u cycles per sample for all four leads\n", cycles / N);
+}
+
+ZTEST_SUITE(exg_leads, NULL, NULL, NULL, NULL, NULL);
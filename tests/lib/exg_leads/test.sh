@@ -0,0 +1,4 @@
+#!/bin/bash
+
+# On db1 the cycles per sample to derive all four limb leads
+exec "$(dirname "$0")/../test.sh" "$@"
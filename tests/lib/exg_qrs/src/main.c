@@ -0,0 +1,170 @@
+/*
+ * @file test exg_qrs library
+ *
+ * Runs the detector over synthetic ECG: Gaussian P, QRS and T waves with
+ * baseline wander and mains interference, and compares the beats with the
+ * R-peaks that were put in.
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr/ztest.h>
+#include <zephyr/kernel.h>
+
+#include <app/lib/exg_qrs.h>
+
+#define MAX_FS_HZ 1000
+#define SECONDS 20
+#define BLOCK 37 /* Deliberately not a divisor of anything */
+#define MAX_BEATS 64
+
+/* 1 mV in q31 volts with shift 2 */
+#define MV ((1 << 29) / 1000)
+
+static int32_t ecg[MAX_FS_HZ * SECONDS];
+static struct exg_qrs qrs;
+static struct exg_qrs_beat beats[MAX_BEATS];
+
+static float gauss(float t, float centre, float width)
+{
+    float x = (t - centre) / width;
+
+    return expf(-0.5f * x * x);
+}
+
+/* R-peaks every rr_s from 0.5 s. weak is the index of a beat with a third of the usual
+ * QRS amplitude, or -1. */
+static void make_ecg(uint32_t fs_hz, float rr_s, float t_wave_mv, int weak)
+{
+    for (int i = 0; i < fs_hz * SECONDS; i++) {
+        float t = (float)i / fs_hz;
+        float v = 0.3f * sinf(2.0f * (float)M_PI * 0.3f * t) +     /* Wander */
+                  0.05f * sinf(2.0f * (float)M_PI * 50.0f * t);    /* Mains */
+        int beat = (int)((t - 0.5f) / rr_s + 0.5f);
+        float r_t = 0.5f + beat * rr_s;
+
+        float qrs_mv = (beat == weak) ? 0.33f : 1.0f;
+
+        if (t > 0.2f) {
+            v += 0.15f * gauss(t, r_t - 0.16f, 0.02f) +                /* P */
+                 qrs_mv * (-0.1f * gauss(t, r_t - 0.02f, 0.006f) +     /* Q */
+                           1.0f * gauss(t, r_t, 0.008f) +              /* R */
+                           -0.2f * gauss(t, r_t + 0.025f, 0.008f)) +   /* S */
+                 t_wave_mv * gauss(t, r_t + 0.25f, 0.05f);             /* T */
+        }
+        ecg[i] = (int32_t)(v * MV);
+    }
+}
+
+/* Feeds the whole record in odd sized blocks, timestamps in ns from the first sample */
+static int run(uint32_t fs_hz)
+{
+    const int64_t period_ns = 1000000000LL / fs_hz;
+    int n_beats = 0;
+
+    zassert_ok(exg_qrs_init(&qrs, fs_hz), "Init failed");
+
+    for (int i = 0; i < fs_hz * SECONDS; i += BLOCK) {
+        uint32_t n = MIN(BLOCK, fs_hz * SECONDS - i);
+
+        n_beats += exg_qrs_process(&qrs, &ecg[i], n, i * period_ns, &beats[n_beats],
+                                   MAX_BEATS - n_beats);
+    }
+    return n_beats;
+}
+
+/* Beats after the 2 s learning period must all be found, on time and with the right RR */
+static void check_beats(int n_found, float rr_s)
+{
+    int expected = 0;
+    int k = 0;
+
+    for (int b = 0; 0.5f + b * rr_s < SECONDS - 1.0f; b++) {
+        float r_t = 0.5f + b * rr_s;
+
+        if (r_t < 2.0f) {
+            continue;
+        }
+        expected++;
+
+        /* Find the reported beat closest to this one */
+        while (k < n_found && beats[k].timestamp_ns < (int64_t)((r_t - 0.1f) * 1e9f)) {
+            k++;
+        }
+        zassert_true(k < n_found, "Beat at %d ms not found", (int)(r_t * 1000));
+        int64_t err_ms = (beats[k].timestamp_ns - (int64_t)(r_t * 1e9f)) / 1000000;
+        zassert_true(llabs(err_ms) <= 15, "Beat at %d ms reported %d ms off",
+                     (int)(r_t * 1000), (int)err_ms);
+    }
+
+    /* Nothing extra, e.g. T-waves, over the same span */
+    int n_span = 0;
+
+    for (k = 0; k < n_found; k++) {
+        if (beats[k].timestamp_ns >= 1900000000LL &&
+            beats[k].timestamp_ns < (SECONDS - 1) * 1000000000LL) {
+            n_span++;
+        }
+    }
+    zassert_equal(n_span, expected, "Expected %d beats, found %d", expected, n_span);
+}
+
+ZTEST(exg_qrs, test_normal_rhythm)
+{
+    const uint32_t rates[] = {250, 500, 1000};
+
+    for (int r = 0; r < ARRAY_SIZE(rates); r++) {
+        make_ecg(rates[r], 0.8f, 0.3f, -1);
+        int n = run(rates[r]);
+
+        TC_PRINT("%u SPS: %d beats, %u bpm\n", rates[r], n, exg_qrs_heart_rate_bpm(&qrs));
+        check_beats(n, 0.8f);
+        zassert_within(exg_qrs_heart_rate_bpm(&qrs), 75, 1, "Heart rate");
+        for (int b = 1; b < n; b++) {
+            zassert_within(beats[b].rr_ms, 800, 8, "RR %d is %u ms", b, beats[b].rr_ms);
+        }
+    }
+}
+
+ZTEST(exg_qrs, test_tachycardia_tall_t_waves)
+{
+    /* 150 bpm with T-waves half the height of the R-wave */
+    make_ecg(500, 0.4f, 0.5f, -1);
+    check_beats(run(500), 0.4f);
+}
+
+ZTEST(exg_qrs, test_search_back_finds_weak_beat)
+{
+    /* Below the main threshold, found by searching back once the next beat is overdue */
+    make_ecg(500, 0.8f, 0.3f, 10);
+    check_beats(run(500), 0.8f);
+}
+
+ZTEST(exg_qrs, test_flat_line)
+{
+    memset(ecg, 0, sizeof(ecg));
+    zassert_equal(run(500), 0, "Beats in a flat line");
+    zassert_equal(exg_qrs_heart_rate_bpm(&qrs), 0, "Heart rate without beats");
+}
+
+ZTEST(exg_qrs, test_invalid_rate)
+{
+    zassert_equal(exg_qrs_init(&qrs, 50), -EINVAL, "Too slow");
+    zassert_equal(exg_qrs_init(&qrs, EXG_QRS_MAX_FS_HZ + 1), -EINVAL, "Too fast");
+}
+
+ZTEST(exg_qrs, test_benchmark)
+{
+    make_ecg(500, 0.8f, 0.3f, -1);
+    zassert_ok(exg_qrs_init(&qrs, 500), "Init failed");
+
+    uint32_t start = k_cycle_get_32();
+    exg_qrs_process(&qrs, ecg, 500 * SECONDS, 0, beats, MAX_BEATS);
+    uint32_t cycles = k_cycle_get_32() - start;
+
+    TC_PRINT("%u cycles per sample\n", cycles / (500 * SECONDS));
+}
+
+ZTEST_SUITE(exg_qrs, NULL, NULL, NULL, NULL, NULL);
@@ -0,0 +1,5 @@
+#!/bin/bash
+
+# Beats and heart rate are checked at every rate, on db1 the cycles per
+# sample at 500 SPS are the budget
+exec "$(dirname "$0")/../test.sh" "$@"
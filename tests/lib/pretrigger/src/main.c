@@ -0,0 +1,203 @@
+/*
+ * @file test pretrigger library
+ *
+ * Two streams as audio.c and the ExG pipeline would write them, 4 ms audio
+ * blocks of 128 bytes and 1 kSPS ExG frames, timestamped in microseconds.
+ * Checks that nothing is sent until a trigger, that each window comes out
+ * exactly once and in order, that overlapping triggers merge and that a
+ * later window waits for an earlier one to drain.
+ */
+
+#include <string.h>
+#include <zephyr/ztest.h>
+#include <zephyr/kernel.h>
+
+#include <app/lib/pretrigger.h>
+
+#define US_PER_S 1000000
+#define AUDIO_BLOCK_US 4000
+#define AUDIO_BLOCK_BYTES 128
+#define EXG_FRAME_US 1000
+#define EXG_FRAME_BYTES 27
+#define PRE_US (2 * US_PER_S)
+#define POST_US (1 * US_PER_S)
+
+struct received {
+    uint32_t count;
+    uint64_t first;
+    uint64_t last;
+    uint32_t out_of_order;
+    uint32_t corrupt;
+};
+
+static struct received audio_rx;
+static struct received exg_rx;
+
+/* Every record carries its own timestamp in its first bytes */
+static void sink(const void *record, uint64_t timestamp, void *user_data)
+{
+    struct received *rx = user_data;
+    uint64_t stamped;
+
+    memcpy(&stamped, record, sizeof(stamped));
+    if (stamped != timestamp) {
+        rx->corrupt++;
+    }
+    if (rx->count > 0 && timestamp <= rx->last) {
+        rx->out_of_order++;
+    }
+    if (rx->count == 0) {
+        rx->first = timestamp;
+    }
+    rx->last = timestamp;
+    rx->count++;
+}
+
+/* 4 s of audio, 4 s of ExG */
+PRETRIGGER_RING_DEFINE(audio_ring, AUDIO_BLOCK_BYTES, 1024, sink, &audio_rx);
+PRETRIGGER_RING_DEFINE(exg_ring, EXG_FRAME_BYTES, 4096, sink, &exg_rx);
+
+static uint64_t now;
+
+/* Both streams up to @p until microseconds */
+static void run_until(uint64_t until)
+{
+    uint8_t block[AUDIO_BLOCK_BYTES];
+    uint8_t frame[EXG_FRAME_BYTES];
+
+    for (; now < until; now += EXG_FRAME_US) {
+        memcpy(frame, &now, sizeof(now));
+        pretrigger_write(&exg_ring, frame, now);
+        if (now % AUDIO_BLOCK_US == 0) {
+            memcpy(block, &now, sizeof(now));
+            pretrigger_write(&audio_ring, block, now);
+        }
+    }
+}
+
+static void before(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    memset(&audio_rx, 0, sizeof(audio_rx));
+    memset(&exg_rx, 0, sizeof(exg_rx));
+    audio_ring.short_windows = 0;
+    exg_ring.short_windows = 0;
+    pretrigger_register(&audio_ring);
+    pretrigger_register(&exg_ring);
+}
+
+static void after(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    pretrigger_unregister(&audio_ring);
+    pretrigger_unregister(&exg_ring);
+}
+
+static void check_window(const struct received *rx, uint64_t first, uint64_t last, uint32_t period)
+{
+    zassert_equal(rx->corrupt, 0, "Corrupt records");
+    zassert_equal(rx->out_of_order, 0, "Out of order");
+    zassert_equal(rx->first, first, "First %u us", (uint32_t)rx->first);
+    zassert_equal(rx->last, last, "Last %u us", (uint32_t)rx->last);
+    zassert_equal(rx->count, (last - first) / period + 1, "%u records", rx->count);
+}
+
+ZTEST(pretrigger, test_steady_state)
+{
+    run_until(now + 10 * US_PER_S);
+    zassert_equal(audio_rx.count + exg_rx.count, 0, "Records sent without a trigger");
+}
+
+ZTEST(pretrigger, test_window)
+{
+    run_until(now + 10 * US_PER_S);
+
+    uint64_t event = now - 1500;
+
+    pretrigger_fire(event, PRE_US, POST_US);
+    run_until(now + 5 * US_PER_S);
+
+    /* Audio blocks fall on 4 ms, the event does not */
+    check_window(&exg_rx, event - PRE_US + 500, event + POST_US - 500, EXG_FRAME_US);
+    check_window(&audio_rx, ROUND_UP(event - PRE_US, AUDIO_BLOCK_US),
+                 ROUND_DOWN(event + POST_US, AUDIO_BLOCK_US), AUDIO_BLOCK_US);
+    zassert_equal(exg_ring.short_windows, 0, "Short window");
+
+    /* Closed again */
+    uint32_t count = exg_rx.count;
+
+    run_until(now + 5 * US_PER_S);
+    zassert_equal(exg_rx.count, count, "Sent after the window");
+}
+
+ZTEST(pretrigger, test_overlapping_triggers)
+{
+    run_until(now + 10 * US_PER_S);
+
+    uint64_t first = now;
+
+    pretrigger_fire(first, PRE_US, POST_US);
+    run_until(now + US_PER_S / 2);
+    /* A second cough half a second later, inside the first window */
+    pretrigger_fire(now, PRE_US, POST_US);
+    uint64_t second = now;
+
+    run_until(now + 5 * US_PER_S);
+
+    check_window(&exg_rx, first - PRE_US, second + POST_US, EXG_FRAME_US);
+}
+
+ZTEST(pretrigger, test_separate_triggers)
+{
+    const uint64_t pre = US_PER_S / 2;
+    const uint64_t post = US_PER_S;
+
+    run_until(now + 10 * US_PER_S);
+
+    /* A slow detector reports an event 3 s back, a second one fires before any record of
+     * the first window has gone out */
+    uint64_t first = now - 3 * US_PER_S;
+    uint64_t second = now;
+
+    pretrigger_fire(first, pre, post);
+    pretrigger_fire(second, pre, post);
+    run_until(now + 5 * US_PER_S);
+
+    /* Both windows, and nothing from the gap between them */
+    zassert_equal(exg_rx.corrupt + exg_rx.out_of_order, 0, "Corrupt or out of order");
+    zassert_equal(exg_rx.first, first - pre, "First %u us", (uint32_t)exg_rx.first);
+    zassert_equal(exg_rx.last, second + post, "Last %u us", (uint32_t)exg_rx.last);
+    zassert_equal(exg_rx.count, 2 * ((pre + post) / EXG_FRAME_US + 1), "%u records",
+                  exg_rx.count);
+    zassert_equal(audio_rx.count, 2 * ((pre + post) / AUDIO_BLOCK_US + 1), "%u blocks",
+                  audio_rx.count);
+}
+
+ZTEST(pretrigger, test_short_window)
+{
+    run_until(now + 10 * US_PER_S);
+
+    /* Longer than the 4 s ExG ring holds */
+    pretrigger_fire(now, 6 * US_PER_S, 0);
+    run_until(now + US_PER_S);
+
+    zassert_equal(exg_ring.short_windows, 1, "Short window not counted");
+    zassert_equal(exg_rx.count, 4096, "Whole ring not sent");
+}
+
+ZTEST(pretrigger, test_benchmark)
+{
+    uint8_t block[AUDIO_BLOCK_BYTES] = {0};
+    const uint32_t rounds = 1000;
+    uint32_t start = k_cycle_get_32();
+
+    for (uint32_t n = 0; n < rounds; n++) {
+        pretrigger_write(&audio_ring, block, now);
+        now += AUDIO_BLOCK_US;
+    }
+
+    TC_PRINT("%u cycles per %d byte block with no trigger\n",
+             (k_cycle_get_32() - start) / rounds, AUDIO_BLOCK_BYTES);
+}
+
+ZTEST_SUITE(pretrigger, NULL, NULL, before, after, NULL);
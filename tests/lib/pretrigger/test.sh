@@ -0,0 +1,5 @@
+#!/bin/bash
+
+# On db1 the cost of a write with no trigger open, the steady state for
+# every audio block
+exec "$(dirname "$0")/../test.sh" "$@"
@@ -0,0 +1,15 @@
+#!/bin/bash
+
+# Builds and runs the library test in the current directory, see README.md.
+#   ../test.sh sim    native_sim, builds and runs on the host
+#   ../test.sh        db1, builds and flashes over J-Link
+
+export ZEPHYR_SDK_INSTALL_DIR="$(dirname "$0")/../../../toolchain/tc/"
+
+if [ "$1" == "sim" ]; then
+  west build -b native_sim
+  west build -t run
+else
+  west build -b db1/mcxn947/cpu0
+  west flash --runner=jlink
+fi